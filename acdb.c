@@ -0,0 +1,99 @@
+/**
+ * @file acdb.c
+ * @brief Memory-mapped lookups into the offline aircraft database.
+ *
+ * Opening only maps the file, so startup cost does not grow with database size;
+ * pages are faulted in on demand. Lookups are a binary search over the mapped
+ * records (about 20 probes for a full world database) with no heap allocation.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "acdb.h"
+
+static const struct AcdbRecord* g_records = NULL;
+static uint32_t g_record_count = 0;
+static void* g_map = NULL;
+static size_t g_map_size = 0;
+
+/**
+ * @brief Maps the database at `path`. A missing file just leaves offline lookups disabled.
+ */
+bool acdb_open(const char* path) {
+    acdb_close();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct AcdbHeader)) {
+        close(fd);
+        fprintf(stderr, "WARNING: Ignoring truncated aircraft database %s\n", path);
+        return false;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "WARNING: Could not map aircraft database %s\n", path);
+        return false;
+    }
+
+    const struct AcdbHeader* header = map;
+    size_t expected = sizeof(*header) + (size_t)header->count * sizeof(struct AcdbRecord);
+    if (memcmp(header->magic, ACDB_MAGIC, 4) != 0 || header->version != ACDB_VERSION ||
+        header->record_size != sizeof(struct AcdbRecord) || expected > (size_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        fprintf(stderr, "WARNING: %s is not a compatible aircraft database, rebuild it with `make acdb`\n", path);
+        return false;
+    }
+
+    madvise(map, (size_t)st.st_size, MADV_RANDOM); // Lookups touch a handful of scattered pages
+    g_map = map;
+    g_map_size = (size_t)st.st_size;
+    g_records = (const struct AcdbRecord*)(header + 1);
+    g_record_count = header->count;
+    printf("INFO: Offline aircraft database %s: %u aircraft\n", path, g_record_count);
+    return true;
+}
+
+void acdb_close() {
+    if (g_map) munmap(g_map, g_map_size);
+    g_map = NULL;
+    g_map_size = 0;
+    g_records = NULL;
+    g_record_count = 0;
+}
+
+uint32_t acdb_count() { return g_record_count; }
+
+static void copy_field(char* dst, size_t dst_size, const char* src, size_t src_size) {
+    size_t len = strnlen(src, src_size);
+    if (len >= dst_size) len = dst_size - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ * @brief Looks up an ICAO address. Empty database fields are reported as "N/A".
+ */
+bool acdb_lookup(uint32_t icao, struct Enrichment* out) {
+    uint32_t lo = 0, hi = g_record_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (g_records[mid].icao < icao) lo = mid + 1; else hi = mid;
+    }
+    if (lo >= g_record_count || g_records[lo].icao != icao) return false;
+
+    const struct AcdbRecord* r = &g_records[lo];
+    copy_field(out->registration, sizeof(out->registration), r->registration, sizeof(r->registration));
+    copy_field(out->aircraft_type, sizeof(out->aircraft_type), r->aircraft_type, sizeof(r->aircraft_type));
+    copy_field(out->operator, sizeof(out->operator), r->operator, sizeof(r->operator));
+    if (!out->registration[0]) snprintf(out->registration, sizeof(out->registration), "N/A");
+    if (!out->aircraft_type[0]) snprintf(out->aircraft_type, sizeof(out->aircraft_type), "N/A");
+    if (!out->operator[0]) snprintf(out->operator, sizeof(out->operator), "N/A");
+    return true;
+}
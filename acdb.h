@@ -0,0 +1,45 @@
+/**
+ * @file acdb.h
+ * @brief Offline aircraft database: a sorted array of fixed-width records, memory-mapped at runtime.
+ *
+ * The file is produced at build time by `mkacdb` (see tools/mkacdb.c) from a
+ * tar1090-db or OpenSky CSV dump. Layout, in native endianness:
+ *
+ *   struct AcdbHeader, then `count` struct AcdbRecord sorted by ascending `icao`.
+ *
+ * Strings are NUL-padded and not necessarily NUL-terminated when they fill the field.
+ */
+
+#ifndef ACDB_H
+#define ACDB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aircraft.h"
+
+#define ACDB_MAGIC "CPDB"
+#define ACDB_VERSION 1u
+
+struct AcdbHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t record_size;
+};
+
+struct AcdbRecord {
+    uint32_t icao;
+    char registration[12];
+    char aircraft_type[8];
+    char operator[40];
+};
+
+_Static_assert(sizeof(struct AcdbRecord) == 64, "AcdbRecord must stay 64 bytes");
+
+bool acdb_open(const char* path);
+void acdb_close();
+bool acdb_lookup(uint32_t icao, struct Enrichment* out);
+uint32_t acdb_count();
+
+#endif // ACDB_H
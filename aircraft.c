@@ -0,0 +1,81 @@
+/**
+ * @file aircraft.c
+ * @brief Helpers for the shared aircraft record.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "aircraft.h"
+#include "config.h"
+#include "geo.h"
+#include "geo_batch.h"
+
+/**
+ * @brief Fills an aircraft record with placeholder text, e.g. "Waiting for data...".
+ */
+void aircraft_reset(struct Aircraft* ac, const char* status) {
+    memset(ac, 0, sizeof(*ac));
+    snprintf(ac->flight, sizeof(ac->flight), "%s", status);
+    snprintf(ac->operator, sizeof(ac->operator), " ");
+    snprintf(ac->registration, sizeof(ac->registration), " ");
+    snprintf(ac->aircraft_type, sizeof(ac->aircraft_type), " ");
+    snprintf(ac->hex, sizeof(ac->hex), " ");
+    snprintf(ac->squawk, sizeof(ac->squawk), " ");
+    ac->distance_km = 999999.9;
+    ac->bearing_deg = 0.0;
+}
+
+/**
+ * @brief Parses a 24-bit ICAO address such as "4ca7b5".
+ * @return false for anything else, including dump1090's "~"-prefixed non-ICAO (TIS-B) addresses.
+ */
+bool icao_from_hex(const char* hex, uint32_t* icao) {
+    uint32_t value = 0;
+    int digits = 0;
+    for (const char* p = hex; *p; p++) {
+        char c = *p;
+        uint32_t nibble;
+        if (c >= '0' && c <= '9') nibble = (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') nibble = (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') nibble = (uint32_t)(c - 'A' + 10);
+        else return false;
+        if (++digits > 6) return false;
+        value = (value << 4) | nibble;
+    }
+    if (digits == 0) return false;
+    *icao = value;
+    return true;
+}
+
+/**
+ * @brief Copies looked-up registration details into an aircraft record.
+ */
+void aircraft_apply_enrichment(struct Aircraft* ac, const struct Enrichment* info) {
+    snprintf(ac->registration, sizeof(ac->registration), "%s", info->registration);
+    snprintf(ac->aircraft_type, sizeof(ac->aircraft_type), "%s", info->aircraft_type);
+    snprintf(ac->operator, sizeof(ac->operator), "%s", info->operator);
+}
+
+/**
+ * @brief Dead-reckons an aircraft from its last fix to `now` using ground speed, track and vertical rate.
+ * Distance and bearing from the observer are recomputed. Fixes older than DEAD_RECKON_MAX_SECONDS are
+ * projected no further than that, so a lost aircraft does not fly on indefinitely.
+ */
+void aircraft_extrapolate(struct Aircraft* ac, double now, const struct Observer* obs) {
+    if (ac->position_time <= 0.0 || now <= ac->position_time) return;
+    double age = now - ac->position_time;
+    if (age > DEAD_RECKON_MAX_SECONDS) age = DEAD_RECKON_MAX_SECONDS;
+
+    if (ac->ground_speed_kts > 0.0) {
+        double travelled_km = ac->ground_speed_kts * 1.852 * age / 3600.0;
+        destination_point(ac->lat, ac->lon, ac->track_deg, travelled_km, &ac->lat, &ac->lon);
+    }
+    if (ac->altitude_ft > 0) {
+        int altitude = ac->altitude_ft + (int)(ac->vert_rate_fpm * age / 60.0);
+        ac->altitude_ft = altitude > 0 ? altitude : 0;
+    }
+    ac->position_time = now;
+    ac->distance_km = observer_distance_km(obs, ac->lat, ac->lon);
+    ac->bearing_deg = observer_bearing(obs, ac->lat, ac->lon);
+}
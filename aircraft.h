@@ -0,0 +1,35 @@
+/**
+ * @file aircraft.h
+ * @brief The aircraft record shared by the fetch worker and the display.
+ */
+
+#ifndef AIRCRAFT_H
+#define AIRCRAFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Numeric fields first: they fill the first cache line and are what the scan,
+// queries and dead reckoning read. The strings after them are only read for
+// aircraft that are displayed, published or looked up.
+struct Aircraft {
+    double lat, lon, distance_km;
+    double bearing_deg; // Bearing from user to aircraft
+    double ground_speed_kts, track_deg;
+    double position_time; // monotonic_seconds() when lat/lon were measured; 0 if unknown
+    int altitude_ft, vert_rate_fpm;
+    char flight[24], hex[10], squawk[6], registration[24], aircraft_type[24], operator[40];
+};
+
+// Registration details looked up by ICAO address; sizes match struct Aircraft.
+struct Enrichment {
+    char registration[24], aircraft_type[24], operator[40];
+};
+
+void aircraft_reset(struct Aircraft* ac, const char* status);
+bool icao_from_hex(const char* hex, uint32_t* icao);
+void aircraft_apply_enrichment(struct Aircraft* ac, const struct Enrichment* info);
+struct Observer;
+void aircraft_extrapolate(struct Aircraft* ac, double now, const struct Observer* obs);
+
+#endif // AIRCRAFT_H
@@ -0,0 +1,333 @@
+/**
+ * @file aircraft_json.c
+ * @brief SAX-style extraction of the fields we use from aircraft.json, with no allocation.
+ *
+ * cJSON_Parse builds a full DOM with one malloc per node, and each field lookup
+ * is then a linear key scan. At busy sites aircraft.json is 150-250 KB with 300+
+ * aircraft, most of it keys we never read. This walks the document once, copies
+ * the handful of keys we need straight into a caller-provided flat array and
+ * skips everything else without materialising it.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aircraft_json.h"
+
+struct Cursor {
+    const char* p;
+    const char* end;
+};
+
+static void skip_ws(struct Cursor* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\n' || *c->p == '\r' || *c->p == '\t')) c->p++;
+}
+
+static bool expect(struct Cursor* c, char ch) {
+    skip_ws(c);
+    if (c->p >= c->end || *c->p != ch) return false;
+    c->p++;
+    return true;
+}
+
+/**
+ * @brief Reads a JSON string at the cursor into `dst` (truncating), or skips it when `dst` is NULL.
+ * Escapes are decoded; \\u sequences outside ASCII become '?'.
+ */
+static bool parse_string(struct Cursor* c, char* dst, size_t dst_size) {
+    if (c->p >= c->end || *c->p != '"') return false;
+    c->p++;
+    size_t n = 0;
+    while (c->p < c->end) {
+        char ch = *c->p++;
+        if (ch == '"') {
+            if (dst) dst[n] = '\0';
+            return true;
+        }
+        if (ch == '\\') {
+            if (c->p >= c->end) return false;
+            char esc = *c->p++;
+            switch (esc) {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'r': ch = '\r'; break;
+                case 'b': ch = '\b'; break;
+                case 'f': ch = '\f'; break;
+                case 'u': {
+                    if (c->end - c->p < 4) return false;
+                    unsigned code = (unsigned)strtoul((char[5]){ c->p[0], c->p[1], c->p[2], c->p[3], 0 }, NULL, 16);
+                    ch = code < 0x80 ? (char)code : '?';
+                    c->p += 4;
+                    break;
+                }
+                default: ch = esc; break; // \" \\ \/
+            }
+        }
+        if (dst && n + 1 < dst_size) dst[n++] = ch;
+    }
+    return false;
+}
+
+/**
+ * @brief Parses a JSON number. Fast path for the short decimals dump1090 emits, strtod otherwise.
+ */
+static bool parse_number(struct Cursor* c, double* out) {
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char* start = c->p;
+    const char* p = c->p;
+    bool negative = false;
+    if (p < c->end && *p == '-') { negative = true; p++; }
+
+    uint64_t mantissa = 0;
+    int digits = 0, frac_digits = 0;
+    while (p < c->end && *p >= '0' && *p <= '9') { mantissa = mantissa * 10 + (uint64_t)(*p++ - '0'); digits++; }
+    if (p < c->end && *p == '.') {
+        p++;
+        while (p < c->end && *p >= '0' && *p <= '9') { mantissa = mantissa * 10 + (uint64_t)(*p++ - '0'); digits++; frac_digits++; }
+    }
+    if (digits == 0) return false;
+
+    if ((p < c->end && (*p == 'e' || *p == 'E')) || digits > 15) {
+        // Rare: exponent or more precision than the fast path is exact for
+        char tmp[64];
+        while (p < c->end && (*p == 'e' || *p == 'E' || *p == '+' || *p == '-' || (*p >= '0' && *p <= '9'))) p++;
+        size_t len = (size_t)(p - start);
+        if (len >= sizeof(tmp)) return false;
+        memcpy(tmp, start, len);
+        tmp[len] = '\0';
+        *out = strtod(tmp, NULL);
+    } else {
+        // Both operands are exact, so one division gives the correctly rounded result
+        double value = (double)mantissa / pow10[frac_digits];
+        *out = negative ? -value : value;
+    }
+    c->p = p;
+    return true;
+}
+
+/**
+ * @brief Skips any JSON value without decoding it.
+ */
+static bool skip_value(struct Cursor* c) {
+    skip_ws(c);
+    if (c->p >= c->end) return false;
+    char ch = *c->p;
+    if (ch == '"') return parse_string(c, NULL, 0);
+    if (ch == '{' || ch == '[') {
+        int depth = 0;
+        while (c->p < c->end) {
+            ch = *c->p;
+            if (ch == '"') {
+                if (!parse_string(c, NULL, 0)) return false;
+                continue;
+            }
+            c->p++;
+            if (ch == '{' || ch == '[') depth++;
+            else if (ch == '}' || ch == ']') {
+                if (--depth == 0) return true;
+            }
+        }
+        return false;
+    }
+    // Number or literal: run to the next delimiter
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']' &&
+           *c->p != ' ' && *c->p != '\n' && *c->p != '\r' && *c->p != '\t') c->p++;
+    return true;
+}
+
+/**
+ * @brief Reads a numeric field. Non-numeric values are skipped and read as 0, like cJSON's valuedouble.
+ */
+static bool read_numeric(struct Cursor* c, double* out, bool* is_number) {
+    skip_ws(c);
+    *out = 0.0;
+    *is_number = false;
+    if (c->p < c->end && (*c->p == '-' || (*c->p >= '0' && *c->p <= '9'))) {
+        if (!parse_number(c, out)) return false;
+        *is_number = true;
+        return true;
+    }
+    return skip_value(c);
+}
+
+static int saturate_int(double v) {
+    if (v >= 2147483647.0) return 2147483647;
+    if (v <= -2147483648.0) return (int)-2147483648.0;
+    return (int)v;
+}
+
+/**
+ * @brief Reads a string field if the value is a string; anything else is skipped.
+ */
+static bool read_string_field(struct Cursor* c, char* dst, size_t dst_size, uint32_t bit, uint32_t* present) {
+    skip_ws(c);
+    if (c->p < c->end && *c->p == '"') {
+        if (!parse_string(c, dst, dst_size)) return false;
+        *present |= bit;
+        return true;
+    }
+    return skip_value(c);
+}
+
+static bool parse_aircraft_object(struct Cursor* c, struct ParsedAircraft* ac) {
+    memset(ac, 0, sizeof(*ac));
+    if (!expect(c, '{')) return false;
+    skip_ws(c);
+    if (c->p < c->end && *c->p == '}') { c->p++; return true; }
+
+    for (;;) {
+        char key[16];
+        skip_ws(c);
+        if (!parse_string(c, key, sizeof(key)) || !expect(c, ':')) return false;
+
+        double v;
+        bool num;
+        bool ok;
+        // Dispatch on the first character to avoid a strcmp chain for every key
+        switch (key[0]) {
+            case 'h':
+                ok = strcmp(key, "hex") == 0 ? read_string_field(c, ac->hex, sizeof(ac->hex), PA_HEX, &ac->present) : skip_value(c);
+                break;
+            case 'f':
+                ok = strcmp(key, "flight") == 0 ? read_string_field(c, ac->flight, sizeof(ac->flight), PA_FLIGHT, &ac->present) : skip_value(c);
+                break;
+            case 's':
+                if (strcmp(key, "squawk") == 0) {
+                    ok = read_string_field(c, ac->squawk, sizeof(ac->squawk), PA_SQUAWK, &ac->present);
+                } else if (strcmp(key, "seen_pos") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    if (num) { ac->seen_pos_s = v; ac->present |= PA_SEEN_POS; }
+                } else if (strcmp(key, "seen") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    if (num) { ac->seen_s = v; ac->present |= PA_SEEN; }
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 'l':
+                if (strcmp(key, "lat") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    if (num) { ac->lat = v; ac->present |= PA_LAT; }
+                } else if (strcmp(key, "lon") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    if (num) { ac->lon = v; ac->present |= PA_LON; }
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 'm':
+                if (strcmp(key, "messages") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    if (num) { ac->messages = (long)v; ac->present |= PA_MESSAGES; }
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 'a':
+                if (strcmp(key, "alt_baro") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    ac->altitude_ft = saturate_int(v);
+                    ac->present |= PA_ALT_BARO;
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 'g':
+                if (strcmp(key, "gs") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    ac->ground_speed_kts = v;
+                    ac->present |= PA_GS;
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 't':
+                if (strcmp(key, "track") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    ac->track_deg = v;
+                    ac->present |= PA_TRACK;
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            case 'b':
+                if (strcmp(key, "baro_rate") == 0) {
+                    ok = read_numeric(c, &v, &num);
+                    ac->vert_rate_fpm = saturate_int(v);
+                    ac->present |= PA_BARO_RATE;
+                } else {
+                    ok = skip_value(c);
+                }
+                break;
+            default:
+                ok = skip_value(c);
+                break;
+        }
+        if (!ok) return false;
+
+        skip_ws(c);
+        if (c->p >= c->end) return false;
+        if (*c->p == ',') { c->p++; continue; }
+        if (*c->p == '}') { c->p++; return true; }
+        return false;
+    }
+}
+
+/**
+ * @brief Extracts up to `max_out` aircraft from an aircraft.json document.
+ * @param now Receives the top-level "now" timestamp when present (may be NULL).
+ * @return The number of aircraft written, or -1 if the document is malformed or has no "aircraft" array.
+ *         Entries beyond `max_out` are parsed but dropped.
+ */
+long aircraft_json_extract(const char* json, size_t len, struct ParsedAircraft* out, size_t max_out, double* now) {
+    struct Cursor c = { json, json + len };
+    long count = 0;
+    bool saw_aircraft = false;
+
+    if (!expect(&c, '{')) return -1;
+    skip_ws(&c);
+    if (c.p < c.end && *c.p == '}') return -1;
+
+    for (;;) {
+        char key[16];
+        skip_ws(&c);
+        if (!parse_string(&c, key, sizeof(key)) || !expect(&c, ':')) return -1;
+
+        if (strcmp(key, "aircraft") == 0) {
+            if (!expect(&c, '[')) return -1;
+            saw_aircraft = true;
+            skip_ws(&c);
+            if (c.p < c.end && *c.p == ']') {
+                c.p++;
+            } else {
+                for (;;) {
+                    struct ParsedAircraft scratch;
+                    struct ParsedAircraft* dst = (size_t)count < max_out ? &out[count] : &scratch;
+                    if (!parse_aircraft_object(&c, dst)) return -1;
+                    if (dst != &scratch) count++;
+                    skip_ws(&c);
+                    if (c.p >= c.end) return -1;
+                    if (*c.p == ',') { c.p++; continue; }
+                    if (*c.p == ']') { c.p++; break; }
+                    return -1;
+                }
+            }
+        } else if (strcmp(key, "now") == 0 && now) {
+            double v;
+            bool num;
+            if (!read_numeric(&c, &v, &num)) return -1;
+            if (num) *now = v;
+        } else if (!skip_value(&c)) {
+            return -1;
+        }
+
+        skip_ws(&c);
+        if (c.p >= c.end) return -1;
+        if (*c.p == ',') { c.p++; continue; }
+        if (*c.p == '}') break;
+        return -1;
+    }
+    return saw_aircraft ? count : -1;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file aircraft_json.h
+ * @brief Single-pass extractor for dump1090's aircraft.json.
+ */
+
+#ifndef AIRCRAFT_JSON_H
+#define AIRCRAFT_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bits in ParsedAircraft.present
+enum {
+    PA_HEX       = 1 << 0,
+    PA_FLIGHT    = 1 << 1,
+    PA_SQUAWK    = 1 << 2,
+    PA_LAT       = 1 << 3,
+    PA_LON       = 1 << 4,
+    PA_ALT_BARO  = 1 << 5,
+    PA_GS        = 1 << 6,
+    PA_TRACK     = 1 << 7,
+    PA_BARO_RATE = 1 << 8,
+    PA_SEEN_POS  = 1 << 9,
+    PA_SEEN      = 1 << 10,
+    PA_MESSAGES  = 1 << 11,
+};
+
+/**
+ * @brief The subset of one aircraft.json entry that the app uses.
+ * String fields are present only when the JSON value was a string, numeric fields
+ * whenever the key appeared (a non-numeric value such as "ground" reads as 0),
+ * mirroring what the cJSON-based code did.
+ */
+struct ParsedAircraft {
+    char hex[10], flight[24], squawk[6];
+    double lat, lon, ground_speed_kts, track_deg;
+    double seen_pos_s; // Age of the position in seconds at the time of the document
+    double seen_s;     // Age of the last message of any kind
+    long messages;     // Messages received from this aircraft so far
+    int altitude_ft, vert_rate_fpm;
+    uint32_t present;
+};
+
+long aircraft_json_extract(const char* json, size_t len, struct ParsedAircraft* out, size_t max_out, double* now);
+
+#endif // AIRCRAFT_JSON_H
@@ -0,0 +1,498 @@
+/**
+ * @file aircraft_table.c
+ * @brief Tracked aircraft in a slab pool, found through a linear-probing ICAO index and a lat/lon grid.
+ *
+ * Records live in a fixed-capacity pool taken from the heap once by table_init(),
+ * so they never move: the open-addressed index maps each address to a record
+ * number, and backward-shift deletion (no tombstones) only shifts those eight-byte
+ * index slots. Each record's position and grid links are also kept in a parallel
+ * array of 32-byte entries, so the grid walks behind every query touch two
+ * entries per cache line and never the record itself until it is a hit.
+ *
+ * The grid divides the globe into GRID_CELL_DEG squares (in degrees). Cells are
+ * hashed into GRID_BUCKETS chains threaded through the grid entries, so moving
+ * an aircraft to a new cell is an O(1) unlink/link. Nearest-neighbour queries search
+ * rings of cells outwards from the observer and stop as soon as no unvisited
+ * cell can hold anything closer; radius and polygon queries only visit the cells
+ * under their bounding box. Nearest and radius queries gather the entries of the
+ * cells they visit into a PositionBatch and hand it to batch_nearest() or
+ * batch_within(), so only the vectorized pre-filter's survivors get an exact distance.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aircraft_table.h"
+#include "pool.h"
+
+#define GRID_CELL_DEG 0.1 // ~11 km north-south
+#define GRID_ROWS ((int32_t)(180.0 / GRID_CELL_DEG))
+#define GRID_COLS ((int32_t)(360.0 / GRID_CELL_DEG))
+#define GRID_BUCKETS 4096 // Power of two
+#define GRID_MAX_RING 64  // Beyond ~700 km a linear scan is cheaper than more rings
+#define GRID_MAX_CELLS 16384 // Larger boxes fall back to a linear scan
+#define KM_PER_DEG (EARTH_RADIUS_KM * M_PI / 180.0)
+
+struct IndexSlot {
+    uint32_t icao;
+    int32_t record; // -1: empty
+};
+
+// The hot part of a record: what the grid walks read
+struct GridEntry {
+    double lat, lon;     // Copy of ac.lat/ac.lon when positioned
+    int32_t cell_x, cell_y;
+    int32_t prev, next;  // Record numbers in the cell's bucket chain, -1 at the ends
+};
+
+static struct Pool g_records; // struct TrackedAircraft
+static struct GridEntry* g_grid; // Parallel to g_records
+static struct IndexSlot* g_index;
+static uint32_t g_index_mask;
+static int32_t g_grid_head[GRID_BUCKETS];
+static size_t g_positioned_count = 0;
+static struct PositionBatch g_batch; // Candidates of the current query; ref is the record number
+static struct BatchHit* g_hits;      // batch_within() output, as large as the batch
+
+static inline struct TrackedAircraft* record(int32_t r) {
+    return (struct TrackedAircraft*)pool_at(&g_records, r);
+}
+
+static inline int32_t record_of(const struct TrackedAircraft* t) {
+    return (int32_t)(((const uint8_t*)t - g_records.items) / sizeof(*t));
+}
+
+static uint32_t home_slot(uint32_t icao) {
+    return (icao * 2654435761u) & g_index_mask;
+}
+
+
+// --- Grid index ---
+
+static int32_t cell_row(double lat) {
+    int32_t y = (int32_t)floor((lat + 90.0) / GRID_CELL_DEG);
+    return y < 0 ? 0 : (y >= GRID_ROWS ? GRID_ROWS - 1 : y);
+}
+
+static int32_t wrap_col(int32_t x) {
+    x %= GRID_COLS;
+    return x < 0 ? x + GRID_COLS : x;
+}
+
+static int32_t cell_col(double lon) {
+    return wrap_col((int32_t)floor((lon + 180.0) / GRID_CELL_DEG));
+}
+
+static uint32_t bucket_of(int32_t x, int32_t y) {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) & (GRID_BUCKETS - 1);
+}
+
+static void grid_link(int32_t r) {
+    struct GridEntry* g = &g_grid[r];
+    uint32_t b = bucket_of(g->cell_x, g->cell_y);
+    g->prev = -1;
+    g->next = g_grid_head[b];
+    if (g->next >= 0) g_grid[g->next].prev = r;
+    g_grid_head[b] = r;
+}
+
+static void grid_unlink(int32_t r) {
+    struct GridEntry* g = &g_grid[r];
+    if (g->prev >= 0) g_grid[g->prev].next = g->next;
+    else g_grid_head[bucket_of(g->cell_x, g->cell_y)] = g->next;
+    if (g->next >= 0) g_grid[g->next].prev = g->prev;
+}
+
+/**
+ * @brief Records a new position for `t` and moves it to the right grid cell.
+ * distance_km/bearing_deg are left to the caller, which knows the observer.
+ */
+void table_set_position(struct TrackedAircraft* t, double lat, double lon) {
+    int32_t r = record_of(t);
+    struct GridEntry* g = &g_grid[r];
+    int32_t x = cell_col(lon), y = cell_row(lat);
+    if (t->has_position && (x != g->cell_x || y != g->cell_y)) {
+        grid_unlink(r);
+        t->has_position = false;
+        g_positioned_count--;
+    }
+    t->ac.lat = g->lat = lat;
+    t->ac.lon = g->lon = lon;
+    if (!t->has_position) {
+        g->cell_x = x;
+        g->cell_y = y;
+        t->has_position = true;
+        g_positioned_count++;
+        grid_link(r);
+    }
+}
+
+void table_clear_position(struct TrackedAircraft* t) {
+    if (!t->has_position) return;
+    grid_unlink(record_of(t));
+    t->has_position = false;
+    g_positioned_count--;
+}
+
+
+// --- Table ---
+
+/**
+ * @brief Allocates room for `capacity` aircraft, once, and clears the table.
+ * Calling it again with the same capacity only clears.
+ */
+bool table_init(size_t capacity) {
+    if (g_records.items && g_records.capacity == capacity) {
+        table_clear();
+        return true;
+    }
+    table_free();
+    uint32_t slots = 16;
+    while (slots < capacity + capacity / 3) slots <<= 1; // At most 3/4 full keeps probe chains short
+    if (!pool_init(&g_records, sizeof(struct TrackedAircraft), (uint32_t)capacity) ||
+        !(g_grid = aligned_alloc(POOL_ALIGN, (capacity * sizeof(*g_grid) + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1))) ||
+        !(g_index = malloc(slots * sizeof(*g_index))) || !position_batch_init(&g_batch, capacity) ||
+        !(g_hits = malloc(capacity * sizeof(*g_hits)))) {
+        table_free();
+        return false;
+    }
+    g_index_mask = slots - 1;
+    table_clear();
+    return true;
+}
+
+void table_free() {
+    pool_free(&g_records);
+    free(g_grid);
+    free(g_index);
+    position_batch_free(&g_batch);
+    free(g_hits);
+    g_grid = NULL;
+    g_index = NULL;
+    g_hits = NULL;
+    g_positioned_count = 0;
+}
+
+/**
+ * @brief Bytes held by the table: records, grid entries, index, bucket heads and query batch.
+ */
+size_t table_footprint() {
+    if (!g_records.items) return 0;
+    size_t batch = 3 * sizeof(double) + sizeof(uint32_t) + sizeof(*g_hits); // lat, lon, scratch, ref, hit
+    return (size_t)g_records.capacity * (sizeof(struct TrackedAircraft) + sizeof(*g_grid) + sizeof(int32_t) + batch) +
+           (g_index_mask + 1) * sizeof(*g_index) + sizeof(g_grid_head);
+}
+
+size_t table_capacity() { return g_records.capacity; }
+
+void table_clear() {
+    memset(g_records.items, 0, (size_t)g_records.capacity * g_records.item_size);
+    pool_reset(&g_records);
+    memset(g_index, 0xff, (g_index_mask + 1) * sizeof(*g_index)); // All records -1
+    memset(g_grid_head, 0xff, sizeof(g_grid_head));
+    g_positioned_count = 0;
+}
+
+static int64_t find_slot(uint32_t icao) {
+    for (uint32_t i = home_slot(icao), n = 0; n <= g_index_mask; i = (i + 1) & g_index_mask, n++) {
+        if (g_index[i].record < 0) return -1;
+        if (g_index[i].icao == icao) return i;
+    }
+    return -1;
+}
+
+struct TrackedAircraft* table_find(uint32_t icao) {
+    int64_t i = find_slot(icao);
+    return i < 0 ? NULL : record(g_index[i].record);
+}
+
+/**
+ * @brief Returns the entry for `icao`, creating it if needed. NULL if the table is full.
+ */
+struct TrackedAircraft* table_upsert(uint32_t icao, double now) {
+    struct TrackedAircraft* t = table_find(icao);
+    if (!t) {
+        int32_t r = pool_take(&g_records);
+        if (r < 0) return NULL;
+        uint32_t i = home_slot(icao);
+        while (g_index[i].record >= 0) i = (i + 1) & g_index_mask;
+        g_index[i] = (struct IndexSlot){ icao, r };
+        t = record(r);
+        memset(t, 0, sizeof(*t));
+        t->icao = icao;
+        t->used = true;
+        aircraft_reset(&t->ac, "N/A");
+    }
+    t->last_seen = now;
+    return t;
+}
+
+static void remove_slot(uint32_t i) {
+    int32_t r = g_index[i].record;
+    struct TrackedAircraft* t = record(r);
+    table_clear_position(t);
+    t->used = false;
+    pool_give(&g_records, r);
+
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & g_index_mask;
+        if (g_index[j].record < 0) break;
+        uint32_t k = home_slot(g_index[j].icao);
+        bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            g_index[i] = g_index[j];
+            i = j;
+        }
+    }
+    g_index[i].record = -1;
+}
+
+/**
+ * @brief Drops aircraft that have not been heard for `max_age_s`. Pointers to the remaining entries stay valid.
+ * @return The number of entries removed.
+ */
+size_t table_evict_stale(double now, double max_age_s) {
+    size_t removed = 0;
+    for (uint32_t r = 0; r < g_records.capacity; r++) {
+        struct TrackedAircraft* t = record((int32_t)r);
+        if (!t->used || now - t->last_seen <= max_age_s) continue;
+        remove_slot((uint32_t)find_slot(t->icao));
+        removed++;
+    }
+    return removed;
+}
+
+size_t table_count() { return g_records.used; }
+
+
+// --- Spatial queries ---
+
+/**
+ * @brief Inserts `hit` into the ascending list `out` of at most `k` entries.
+ */
+static void keep_nearest(struct TableHit* out, size_t* n, size_t k, struct TableHit hit) {
+    if (*n == k && hit.distance_km >= out[k - 1].distance_km) return;
+    size_t i = *n < k ? (*n)++ : k - 1;
+    while (i > 0 && out[i - 1].distance_km > hit.distance_km) {
+        out[i] = out[i - 1];
+        i--;
+    }
+    out[i] = hit;
+}
+
+/**
+ * @brief Adds the entries of one cell to the query batch.
+ */
+static void gather_cell(int32_t x, int32_t y) {
+    for (int32_t r = g_grid_head[bucket_of(x, y)]; r >= 0; r = g_grid[r].next) {
+        const struct GridEntry* g = &g_grid[r];
+        if (g->cell_x != x || g->cell_y != y) continue; // Another cell sharing the bucket
+        position_batch_add(&g_batch, g->lat, g->lon, (uint32_t)r);
+    }
+}
+
+/**
+ * @brief Adds every positioned aircraft to the query batch, for queries too wide for the grid.
+ */
+static void gather_all() {
+    for (uint32_t r = 0; r < g_records.capacity; r++) {
+        const struct TrackedAircraft* t = record((int32_t)r);
+        if (t->used && t->has_position) position_batch_add(&g_batch, t->ac.lat, t->ac.lon, r);
+    }
+}
+
+/**
+ * @brief Merges the query batch into the `k` nearest so far. Once `out` is full, only entries closer than
+ * its last one can get in, so that distance is the batch_within() radius.
+ */
+static void keep_nearest_batch(const struct Observer* obs, size_t k, struct TableHit* out, size_t* n) {
+    if (g_batch.count == 0) return;
+    if (k == 1) {
+        struct BatchHit hit;
+        if (batch_nearest(obs, &g_batch, &hit)) keep_nearest(out, n, k, (struct TableHit){ record((int32_t)hit.ref), hit.distance_km });
+        return;
+    }
+    double bound = *n == k ? out[k - 1].distance_km : INFINITY;
+    size_t hits = batch_within(obs, &g_batch, bound, g_hits, g_batch.count);
+    for (size_t i = 0; i < hits; i++) {
+        keep_nearest(out, n, k, (struct TableHit){ record((int32_t)g_hits[i].ref), g_hits[i].distance_km });
+    }
+}
+
+/**
+ * @brief The `k` positioned aircraft nearest to `obs`, closest first.
+ * @return The number written to `out` (fewer than `k` if fewer are positioned).
+ */
+size_t table_nearest(const struct Observer* obs, size_t k, struct TableHit* out) {
+    if (k == 0 || g_positioned_count == 0) return 0;
+    int32_t ox = cell_col(obs->lon), oy = cell_row(obs->lat);
+    size_t n = 0, visited = 0;
+
+    for (int32_t r = 0; r <= GRID_MAX_RING; r++) {
+        position_batch_clear(&g_batch);
+        for (int32_t y = oy - r; y <= oy + r; y++) {
+            if (y < 0 || y >= GRID_ROWS) continue;
+            bool edge_row = (y == oy - r || y == oy + r);
+            int32_t step = edge_row ? 1 : 2 * r; // Interior rows only have the two ring ends
+            for (int32_t dx = -r; dx <= r; dx += step) gather_cell(wrap_col(ox + dx), y);
+        }
+        visited += g_batch.count;
+        keep_nearest_batch(obs, k, out, &n);
+        if (visited == g_positioned_count) return n;
+
+        // Anything not yet visited lies at least r whole cells away from the observer's cell.
+        // Cells are narrowest at the highest latitude of the next ring; 0.95 absorbs the
+        // difference between a parallel and the great circle at these ranges.
+        double max_lat = fabs(obs->lat) + (r + 2) * GRID_CELL_DEG;
+        double cell_km = GRID_CELL_DEG * KM_PER_DEG * (max_lat < 90.0 ? cos(deg2rad(max_lat)) : 0.0);
+        if (n == k && out[k - 1].distance_km <= 0.95 * r * cell_km) return n;
+    }
+    n = 0;
+    position_batch_clear(&g_batch);
+    gather_all();
+    keep_nearest_batch(obs, k, out, &n);
+    return n;
+}
+
+struct TrackedAircraft* table_closest(const struct Observer* obs) {
+    struct TableHit hit;
+    return table_nearest(obs, 1, &hit) ? hit.t : NULL;
+}
+
+/**
+ * @brief Visits the cells covering a lat/lon box; false if the box is too large for the grid to help.
+ */
+static bool box_cells(double lat_min, double lat_max, double lon_min, double lon_max,
+                      int32_t* y0, int32_t* y1, int32_t* x0, int32_t* cols) {
+    *y0 = cell_row(lat_min);
+    *y1 = cell_row(lat_max);
+    int32_t span = (int32_t)floor((lon_max + 180.0) / GRID_CELL_DEG) - (int32_t)floor((lon_min + 180.0) / GRID_CELL_DEG) + 1;
+    if (span > GRID_COLS) span = GRID_COLS;
+    *x0 = cell_col(lon_min);
+    *cols = span;
+    return (int64_t)(*y1 - *y0 + 1) * span <= GRID_MAX_CELLS;
+}
+
+static void collect(struct TableHit* out, size_t max_out, size_t* n, int32_t r, double d) {
+    if (*n < max_out) out[*n] = (struct TableHit){ record(r), d };
+    (*n)++;
+}
+
+/**
+ * @brief Positioned aircraft strictly closer than `radius_km` to `obs`, in no particular order.
+ * @return The number of matches; only the first `max_out` are written.
+ */
+size_t table_within(const struct Observer* obs, double radius_km, struct TableHit* out, size_t max_out) {
+    size_t n = 0;
+    if (g_positioned_count == 0) return 0;
+    double dlat = radius_km / KM_PER_DEG;
+    double max_lat = fabs(obs->lat) + dlat;
+    double dlon = max_lat < 89.0 ? dlat / cos(deg2rad(max_lat)) : 360.0;
+
+    int32_t y0, y1, x0, cols;
+    position_batch_clear(&g_batch);
+    if (box_cells(obs->lat - dlat, obs->lat + dlat, obs->lon - dlon, obs->lon + dlon, &y0, &y1, &x0, &cols)) {
+        for (int32_t y = y0; y <= y1; y++) {
+            for (int32_t c = 0; c < cols; c++) gather_cell(wrap_col(x0 + c), y);
+        }
+    } else {
+        gather_all();
+    }
+    size_t hits = batch_within(obs, &g_batch, radius_km, g_hits, g_batch.count);
+    for (size_t i = 0; i < hits; i++) collect(out, max_out, &n, (int32_t)g_hits[i].ref, g_hits[i].distance_km);
+    return n;
+}
+
+/**
+ * @brief Positioned aircraft inside `poly` (see point_in_polygon), with distances from `obs`.
+ * @return The number of matches; only the first `max_out` are written.
+ */
+size_t table_in_polygon(const struct Observer* obs, const struct GeoPoint* poly, size_t n_points,
+                        struct TableHit* out, size_t max_out) {
+    size_t n = 0;
+    if (n_points < 3 || g_positioned_count == 0) return 0;
+    double lat_min = poly[0].lat, lat_max = poly[0].lat, lon_min = poly[0].lon, lon_max = poly[0].lon;
+    for (size_t i = 1; i < n_points; i++) {
+        lat_min = fmin(lat_min, poly[i].lat);
+        lat_max = fmax(lat_max, poly[i].lat);
+        lon_min = fmin(lon_min, poly[i].lon);
+        lon_max = fmax(lon_max, poly[i].lon);
+    }
+
+    int32_t y0, y1, x0, cols;
+    if (!box_cells(lat_min, lat_max, lon_min, lon_max, &y0, &y1, &x0, &cols)) {
+        for (uint32_t r = 0; r < g_records.capacity; r++) {
+            struct TrackedAircraft* t = record((int32_t)r);
+            if (!t->used || !t->has_position || !point_in_polygon(poly, n_points, t->ac.lat, t->ac.lon)) continue;
+            collect(out, max_out, &n, (int32_t)r, observer_distance_km(obs, t->ac.lat, t->ac.lon));
+        }
+        return n;
+    }
+    for (int32_t y = y0; y <= y1; y++) {
+        for (int32_t c = 0; c < cols; c++) {
+            int32_t x = wrap_col(x0 + c);
+            for (int32_t r = g_grid_head[bucket_of(x, y)]; r >= 0; r = g_grid[r].next) {
+                const struct GridEntry* g = &g_grid[r];
+                if (g->cell_x != x || g->cell_y != y) continue;
+                if (!point_in_polygon(poly, n_points, g->lat, g->lon)) continue;
+                collect(out, max_out, &n, r, observer_distance_km(obs, g->lat, g->lon));
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Iterates over occupied entries. Start with `*cursor = 0`.
+ */
+bool table_next(size_t* cursor, struct TrackedAircraft** out) {
+    while (*cursor < g_records.capacity) {
+        struct TrackedAircraft* t = record((int32_t)(*cursor)++);
+        if (t->used) {
+            *out = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// --- Trails ---
+
+/**
+ * @brief Adds a fix to the trail of `t` unless the previous point is less than TRAIL_INTERVAL_S older.
+ */
+void table_push_trail(struct TrackedAircraft* t, double lat, double lon, double fix_time) {
+    if (t->trail_len > 0) {
+        const struct TrailPoint* last = &t->trail[(t->trail_next + TRAIL_POINTS - 1) % TRAIL_POINTS];
+        if (fix_time - last->time < TRAIL_INTERVAL_S) return;
+    }
+    t->trail[t->trail_next] = (struct TrailPoint){ (float)lat, (float)lon, fix_time };
+    t->trail_next = (uint8_t)((t->trail_next + 1) % TRAIL_POINTS);
+    if (t->trail_len < TRAIL_POINTS) t->trail_len++;
+}
+
+/**
+ * @brief Adds an older fix before the start of the trail of `t`, if there is room and it is at least
+ * TRAIL_INTERVAL_S before the oldest point. For backfilling from history, newest fix first.
+ */
+void table_prepend_trail(struct TrackedAircraft* t, double lat, double lon, double fix_time) {
+    if (t->trail_len == TRAIL_POINTS) return;
+    size_t first = (t->trail_next + TRAIL_POINTS - t->trail_len) % TRAIL_POINTS;
+    if (t->trail_len > 0 && t->trail[first].time - fix_time < TRAIL_INTERVAL_S) return;
+    first = (first + TRAIL_POINTS - 1) % TRAIL_POINTS;
+    t->trail[first] = (struct TrailPoint){ (float)lat, (float)lon, fix_time };
+    t->trail_len++;
+}
+
+/**
+ * @brief Copies the trail of `t`, oldest first, into `out` (room for TRAIL_POINTS).
+ * @return The number of points.
+ */
+size_t table_trail(const struct TrackedAircraft* t, struct TrailPoint* out) {
+    size_t first = (t->trail_next + TRAIL_POINTS - t->trail_len) % TRAIL_POINTS;
+    for (size_t i = 0; i < t->trail_len; i++) out[i] = t->trail[(first + i) % TRAIL_POINTS];
+    return t->trail_len;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file aircraft_table.h
+ * @brief Persistent table of every aircraft currently heard, keyed by ICAO address.
+ *
+ * Positioned entries are also linked into a lat/lon grid, so nearest, radius and
+ * polygon queries only visit the cells around the area of interest.
+ *
+ * Capacity is fixed by table_init() and allocated once; entries never move, so
+ * a pointer to one stays valid until that entry is evicted.
+ *
+ * Owned by the fetch worker thread; not thread-safe. Call table_init() before first use.
+ */
+
+#ifndef AIRCRAFT_TABLE_H
+#define AIRCRAFT_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aircraft.h"
+#include "geo.h"
+#include "geo_batch.h"
+
+#define TRAIL_POINTS 8       // Past fixes kept per aircraft
+#define TRAIL_INTERVAL_S 15.0 // Minimum spacing between them, so the trail covers about two minutes
+
+struct TrailPoint {
+    float lat, lon;
+    double time; // monotonic_seconds() of the fix
+};
+
+// Bookkeeping first and then the record, whose own hot fields lead, so the scan's
+// checks and position update stay within the first two cache lines.
+struct TrackedAircraft {
+    uint32_t icao;
+    bool used;
+    bool has_position;
+    bool enriched;        // Registration details already looked up
+    uint8_t source;       // Receiver whose document last updated the fields and `messages`
+    uint8_t pos_source;   // Receiver the current position came from
+    double last_seen;     // monotonic_seconds() of the last message
+    double last_position; // monotonic_seconds() of the last position
+    long messages;        // dump1090's message count at the last update (polling mode)
+    double enrich_retry_at; // After a failed lookup, don't retry before this time
+    struct Aircraft ac;   // Position valid when has_position; distance_km/bearing_deg only as set by the producer
+    struct TrailPoint trail[TRAIL_POINTS]; // Ring of earlier fixes, see table_trail()
+    uint8_t trail_len, trail_next;
+};
+
+// One query result; `distance_km` is from the observer the query was made for.
+struct TableHit {
+    struct TrackedAircraft* t;
+    double distance_km;
+};
+
+bool table_init(size_t capacity);
+void table_free();
+void table_clear();
+size_t table_capacity();
+size_t table_footprint();
+struct TrackedAircraft* table_find(uint32_t icao);
+struct TrackedAircraft* table_upsert(uint32_t icao, double now);
+size_t table_evict_stale(double now, double max_age_s);
+size_t table_count();
+void table_set_position(struct TrackedAircraft* t, double lat, double lon);
+void table_clear_position(struct TrackedAircraft* t);
+struct TrackedAircraft* table_closest(const struct Observer* obs);
+size_t table_nearest(const struct Observer* obs, size_t k, struct TableHit* out);
+size_t table_within(const struct Observer* obs, double radius_km, struct TableHit* out, size_t max_out);
+size_t table_in_polygon(const struct Observer* obs, const struct GeoPoint* poly, size_t n_points,
+                        struct TableHit* out, size_t max_out);
+bool table_next(size_t* cursor, struct TrackedAircraft** out);
+void table_push_trail(struct TrackedAircraft* t, double lat, double lon, double fix_time);
+void table_prepend_trail(struct TrackedAircraft* t, double lat, double lon, double fix_time);
+size_t table_trail(const struct TrackedAircraft* t, struct TrailPoint* out);
+
+#endif // AIRCRAFT_TABLE_H
@@ -0,0 +1,104 @@
+/**
+ * @file bench_geo.c
+ * @brief Compares the scalar closest-aircraft scan against the batch kernel in geo_batch.c.
+ *
+ * Usage: bench_geo
+ * Random positions are scattered within ~450 km of an observer at several batch
+ * sizes. The scalar path is the original loop: haversine_distance() per aircraft
+ * and calculate_bearing() on every new minimum. Both paths must agree on the
+ * nearest aircraft and on the in-radius count before they are timed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "geo.h"
+#include "geo_batch.h"
+
+#define OBSERVER_LAT 51.5074
+#define OBSERVER_LON -0.1278
+#define RADIUS_KM 50.0
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static size_t scalar_nearest(const double* lat, const double* lon, size_t n, double* best_km, double* bearing, size_t* within) {
+    size_t best = 0;
+    *best_km = 1e12;
+    *within = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = haversine_distance(OBSERVER_LAT, OBSERVER_LON, lat[i], lon[i]);
+        if (d < RADIUS_KM) (*within)++;
+        if (d < *best_km) {
+            *best_km = d;
+            *bearing = calculate_bearing(OBSERVER_LAT, OBSERVER_LON, lat[i], lon[i]);
+            best = i;
+        }
+    }
+    return best;
+}
+
+static bool run(size_t n) {
+    struct Observer obs;
+    struct PositionBatch batch;
+    observer_init(&obs, OBSERVER_LAT, OBSERVER_LON);
+    if (!position_batch_init(&batch, n)) return false;
+    struct BatchHit* hits = malloc(n * sizeof(*hits));
+    if (!hits) { position_batch_free(&batch); return false; }
+
+    srand(7);
+    for (size_t i = 0; i < n; i++) {
+        double lat = OBSERVER_LAT + ((rand() % 80001) - 40000) / 10000.0;
+        double lon = OBSERVER_LON + ((rand() % 120001) - 60000) / 10000.0;
+        position_batch_add(&batch, lat, lon, (uint32_t)i);
+    }
+
+    double scalar_km, bearing;
+    size_t scalar_within;
+    size_t scalar_best = scalar_nearest(batch.lat, batch.lon, n, &scalar_km, &bearing, &scalar_within);
+    struct BatchHit hit;
+    bool ok = batch_nearest(&obs, &batch, &hit) && hit.slot == scalar_best && fabs(hit.distance_km - scalar_km) < 1e-9;
+    size_t batch_count = batch_within(&obs, &batch, RADIUS_KM, hits, n);
+    if (!ok || batch_count != scalar_within) {
+        fprintf(stderr, "%zu aircraft: batch kernel disagrees with the scalar scan\n", n);
+        free(hits);
+        position_batch_free(&batch);
+        return false;
+    }
+
+    int iterations = (int)(3e7 / (double)n) + 3;
+    volatile double sink = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        scalar_nearest(batch.lat, batch.lon, n, &scalar_km, &bearing, &scalar_within);
+        sink += scalar_km;
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        batch_nearest(&obs, &batch, &hit);
+        sink += observer_bearing(&obs, batch.lat[hit.slot], batch.lon[hit.slot]);
+        sink += (double)batch_within(&obs, &batch, RADIUS_KM, hits, n);
+    }
+    double t2 = now_ns();
+    (void)sink;
+
+    double scalar_ns = (t1 - t0) / iterations / (double)n;
+    double batch_ns = (t2 - t1) / iterations / (double)n;
+    printf("%6zu aircraft | scalar %6.1f ns/ac | batch %6.1f ns/ac | %5.1fx\n", n, scalar_ns, batch_ns, scalar_ns / batch_ns);
+    free(hits);
+    position_batch_free(&batch);
+    return true;
+}
+
+int main(void) {
+    static const size_t sizes[] = { 10, 100, 1000, 10000, 100000 };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) ok &= run(sizes[i]);
+    return ok ? 0 : 1;
+}
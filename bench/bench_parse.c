@@ -0,0 +1,170 @@
+/**
+ * @file bench_parse.c
+ * @brief Compares the streaming aircraft.json extractor against the cJSON DOM path.
+ *
+ * Usage: bench_parse [aircraft.json ...]
+ * Without arguments a synthetic dump1090-fa document is generated at several
+ * sizes. Both paths extract the same ten fields; the results are cross-checked
+ * before timing so a faster but wrong parser cannot pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <cjson/cJSON.h>
+
+#include "aircraft_json.h"
+
+#define MAX_AIRCRAFT 8192
+
+static struct ParsedAircraft g_streamed[MAX_AIRCRAFT];
+static struct ParsedAircraft g_dom[MAX_AIRCRAFT];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Builds an aircraft.json with `n` entries carrying the full dump1090-fa key set.
+ */
+static char* generate_document(int n, size_t* len) {
+    size_t cap = (size_t)n * 700 + 256;
+    char* buf = malloc(cap);
+    if (!buf) return NULL;
+    size_t off = (size_t)snprintf(buf, cap, "{ \"now\" : 1700000000.1,\n  \"messages\" : 123456789,\n  \"aircraft\" : [\n");
+    srand(42);
+    for (int i = 0; i < n; i++) {
+        double lat = 51.0 + (rand() % 20000) / 10000.0;
+        double lon = -1.0 + (rand() % 20000) / 10000.0;
+        bool has_pos = (i % 7) != 0; // Some aircraft have no position, like real feeds
+        off += (size_t)snprintf(buf + off, cap - off,
+            "    {\"hex\":\"%06x\",\"type\":\"adsb_icao\",\"flight\":\"BAW%-4d \",\"alt_baro\":%d,\"alt_geom\":%d,"
+            "\"gs\":%.1f,\"ias\":280,\"tas\":450,\"mach\":0.780,\"track\":%.2f,\"track_rate\":0.03,\"roll\":-0.2,"
+            "\"mag_heading\":87.5,\"baro_rate\":%d,\"geom_rate\":-64,\"squawk\":\"%04d\",\"emergency\":\"none\","
+            "\"category\":\"A3\",\"nav_qnh\":1013.2,\"nav_altitude_mcp\":36000,\"nav_heading\":87.2,",
+            0x400000 + i * 37, i % 10000, (i * 97) % 41000, (i * 131) % 41000 + 100,
+            250.0 + (i % 200), (double)((i * 17) % 360), ((i * 13) % 40 - 20) * 64, (i * 7) % 7777);
+        if (has_pos) {
+            off += (size_t)snprintf(buf + off, cap - off, "\"lat\":%.6f,\"lon\":%.6f,\"nic\":8,\"rc\":186,\"seen_pos\":0.4,", lat, lon);
+        }
+        off += (size_t)snprintf(buf + off, cap - off,
+            "\"version\":2,\"nic_baro\":1,\"nac_p\":10,\"nac_v\":2,\"sil\":3,\"sil_type\":\"perhour\",\"gva\":2,\"sda\":2,"
+            "\"mlat\":[],\"tis_b\":[],\"messages\":%d,\"seen\":0.1,\"rssi\":-21.4}%s\n",
+            1000 + i, i + 1 < n ? "," : "");
+    }
+    off += (size_t)snprintf(buf + off, cap - off, "  ]\n}\n");
+    *len = off;
+    return buf;
+}
+
+static char* read_file(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = malloc((size_t)size + 1);
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) { free(buf); buf = NULL; }
+    fclose(f);
+    if (buf) { buf[size] = '\0'; *len = (size_t)size; }
+    return buf;
+}
+
+/**
+ * @brief The previous implementation: full DOM parse, then one key scan per field.
+ */
+static long extract_with_cjson(const char* json, struct ParsedAircraft* out, size_t max_out) {
+    cJSON* root = cJSON_Parse(json);
+    if (!root) return -1;
+    cJSON* arr = cJSON_GetObjectItemCaseSensitive(root, "aircraft");
+    long n = 0;
+    cJSON* a;
+    cJSON_ArrayForEach(a, arr) {
+        if ((size_t)n >= max_out) break;
+        struct ParsedAircraft* p = &out[n++];
+        memset(p, 0, sizeof(*p));
+        cJSON* item;
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "hex")) && item->valuestring) { snprintf(p->hex, sizeof(p->hex), "%s", item->valuestring); p->present |= PA_HEX; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "flight")) && item->valuestring) { snprintf(p->flight, sizeof(p->flight), "%s", item->valuestring); p->present |= PA_FLIGHT; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "squawk")) && item->valuestring) { snprintf(p->squawk, sizeof(p->squawk), "%s", item->valuestring); p->present |= PA_SQUAWK; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "lat")) && cJSON_IsNumber(item)) { p->lat = item->valuedouble; p->present |= PA_LAT; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "lon")) && cJSON_IsNumber(item)) { p->lon = item->valuedouble; p->present |= PA_LON; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "alt_baro"))) { p->altitude_ft = item->valueint; p->present |= PA_ALT_BARO; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "gs"))) { p->ground_speed_kts = item->valuedouble; p->present |= PA_GS; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "track"))) { p->track_deg = item->valuedouble; p->present |= PA_TRACK; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "baro_rate"))) { p->vert_rate_fpm = item->valueint; p->present |= PA_BARO_RATE; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "seen_pos")) && cJSON_IsNumber(item)) { p->seen_pos_s = item->valuedouble; p->present |= PA_SEEN_POS; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "seen")) && cJSON_IsNumber(item)) { p->seen_s = item->valuedouble; p->present |= PA_SEEN; }
+        if ((item = cJSON_GetObjectItemCaseSensitive(a, "messages")) && cJSON_IsNumber(item)) { p->messages = (long)item->valuedouble; p->present |= PA_MESSAGES; }
+    }
+    cJSON_Delete(root);
+    return n;
+}
+
+static bool same_results(long n) {
+    for (long i = 0; i < n; i++) {
+        const struct ParsedAircraft *a = &g_streamed[i], *b = &g_dom[i];
+        if (a->present != b->present || strcmp(a->hex, b->hex) || strcmp(a->flight, b->flight) ||
+            strcmp(a->squawk, b->squawk) || a->lat != b->lat || a->lon != b->lon ||
+            a->altitude_ft != b->altitude_ft || a->ground_speed_kts != b->ground_speed_kts ||
+            a->track_deg != b->track_deg || a->vert_rate_fpm != b->vert_rate_fpm || a->seen_pos_s != b->seen_pos_s ||
+            a->seen_s != b->seen_s || a->messages != b->messages) {
+            fprintf(stderr, "MISMATCH at aircraft %ld (hex %s / %s)\n", i, a->hex, b->hex);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run(const char* label, const char* json, size_t len) {
+    long n_stream = aircraft_json_extract(json, len, g_streamed, MAX_AIRCRAFT, NULL);
+    long n_dom = extract_with_cjson(json, g_dom, MAX_AIRCRAFT);
+    if (n_stream < 0 || n_stream != n_dom || !same_results(n_stream)) {
+        fprintf(stderr, "%s: streaming parser disagrees with cJSON (%ld vs %ld aircraft)\n", label, n_stream, n_dom);
+        return false;
+    }
+
+    // Aim for roughly 0.3 s per path regardless of document size
+    int iterations = (int)(150e6 / (double)(len + 1)) + 3;
+    double t0 = now_ns();
+    for (int i = 0; i < iterations; i++) extract_with_cjson(json, g_dom, MAX_AIRCRAFT);
+    double t1 = now_ns();
+    for (int i = 0; i < iterations; i++) aircraft_json_extract(json, len, g_streamed, MAX_AIRCRAFT, NULL);
+    double t2 = now_ns();
+
+    double dom_us = (t1 - t0) / iterations / 1e3;
+    double stream_us = (t2 - t1) / iterations / 1e3;
+    double per = n_stream > 0 ? (double)n_stream : 1.0;
+    printf("%-18s %6ld aircraft %8zu bytes | cJSON %9.1f us (%6.0f ns/ac) | stream %8.1f us (%5.0f ns/ac) | %5.1fx\n",
+           label, n_stream, len, dom_us, dom_us * 1e3 / per, stream_us, stream_us * 1e3 / per, dom_us / stream_us);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool ok = true;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            size_t len;
+            char* json = read_file(argv[i], &len);
+            if (!json) { perror(argv[i]); return 1; }
+            ok &= run(argv[i], json, len);
+            free(json);
+        }
+    } else {
+        static const int sizes[] = { 10, 100, 300, 1000, 3000 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            size_t len;
+            char* json = generate_document(sizes[i], &len);
+            char label[32];
+            snprintf(label, sizeof(label), "synthetic-%d", sizes[i]);
+            ok &= json && run(label, json, len);
+            free(json);
+        }
+    }
+    return ok ? 0 : 1;
+}
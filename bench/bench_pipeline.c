@@ -0,0 +1,188 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Times one refresh cycle of the fetch worker over recorded aircraft.json captures.
+ *
+ * Usage: bench_pipeline [aircraft.json ...]
+ * Without arguments the corpus in bench/corpus is used (10, 100, 500 and 2000
+ * aircraft). Each cycle is exactly what fetch_and_process_data() does after the
+ * download: scan_ingest_document(), scan_evict(), scan_select_closest(),
+ * select_traffic(), select_sites(), select_predicted() and, as when the radar
+ * view is shown, scope_update(). Two cases are timed
+ * per capture:
+ *
+ *   cold  the table is emptied first, so every aircraft is inserted and derived
+ *   warm  the same document again, so every aircraft takes the unchanged path
+ *
+ * Heap calls are counted by wrapping malloc/calloc/realloc at link time; any
+ * allocation inside a cycle fails the run, since the worker is meant to reach a
+ * steady state without one. The preallocated footprint, the most cycle scratch
+ * used and peak RSS are reported at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "aircraft_table.h"
+#include "config.h"
+#include "geo.h"
+#include "geo_batch.h"
+#include "scan.h"
+#include "scope.h"
+#include "snapshot.h"
+
+#define OBSERVER_LAT 51.5074
+#define OBSERVER_LON -0.1278
+
+static const char* const g_default_corpus[] = {
+    "bench/corpus/aircraft-10.json", "bench/corpus/aircraft-100.json",
+    "bench/corpus/aircraft-500.json", "bench/corpus/aircraft-2000.json",
+};
+
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+static unsigned long g_allocations = 0;
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size) { g_allocations++; return __real_malloc(size); }
+void* __wrap_calloc(size_t n, size_t size) { g_allocations++; return __real_calloc(n, size); }
+void* __wrap_realloc(void* ptr, size_t size) { g_allocations++; return __real_realloc(ptr, size); }
+
+static struct Snapshot g_snap;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static char* read_file(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = malloc((size_t)size + 1);
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) { free(buf); buf = NULL; }
+    fclose(f);
+    if (buf) { buf[size] = '\0'; *len = (size_t)size; }
+    return buf;
+}
+
+/**
+ * @brief One worker cycle after the download, as in fetch_and_process_data().
+ */
+static long cycle(const char* json, size_t len, double now) {
+    memset(&g_snap.scan_stats, 0, sizeof(g_snap.scan_stats));
+    scan_begin_cycle();
+    long listed = scan_ingest_document(json, len, now, 0, &g_snap.scan_stats, NULL);
+    if (listed < 0) return -1;
+    scan_evict(now, &g_snap.scan_stats);
+    scan_select_closest(&g_snap, &g_observer);
+    select_traffic(&g_snap, &g_observer);
+    select_sites(&g_snap);
+    select_predicted(&g_snap, &g_observer, now);
+    scope_update(&g_observer);
+    return listed;
+}
+
+static bool run(const char* label, const char* json, size_t len) {
+    // Aim for roughly 0.3 s per case regardless of document size
+    int iterations = (int)(60e6 / (double)(len + 1)) + 3;
+    double now = 1000.0;
+
+    table_clear();
+    long listed = cycle(json, len, now);
+    if (listed < 0) {
+        fprintf(stderr, "%s: not an aircraft.json document\n", label);
+        return false;
+    }
+    size_t with_position = g_snap.scan_stats.updated;
+
+    unsigned long allocs_before = g_allocations;
+    double t0 = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        table_clear();
+        cycle(json, len, now);
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < iterations; i++) cycle(json, len, now);
+    double t2 = now_ns();
+    double allocs = (double)(g_allocations - allocs_before) / (2.0 * iterations);
+
+    double per = listed > 0 ? (double)listed : 1.0;
+    double cold_us = (t1 - t0) / iterations / 1e3;
+    double warm_us = (t2 - t1) / iterations / 1e3;
+    printf("%-34s %5ld aircraft (%5zu placed) | cold %8.1f us (%5.0f ns/ac) | warm %8.1f us (%5.0f ns/ac) | %.2f allocs/cycle\n",
+           label, listed, with_position, cold_us, cold_us * 1e3 / per, warm_us, warm_us * 1e3 / per, allocs);
+    if (allocs > 0.0) {
+        fprintf(stderr, "%s: the refresh cycle allocates; it should run from preallocated buffers\n", label);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The scalar geo helpers still used for sites, the compass and dead reckoning.
+ */
+static void run_geo(void) {
+    enum { N = 4096 };
+    static double lat[N], lon[N];
+    srand(7);
+    for (int i = 0; i < N; i++) {
+        lat[i] = OBSERVER_LAT + ((rand() % 80001) - 40000) / 10000.0;
+        lon[i] = OBSERVER_LON + ((rand() % 120001) - 60000) / 10000.0;
+    }
+    int rounds = 2000;
+    volatile double sink = 0;
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < N; i++) sink += haversine_distance(OBSERVER_LAT, OBSERVER_LON, lat[i], lon[i]);
+    double t1 = now_ns();
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < N; i++) sink += calculate_bearing(OBSERVER_LAT, OBSERVER_LON, lat[i], lon[i]);
+    double t2 = now_ns();
+    (void)sink;
+    double calls = (double)rounds * N;
+    printf("%-34s haversine_distance %5.1f ns/call | calculate_bearing %5.1f ns/call\n", "geo", (t1 - t0) / calls,
+           (t2 - t1) / calls);
+}
+
+int main(int argc, char** argv) {
+    // Defaults that load_config() would set, without reading location.conf
+    g_track_timeout_s = TRACK_TIMEOUT_SECONDS;
+    g_predict_horizon_s = PREDICT_HORIZON_SECONDS;
+    g_table_capacity = TABLE_CAPACITY;
+    g_user_lat = OBSERVER_LAT;
+    g_user_lon = OBSERVER_LON;
+    observer_init(&g_observer, g_user_lat, g_user_lon);
+    if (!scan_init(g_table_capacity)) return 1;
+    scope_enable(true);
+
+    const char* const* files = (const char* const*)(argv + 1);
+    int count = argc - 1;
+    if (count == 0) {
+        files = g_default_corpus;
+        count = (int)(sizeof(g_default_corpus) / sizeof(g_default_corpus[0]));
+    }
+
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        size_t len;
+        char* json = read_file(files[i], &len);
+        if (!json) { perror(files[i]); return 1; }
+        ok &= run(files[i], json, len);
+        free(json);
+    }
+    run_geo();
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%-34s %zu KiB (cycle scratch high water %zu KiB)\n", "preallocated", scan_footprint() / 1024,
+           scan_scratch_high_water() / 1024);
+    printf("%-34s %ld KiB\n", "peak RSS", ru.ru_maxrss);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file bench_render.c
+ * @brief Times a frame of window text through both paths of render_text(), offscreen.
+ *
+ * Usage: bench_render
+ * Renders into a software renderer on a memory surface, so no display is needed.
+ * The atlas path is text_draw() plus one text_flush() per frame; the fallback is
+ * what render_text() does without an atlas: TTF_RenderText_Blended and a fresh
+ * texture per line. The frame is the same line count and length as the main
+ * window with a plane in view.
+ *
+ * Startup is timed once each way: uploading the atlas rasterized at build time
+ * (text_init_prebuilt()) against opening the embedded TTF and rasterizing it
+ * (text_init()).
+ *
+ * The radar view is timed with RADAR_TARGETS synthetic aircraft, each with a
+ * full trail and a label: first with nothing moving, then with a tenth of them
+ * moving every frame, which is harsher than any real feed.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "font_data.h"
+#include "radar.h"
+#include "text.h"
+
+#define FRAME_W 1024
+#define FRAME_H 768
+#ifndef FONT_SIZE
+#error "FONT_SIZE comes from the Makefile, as for main.c"
+#endif
+#define RADAR_TARGETS 1000
+
+static const char* const g_frame_lines[] = {
+    "--- Closest Aircraft Monitor ---",
+    "Flight: BAW123   (G-EUUA)",
+    "Type: A320   Operator: British Airways",
+    "Distance: 4.21 km   Bearing: 273 W",
+    "Altitude: 2975 ft   Vert: -640 fpm",
+    "Speed: 180 kts   Track: 090 E",
+    "Squawk: 1234 (Assigned)",
+    "Seen: 0.4 s ago   dead-reckoned",
+    "dump1090  HTTP/1.1 reused dns 0 conn 0 tls 0 wait 2 xfer 1 ms buf 64/128K 93% saved",
+    "table     512 listed, 120 moved, 392 skipped, 3 evicted",
+    "adsb.lol  cache hit",
+    "Traffic",
+    "BAW123    4.2 km   2975 ft",
+    "EZY45AB  11.8 km  12000 ft",
+    "RYR8821  23.0 km  35000 ft",
+};
+#define FRAME_LINES (int)(sizeof(g_frame_lines) / sizeof(g_frame_lines[0]))
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void frame_atlas(SDL_Renderer* r, TTF_Font* font, SDL_Color color) {
+    (void)font; // Glyphs come from the atlas built by text_init()
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+    SDL_RenderClear(r);
+    for (int i = 0; i < FRAME_LINES; i++) text_draw(g_frame_lines[i], 10, 10 + i * 25, color);
+    text_flush();
+    SDL_RenderPresent(r);
+}
+
+static void frame_per_line(SDL_Renderer* r, TTF_Font* font, SDL_Color color) {
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+    SDL_RenderClear(r);
+    for (int i = 0; i < FRAME_LINES; i++) {
+        SDL_Surface* s = TTF_RenderText_Blended(font, g_frame_lines[i], color);
+        if (!s) continue;
+        SDL_Texture* tex = SDL_CreateTextureFromSurface(r, s);
+        if (tex) {
+            SDL_Rect dst = { 10, 10 + i * 25, s->w, s->h };
+            SDL_RenderCopy(r, tex, NULL, &dst);
+            SDL_DestroyTexture(tex);
+        }
+        SDL_FreeSurface(s);
+    }
+    SDL_RenderPresent(r);
+}
+
+static struct ScopeFrame g_scope;
+
+static void fill_scope(void) {
+    g_scope.count = RADAR_TARGETS;
+    for (int i = 0; i < RADAR_TARGETS; i++) {
+        struct ScopeTarget* t = &g_scope.targets[i];
+        t->icao = 0x400000 + (uint32_t)i * 7;
+        t->east_km = (float)(i % 40 - 20) * 2.3f;
+        t->north_km = (float)(i / 40 - 12) * 1.9f;
+        t->east_kms = 0.12f;
+        t->north_kms = 0.05f;
+        t->position_time = 1.0;
+        t->trail_len = TRAIL_POINTS;
+        for (int k = 0; k < TRAIL_POINTS; k++) {
+            t->trail_east[k] = t->east_km - 0.2f * (TRAIL_POINTS - k);
+            t->trail_north[k] = t->north_km - 0.1f * (TRAIL_POINTS - k);
+        }
+        snprintf(t->label, sizeof(t->label), "TST%04d", i);
+    }
+}
+
+static double time_radar(SDL_Renderer* r, int frames, bool moving) {
+    double t0 = now_ns();
+    for (int i = 0; i < frames; i++) {
+        if (moving) {
+            for (int j = i % 10; j < g_scope.count; j += 10) g_scope.targets[j].position_time += 1.0;
+            radar_update(&g_scope);
+        }
+        SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+        SDL_RenderClear(r);
+        radar_draw(r, FRAME_W / 2, FRAME_H / 2, FRAME_H / 2 - 10, 50.0, NULL);
+        SDL_RenderPresent(r);
+    }
+    return (now_ns() - t0) / frames / 1e3;
+}
+
+static double time_frames(int frames, void (*frame)(SDL_Renderer*, TTF_Font*, SDL_Color), SDL_Renderer* r,
+                          TTF_Font* font, SDL_Color color) {
+    double t0 = now_ns();
+    for (int i = 0; i < frames; i++) frame(r, font, color);
+    return (now_ns() - t0) / frames / 1e3;
+}
+
+int main(void) {
+    if (SDL_Init(0) != 0 || TTF_Init() != 0) {
+        fprintf(stderr, "SDL/TTF init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, FRAME_W, FRAME_H, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if (!renderer) {
+        fprintf(stderr, "Offscreen renderer setup failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    double t0 = now_ns();
+    bool prebuilt = text_init_prebuilt(renderer, FONT_SIZE);
+    double prebuilt_us = (now_ns() - t0) / 1e3;
+    text_shutdown();
+    t0 = now_ns();
+    SDL_RWops* rw = SDL_RWFromConstMem(PressStart2P_Regular_ttf, PressStart2P_Regular_ttf_len);
+    TTF_Font* font = TTF_OpenFontRW(rw, 1, FONT_SIZE);
+    if (!font || !text_init(renderer, font)) {
+        fprintf(stderr, "Offscreen renderer setup failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    double ttf_us = (now_ns() - t0) / 1e3;
+    if (prebuilt) printf("startup | prebuilt atlas %8.1f us | TTF open + rasterize %8.1f us\n", prebuilt_us, ttf_us);
+    else printf("startup | no prebuilt atlas at %d pt | TTF open + rasterize %8.1f us\n", FONT_SIZE, ttf_us);
+
+    int glyphs = 0;
+    for (int i = 0; i < FRAME_LINES; i++) glyphs += (int)strlen(g_frame_lines[i]);
+    SDL_Color white = {255, 255, 255, 255};
+    frame_atlas(renderer, font, white); // Warm-up: first use of the atlas texture
+    frame_per_line(renderer, font, white);
+
+    double atlas_us = time_frames(300, frame_atlas, renderer, font, white);
+    double line_us = time_frames(100, frame_per_line, renderer, font, white);
+    printf("%d lines, %d glyphs | atlas %8.1f us/frame (%5.0f ns/glyph) | per-line TTF %8.1f us/frame | %5.1fx\n",
+           FRAME_LINES, glyphs, atlas_us, atlas_us * 1e3 / glyphs, line_us, line_us / atlas_us);
+
+    radar_init();
+    fill_scope();
+    radar_update(&g_scope);
+    time_radar(renderer, 1, false); // Places every target once
+    double still_us = time_radar(renderer, 100, false);
+    double moving_us = time_radar(renderer, 100, true);
+    printf("radar %d targets | still %8.1f us/frame | 10%% moving %8.1f us/frame\n", RADAR_TARGETS, still_us, moving_us);
+
+    text_shutdown();
+    TTF_CloseFont(font);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    TTF_Quit();
+    SDL_Quit();
+    return 0;
+}
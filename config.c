@@ -0,0 +1,272 @@
+/**
+ * @file config.c
+ * @brief Loads the server address and observer location from `location.conf`.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+char g_server_ip[40];
+char g_sources[MAX_SOURCES][256];
+size_t g_source_count;
+double g_user_lat;
+double g_user_lon;
+struct Observer g_observer;
+char g_aircraft_db_path[256];
+bool g_api_lookups;
+enum IngestMode g_ingest_mode;
+int g_sbs_port;
+char g_fanout_group[40];
+int g_fanout_port;
+bool g_fanout_publish;
+int g_max_fps;
+bool g_vsync;
+bool g_dead_reckoning;
+bool g_radar;
+double g_radar_range_km;
+int g_track_timeout_s;
+double g_refresh_min_s;
+double g_refresh_max_s;
+bool g_warm_start;
+size_t g_table_capacity;
+int g_predict_horizon_s;
+struct GeoPoint g_zone[MAX_ZONE_POINTS];
+size_t g_zone_points;
+struct Site g_sites[MAX_SITES];
+size_t g_site_count;
+char g_record_path[256];
+char g_replay_path[256];
+double g_replay_speed = 1.0;
+double g_replay_from_s = 0.0;
+bool g_latency;
+int g_metrics_port;
+int g_stats_interval_s;
+char g_trace_path[256];
+
+/**
+ * @brief Parses an approach zone given as "lat,lon;lat,lon;..." (at least three vertices).
+ */
+static void load_zone(const char* value) {
+    g_zone_points = 0;
+    const char* p = value;
+    double lat, lon;
+    int used;
+    while (g_zone_points < MAX_ZONE_POINTS && sscanf(p, " %lf , %lf%n", &lat, &lon, &used) == 2) {
+        g_zone[g_zone_points++] = (struct GeoPoint){ lat, lon };
+        p += used;
+        while (*p == ' ' || *p == ';') p++;
+    }
+    if (g_zone_points < 3) {
+        printf("WARNING: zone needs at least three lat,lon points; ignoring it\n");
+        g_zone_points = 0;
+    }
+}
+
+/**
+ * @brief Adds a named observer given as "name,lat,lon" or "name,lat,lon,alert_km".
+ */
+static void add_site(const char* value) {
+    if (g_site_count >= MAX_SITES) {
+        printf("WARNING: Only %d sites are supported; ignoring %s\n", MAX_SITES, value);
+        return;
+    }
+    struct Site* site = &g_sites[g_site_count];
+    double lat, lon, alert_km = PROXIMITY_ALERT_KM;
+    int fields = sscanf(value, " %23[^,] , %lf , %lf , %lf", site->name, &lat, &lon, &alert_km);
+    if (fields < 3 || lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0 || alert_km <= 0.0) {
+        printf("WARNING: site must be name,lat,lon[,alert_km]; ignoring %s\n", value);
+        return;
+    }
+    observer_init(&site->obs, lat, lon);
+    site->alert_km = alert_km;
+    g_site_count++;
+}
+
+/**
+ * @brief Adds a dump1090 source given as a full URL, "host" or "host:port".
+ */
+static void add_source(const char* value) {
+    if (g_source_count >= MAX_SOURCES) {
+        printf("WARNING: Only %d sources are supported; ignoring %s\n", MAX_SOURCES, value);
+        return;
+    }
+    char* url = g_sources[g_source_count];
+    if (strstr(value, "://")) {
+        snprintf(url, sizeof(g_sources[0]), "%s", value);
+    } else if (strchr(value, ':')) {
+        snprintf(url, sizeof(g_sources[0]), "http://%s/dump1090-fa/data/aircraft.json", value);
+    } else {
+        snprintf(url, sizeof(g_sources[0]), "http://%s:%d/dump1090-fa/data/aircraft.json", value, DUMP1090_PORT);
+    }
+    g_source_count++;
+}
+
+/**
+ * @brief Loads server IP and location from `location.conf`. Falls back to defaults.
+ */
+void load_config() {
+    // Set default (dummy) values first
+    strcpy(g_server_ip, "127.0.0.1"); // Safe default
+    g_source_count = 0;
+    g_user_lat = 51.5074; // London
+    g_user_lon = -0.1278;
+    snprintf(g_aircraft_db_path, sizeof(g_aircraft_db_path), "%s", AIRCRAFT_DB_FILE);
+    g_api_lookups = true;
+    g_ingest_mode = INGEST_POLL_JSON;
+    g_sbs_port = SBS_PORT;
+    snprintf(g_fanout_group, sizeof(g_fanout_group), "%s", FANOUT_DEFAULT_GROUP);
+    g_fanout_port = FANOUT_DEFAULT_PORT;
+    g_fanout_publish = false;
+    g_max_fps = 0;
+    g_vsync = false;
+    g_dead_reckoning = true;
+    g_radar = false;
+    g_radar_range_km = RADAR_RANGE_KM;
+    g_track_timeout_s = TRACK_TIMEOUT_SECONDS;
+    g_refresh_min_s = REFRESH_MIN_SECONDS;
+    g_refresh_max_s = REFRESH_MAX_SECONDS;
+    g_warm_start = true;
+    g_table_capacity = TABLE_CAPACITY;
+    g_predict_horizon_s = PREDICT_HORIZON_SECONDS;
+    g_zone_points = 0;
+    g_site_count = 0;
+    g_record_path[0] = '\0';
+    g_latency = false;
+    g_metrics_port = 0;
+    g_stats_interval_s = STATS_INTERVAL_SECONDS;
+    g_trace_path[0] = '\0';
+
+    FILE* file = fopen("location.conf", "r");
+    if (!file) {
+        printf("INFO: location.conf not found. Using default values.\n");
+        add_source(g_server_ip);
+        observer_init(&g_observer, g_user_lat, g_user_lon);
+        return;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char* key = strtok(line, "=");
+        char* value = strtok(NULL, "\n");
+        if (key && value) {
+            if (strcmp(key, "server_ip") == 0) {
+                strncpy(g_server_ip, value, sizeof(g_server_ip) - 1);
+            } else if (strcmp(key, "source") == 0) {
+                add_source(value);
+            } else if (strcmp(key, "lat") == 0) {
+                g_user_lat = atof(value);
+            } else if (strcmp(key, "lon") == 0) {
+                g_user_lon = atof(value);
+            } else if (strcmp(key, "aircraft_db") == 0) {
+                snprintf(g_aircraft_db_path, sizeof(g_aircraft_db_path), "%s", value);
+            } else if (strcmp(key, "api_lookup") == 0) {
+                g_api_lookups = atoi(value) != 0;
+            } else if (strcmp(key, "ingest") == 0) {
+                if (strcmp(value, "sbs") == 0) g_ingest_mode = INGEST_SBS;
+                else if (strcmp(value, "json") == 0) g_ingest_mode = INGEST_POLL_JSON;
+                else if (strcmp(value, "subscribe") == 0) g_ingest_mode = INGEST_SUBSCRIBE;
+                else printf("WARNING: Unknown ingest mode '%s', polling aircraft.json\n", value);
+            } else if (strcmp(key, "sbs_port") == 0) {
+                g_sbs_port = atoi(value);
+            } else if (strcmp(key, "fanout") == 0) {
+                char group[sizeof(g_fanout_group)];
+                int port;
+                if (sscanf(value, "%39[^:]:%d", group, &port) == 2 && port > 0 && port < 65536) {
+                    snprintf(g_fanout_group, sizeof(g_fanout_group), "%s", group);
+                    g_fanout_port = port;
+                } else {
+                    printf("WARNING: fanout must be address:port, keeping %s:%d\n", g_fanout_group, g_fanout_port);
+                }
+            } else if (strcmp(key, "publish") == 0) {
+                g_fanout_publish = atoi(value) != 0;
+            } else if (strcmp(key, "max_fps") == 0) {
+                g_max_fps = atoi(value) > 0 ? atoi(value) : 0;
+            } else if (strcmp(key, "vsync") == 0) {
+                g_vsync = atoi(value) != 0;
+            } else if (strcmp(key, "dead_reckoning") == 0) {
+                g_dead_reckoning = atoi(value) != 0;
+            } else if (strcmp(key, "radar") == 0) {
+                g_radar = atoi(value) != 0;
+            } else if (strcmp(key, "radar_range") == 0) {
+                double range = atof(value);
+                if (range > 0) g_radar_range_km = fmin(fmax(range, RADAR_RANGE_MIN_KM), RADAR_RANGE_MAX_KM);
+            } else if (strcmp(key, "track_timeout") == 0) {
+                g_track_timeout_s = atoi(value);
+            } else if (strcmp(key, "refresh_min") == 0) {
+                if (atof(value) > 0) g_refresh_min_s = atof(value);
+            } else if (strcmp(key, "refresh_max") == 0) {
+                if (atof(value) > 0) g_refresh_max_s = atof(value);
+            } else if (strcmp(key, "warm_start") == 0) {
+                g_warm_start = atoi(value) != 0;
+            } else if (strcmp(key, "table_capacity") == 0) {
+                long capacity = atol(value);
+                g_table_capacity = capacity > TABLE_CAPACITY_MIN ? (size_t)capacity : TABLE_CAPACITY_MIN;
+            } else if (strcmp(key, "predict_horizon") == 0) {
+                g_predict_horizon_s = atoi(value) > 0 ? atoi(value) : 0;
+            } else if (strcmp(key, "site") == 0) {
+                add_site(value);
+            } else if (strcmp(key, "zone") == 0) {
+                load_zone(value);
+            } else if (strcmp(key, "record") == 0) {
+                snprintf(g_record_path, sizeof(g_record_path), "%s", value);
+            } else if (strcmp(key, "latency") == 0) {
+                g_latency = atoi(value) != 0;
+            } else if (strcmp(key, "metrics_port") == 0) {
+                g_metrics_port = atoi(value) > 0 && atoi(value) < 65536 ? atoi(value) : 0;
+            } else if (strcmp(key, "stats_interval") == 0) {
+                g_stats_interval_s = atoi(value) > 0 ? atoi(value) : 0;
+            } else if (strcmp(key, "trace") == 0) {
+                snprintf(g_trace_path, sizeof(g_trace_path), "%s", value);
+            }
+        }
+    }
+    fclose(file);
+    if (g_refresh_max_s < g_refresh_min_s) g_refresh_max_s = g_refresh_min_s;
+    // An aircraft must survive at least two of the slowest polls before it is dropped
+    int min_timeout = (int)ceil(2.0 * g_refresh_max_s);
+    if (min_timeout < REFRESH_INTERVAL_SECONDS) min_timeout = REFRESH_INTERVAL_SECONDS;
+    if (g_track_timeout_s < min_timeout) g_track_timeout_s = min_timeout;
+    if (g_source_count == 0) add_source(g_server_ip); // No source= lines: the single server_ip receiver
+    observer_init(&g_observer, g_user_lat, g_user_lon);
+    printf("INFO: Loaded settings from location.conf\n");
+}
+
+/**
+ * @brief Applies command-line options on top of location.conf.
+ * @return false after printing usage if the arguments are invalid.
+ */
+bool parse_arguments(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--replay") == 0 && value) {
+            snprintf(g_replay_path, sizeof(g_replay_path), "%s", value);
+            g_ingest_mode = INGEST_REPLAY;
+        } else if (strcmp(arg, "--speed") == 0 && value && atof(value) >= 0) {
+            g_replay_speed = atof(value);
+        } else if (strcmp(arg, "--from") == 0 && value && atof(value) >= 0) {
+            g_replay_from_s = atof(value);
+        } else if (strcmp(arg, "--record") == 0 && value) {
+            snprintf(g_record_path, sizeof(g_record_path), "%s", value);
+        } else if (strcmp(arg, "--trace") == 0 && value) {
+            snprintf(g_trace_path, sizeof(g_trace_path), "%s", value);
+        } else {
+            fprintf(stderr, "Usage: %s [--record log] [--replay log [--speed N] [--from seconds]] [--trace trace.json]\n",
+                    argv[0]);
+            return false;
+        }
+        i++;
+    }
+    if (g_ingest_mode == INGEST_REPLAY) {
+        // Details come from the database and cache only, and fixes are shown as recorded. Fan-out
+        // subscribers still dead-reckon from them; replay.c keeps the published fix times on this clock for that
+        g_api_lookups = false;
+        g_dead_reckoning = false;
+        g_record_path[0] = '\0';
+    }
+    return true;
+}
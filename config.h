@@ -0,0 +1,111 @@
+/**
+ * @file config.h
+ * @brief Compile-time defaults and the runtime settings loaded from `location.conf`.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+
+#include "geo.h"
+#include "geo_batch.h"
+
+// --- Configuration ---
+#define REFRESH_INTERVAL_SECONDS 5 // Poll interval after a cycle in which no receiver answered
+#define REFRESH_MIN_SECONDS 1.0   // Default for refresh_min: dump1090 rewrites aircraft.json about once a second
+#define REFRESH_MAX_SECONDS 20.0  // Default for refresh_max: the interval when nothing is near
+#define REFRESH_MAX_CLOSURE_KTS 600.0 // Fastest closure assumed for aircraft other than the closest one
+#define PROXIMITY_ALERT_KM 5.0
+#define DUMP1090_PORT 8080
+#define MAX_SOURCES 8 // dump1090 receivers polled concurrently
+#define SOURCE_TIMEOUT_SECONDS 4 // Below REFRESH_INTERVAL_SECONDS, so a dead receiver cannot stretch a retry
+#define SBS_PORT 30003 // dump1090 BaseStation output
+#define FANOUT_DEFAULT_GROUP "239.255.42.99" // Administratively scoped multicast
+#define FANOUT_DEFAULT_PORT 30155
+#define TRACK_TIMEOUT_SECONDS 60 // Default for track_timeout: aircraft not heard for this long are dropped
+#define TABLE_CAPACITY 3072 // Default for table_capacity: aircraft tracked at once
+#define TABLE_CAPACITY_MIN 64
+#define PREDICT_HORIZON_SECONDS 120 // Default for predict_horizon: how far ahead approaches are predicted
+#define RADAR_RANGE_KM 50.0 // Default for radar_range: radius of the radar view
+#define RADAR_RANGE_MIN_KM 5.0 // Zoom limits for the +/- keys
+#define RADAR_RANGE_MAX_KM 800.0
+#define STATS_INTERVAL_SECONDS 60 // Default for stats_interval: headless latency summary cadence
+
+#define WARM_STATE_FILE "warm_state.bin" // Tracked aircraft saved at shutdown for warm_start
+
+// Enrichment cache (registration/type/operator lookups)
+#define ENRICH_CACHE_FILE "enrich_cache.bin"
+#define ENRICH_CACHE_MAX_ENTRIES 2048 // Power of two
+#define ENRICH_POSITIVE_TTL_SECONDS (24 * 60 * 60)
+#define ENRICH_NEGATIVE_TTL_SECONDS (60 * 60)
+#define AIRCRAFT_DB_FILE "aircraft.db" // Built with `make acdb`; optional
+#define ENRICH_API_TIMEOUT_SECONDS 3 // Deadline for one api.adsb.lol lookup
+#define ENRICH_POLL_MS 100 // Slice the worker waits on a lookup before re-checking stop and the refresh deadline
+#define ENRICH_BREAKER_THRESHOLD 3 // Consecutive failures that open the circuit breaker
+#define ENRICH_BREAKER_BASE_SECONDS 30.0
+#define ENRICH_BREAKER_MAX_SECONDS (15 * 60.0)
+
+#define MAX_ZONE_POINTS 16 // Vertices of the approach-monitoring polygon
+#define MAX_SITES 512      // Named observer points (site= lines)
+
+// Frame pacing
+#define DEAD_RECKON_MAX_SECONDS 20.0 // Longest gap an aircraft is projected across between fixes
+#define IDLE_WAKE_MS 1000 // On-demand mode: longest wait for an event before re-checking the snapshot
+
+// A named observer point with its own alert radius
+struct Site {
+    char name[24];
+    struct Observer obs;
+    double alert_km;
+};
+
+enum IngestMode {
+    INGEST_POLL_JSON = 0, // Poll aircraft.json every refresh_min to refresh_max seconds
+    INGEST_SBS,           // Keep a BaseStation (port 30003) stream open
+    INGEST_SUBSCRIBE,     // Receive snapshots from a publishing instance; no dump1090 or API traffic
+    INGEST_REPLAY,        // Feed a recorded log (--replay) through the pipeline; no network at all
+};
+
+// Configuration globals
+extern char g_server_ip[40];
+extern char g_sources[MAX_SOURCES][256]; // aircraft.json URLs; defaults to server_ip's
+extern size_t g_source_count;
+extern double g_user_lat;
+extern double g_user_lon;
+extern struct Observer g_observer; // g_user_lat/g_user_lon with their trig terms precomputed
+extern char g_aircraft_db_path[256];
+extern bool g_api_lookups; // false: never call api.adsb.lol (offline installs)
+extern enum IngestMode g_ingest_mode;
+extern int g_sbs_port;
+extern char g_fanout_group[40]; // Address snapshots are published to and subscribed from
+extern int g_fanout_port;
+extern bool g_fanout_publish;   // Send every snapshot to the fan-out address
+extern int g_max_fps; // 0: redraw only when something changes; N: continuous redraw capped at N fps
+extern bool g_vsync;
+extern bool g_dead_reckoning; // Project positions between fixes using speed and track
+extern bool g_radar;            // Start in the radar view instead of the closest-aircraft panel
+extern double g_radar_range_km; // Radar view radius at startup
+extern int g_track_timeout_s; // Seconds without a message before an aircraft leaves the table
+extern double g_refresh_min_s; // Bounds of the adaptive poll interval
+extern double g_refresh_max_s;
+extern bool g_warm_start; // Restore the table from WARM_STATE_FILE, or else dump1090's history, at startup
+extern size_t g_table_capacity; // Aircraft the table and per-cycle scratch are sized for, allocated at startup
+extern int g_predict_horizon_s; // Look-ahead of the closest-point-of-approach alert; 0: off
+extern struct GeoPoint g_zone[MAX_ZONE_POINTS]; // Approach zone polygon; unused with fewer than 3 points
+extern size_t g_zone_points;
+extern struct Site g_sites[MAX_SITES]; // Evaluated every cycle alongside the main lat/lon
+extern size_t g_site_count;
+extern char g_record_path[256]; // Append every polled cycle to this replay log; empty: off
+extern char g_replay_path[256];
+extern double g_replay_speed;   // 1: recorded pace; 0: as fast as possible
+extern double g_replay_from_s;  // Seconds of recording to skip
+extern bool g_latency;          // Record per-stage latency histograms from startup
+extern int g_metrics_port;      // Serve the histograms as Prometheus text; 0: off
+extern int g_stats_interval_s;  // Headless: seconds between stats lines while recording
+extern char g_trace_path[256];  // Write a Chrome trace of cycles, transfers and frames here; empty: off
+
+void load_config();
+bool parse_arguments(int argc, char** argv);
+
+#endif // CONFIG_H
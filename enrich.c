@@ -0,0 +1,201 @@
+/**
+ * @file enrich.c
+ * @brief Registration/type/operator lookup for an aircraft by ICAO address.
+ *
+ * Runs on the fetch worker thread. Owns the offline database mapping, the
+ * enrichment cache and the persistent api.adsb.lol handle.
+ *
+ * Database and cache answers are immediate. An API lookup never blocks the
+ * cycle: enrich_aircraft() starts it in the background and reports
+ * ENRICH_SOURCE_PENDING, and the worker drives it with enrich_poll() between
+ * refreshes, patching the details into the next snapshot when they arrive.
+ * Only one lookup is in flight at a time, bounded by ENRICH_API_TIMEOUT_SECONDS.
+ *
+ * A circuit breaker protects the API: after ENRICH_BREAKER_THRESHOLD failures
+ * in a row (errors, timeouts, 429 or 5xx), lookups stop for a backoff that
+ * doubles with every further failure, up to ENRICH_BREAKER_MAX_SECONDS. When it
+ * expires a single trial lookup decides whether to close the breaker again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <cjson/cJSON.h>
+
+#include "acdb.h"
+#include "config.h"
+#include "enrich.h"
+#include "enrich_cache.h"
+#include "http.h"
+#include "latency.h"
+#include "timeutil.h"
+
+static struct HttpEndpoint g_api_endpoint;
+static char g_pending_hex[10]; // Address of the lookup in flight; empty when idle
+static int g_api_failures = 0; // Consecutive failed lookups
+static double g_breaker_open_until = 0.0; // monotonic_seconds() before which no lookup is started
+
+/**
+ * @brief Opens the offline database, reloads the cache and creates the API handle.
+ */
+void enrich_init() {
+    acdb_open(g_aircraft_db_path);
+    enrich_cache_load(ENRICH_CACHE_FILE, time(NULL));
+    http_endpoint_init(&g_api_endpoint, "adsb.lol", ENRICH_API_TIMEOUT_SECONDS);
+    g_pending_hex[0] = '\0';
+    g_api_failures = 0;
+    g_breaker_open_until = 0.0;
+}
+
+/**
+ * @brief Saves the cache and releases everything opened by enrich_init().
+ */
+void enrich_shutdown() {
+    http_endpoint_cleanup(&g_api_endpoint);
+    enrich_cache_save(ENRICH_CACHE_FILE, time(NULL));
+    acdb_close();
+}
+
+/**
+ * @brief Parses an api.adsb.lol reply for one aircraft's registration details.
+ * @return An ENRICH_* result; ENRICH_MISS means the reply was unusable and nothing should be cached.
+ */
+static enum EnrichLookup parse_api_reply(const struct HttpEndpoint* ep, struct Enrichment* info) {
+    enum EnrichLookup result = ENRICH_MISS;
+    bool api_ok = ep->last.ok && ep->last.status == 200;
+    const struct MemoryStruct* api_chunk = &ep->body;
+    if (api_ok && api_chunk->size > 0) {
+        cJSON *api_root = cJSON_Parse(api_chunk->memory);
+        if(api_root) {
+            cJSON *ac_array = cJSON_GetObjectItemCaseSensitive(api_root, "ac");
+            if (cJSON_IsArray(ac_array) && cJSON_GetArraySize(ac_array) > 0) {
+                result = ENRICH_HIT;
+                cJSON *ac_info = cJSON_GetArrayItem(ac_array, 0);
+                cJSON *item;
+                item = cJSON_GetObjectItemCaseSensitive(ac_info, "r");
+                if (item && item->valuestring) snprintf(info->registration, sizeof(info->registration), "%s", item->valuestring);
+                item = cJSON_GetObjectItemCaseSensitive(ac_info, "t");
+                if (item && item->valuestring) snprintf(info->aircraft_type, sizeof(info->aircraft_type), "%s", item->valuestring);
+                item = cJSON_GetObjectItemCaseSensitive(ac_info, "operator");
+                if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
+                    snprintf(info->operator, sizeof(info->operator), "%s", item->valuestring);
+                } else {
+                    // Fallback keys used by some APIs
+                    item = cJSON_GetObjectItemCaseSensitive(ac_info, "ownOp");
+                    if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
+                        snprintf(info->operator, sizeof(info->operator), "%s", item->valuestring);
+                    } else {
+                        item = cJSON_GetObjectItemCaseSensitive(ac_info, "op");
+                        if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
+                            snprintf(info->operator, sizeof(info->operator), "%s", item->valuestring);
+                        }
+                    }
+                }
+            } else if (cJSON_IsArray(ac_array)) {
+                result = ENRICH_HIT_NEGATIVE; // Valid reply, but the API has no record
+            }
+            cJSON_Delete(api_root);
+        }
+    }
+    return result;
+}
+
+static void reset_enrichment(struct Enrichment* info) {
+    snprintf(info->registration, sizeof(info->registration), "N/A");
+    snprintf(info->aircraft_type, sizeof(info->aircraft_type), "N/A");
+    snprintf(info->operator, sizeof(info->operator), "N/A");
+}
+
+static bool breaker_allows(double now) {
+    return g_api_failures < ENRICH_BREAKER_THRESHOLD || now >= g_breaker_open_until;
+}
+
+static void breaker_record(bool ok, double now) {
+    if (ok) {
+        if (g_api_failures >= ENRICH_BREAKER_THRESHOLD) printf("INFO: adsb.lol is answering again\n");
+        g_api_failures = 0;
+        return;
+    }
+    g_api_failures++;
+    if (g_api_failures < ENRICH_BREAKER_THRESHOLD) return;
+    double backoff = ENRICH_BREAKER_BASE_SECONDS;
+    for (int i = ENRICH_BREAKER_THRESHOLD; i < g_api_failures && backoff < ENRICH_BREAKER_MAX_SECONDS; i++) backoff *= 2;
+    if (backoff > ENRICH_BREAKER_MAX_SECONDS) backoff = ENRICH_BREAKER_MAX_SECONDS;
+    g_breaker_open_until = now + backoff;
+    fprintf(stderr, "WARNING: adsb.lol failed %d times in a row, pausing lookups for %.0f s\n", g_api_failures, backoff);
+}
+
+/**
+ * @brief Fills registration/type/operator for an aircraft (normally the closest one).
+ * Sources in order: offline database, enrichment cache, then the online API. An API
+ * lookup is only started here; its details arrive later through enrich_poll().
+ */
+enum EnrichSource enrich_aircraft(struct Aircraft* closest, struct TransferStats* api_stats) {
+    (void)api_stats; // Filled by enrich_poll() once a lookup completes
+    struct Enrichment info;
+    reset_enrichment(&info);
+
+    uint32_t icao = 0;
+    bool cacheable = icao_from_hex(closest->hex, &icao);
+    enum EnrichSource source = ENRICH_SOURCE_NONE;
+
+    if (cacheable && acdb_lookup(icao, &info)) {
+        aircraft_apply_enrichment(closest, &info);
+        return ENRICH_SOURCE_DATABASE;
+    }
+
+    enum EnrichLookup cached = cacheable ? enrich_cache_get(icao, time(NULL), &info) : ENRICH_MISS;
+    if (cached != ENRICH_MISS) {
+        source = ENRICH_SOURCE_CACHE;
+    } else if (g_api_lookups) {
+        double now = monotonic_seconds();
+        if (g_pending_hex[0] != '\0') {
+            // One lookup at a time; a different aircraft simply asks again on a later cycle
+            source = ENRICH_SOURCE_PENDING;
+        } else if (!breaker_allows(now)) {
+            source = ENRICH_SOURCE_BACKOFF;
+        } else {
+            char api_url[256];
+            snprintf(api_url, sizeof(api_url), "https://api.adsb.lol/v2/hex/%s", closest->hex);
+            if (http_start(&g_api_endpoint, api_url)) {
+                snprintf(g_pending_hex, sizeof(g_pending_hex), "%s", closest->hex);
+                source = ENRICH_SOURCE_PENDING;
+            }
+        }
+    }
+    aircraft_apply_enrichment(closest, &info);
+    return source;
+}
+
+bool enrich_pending() {
+    return g_pending_hex[0] != '\0';
+}
+
+/**
+ * @brief Advances the lookup in flight, waiting up to `timeout_ms`.
+ * @return true when a lookup finished; `out` then says for which aircraft and whether it succeeded.
+ */
+bool enrich_poll(int timeout_ms, struct EnrichResult* out) {
+    if (!enrich_pending() || !http_poll(&g_api_endpoint, timeout_ms)) return false;
+
+    memset(out, 0, sizeof(*out));
+    snprintf(out->hex, sizeof(out->hex), "%s", g_pending_hex);
+    g_pending_hex[0] = '\0';
+    out->stats = g_api_endpoint.last;
+    latency_record(LAT_API, out->stats.total_ms / 1000.0);
+    reset_enrichment(&out->info);
+
+    enum EnrichLookup result = parse_api_reply(&g_api_endpoint, &out->info);
+    long status = g_api_endpoint.last.status;
+    bool degraded = !g_api_endpoint.last.ok || status == 429 || status >= 500;
+    breaker_record(!degraded, monotonic_seconds());
+
+    out->ok = result != ENRICH_MISS;
+    uint32_t icao;
+    if (out->ok && icao_from_hex(out->hex, &icao)) {
+        enrich_cache_put(icao, result == ENRICH_HIT ? &out->info : NULL, time(NULL));
+    }
+    return true;
+}
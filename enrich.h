@@ -0,0 +1,35 @@
+/**
+ * @file enrich.h
+ * @brief Registration/type/operator lookup: offline database, cache, then the online API.
+ */
+
+#ifndef ENRICH_H
+#define ENRICH_H
+
+#include "aircraft.h"
+#include "http.h"
+
+enum EnrichSource {
+    ENRICH_SOURCE_NONE = 0, // No lookup result (no plane, or the API request failed)
+    ENRICH_SOURCE_DATABASE, // Offline aircraft database
+    ENRICH_SOURCE_CACHE,
+    ENRICH_SOURCE_API,
+    ENRICH_SOURCE_PENDING, // API lookup in flight; details follow in a later snapshot
+    ENRICH_SOURCE_BACKOFF, // API circuit breaker open; no lookup was made
+};
+
+// A finished API lookup, as reported by enrich_poll()
+struct EnrichResult {
+    char hex[10];              // The aircraft it was for
+    struct Enrichment info;    // "N/A" fields unless `ok` and the API knew the aircraft
+    struct TransferStats stats;
+    bool ok;                   // Valid reply (cached, even if the API had no record)
+};
+
+void enrich_init();
+void enrich_shutdown();
+enum EnrichSource enrich_aircraft(struct Aircraft* ac, struct TransferStats* api_stats);
+bool enrich_pending();
+bool enrich_poll(int timeout_ms, struct EnrichResult* out);
+
+#endif // ENRICH_H
@@ -0,0 +1,272 @@
+/**
+ * @file enrich_cache.c
+ * @brief Open-addressing hash cache for API enrichment results, persisted across runs.
+ *
+ * Registration, type and operator almost never change, yet the closest aircraft
+ * used to be looked up again on every refresh. Results are kept here keyed by
+ * the 24-bit ICAO address with a long TTL for found aircraft and a shorter one
+ * for addresses the API has no record of. The table is a fixed-size linear-probing
+ * array (no per-entry allocation); when it reaches ENRICH_CACHE_MAX_ENTRIES the
+ * least recently used entry is evicted.
+ *
+ * On-disk format (native endianness, written at shutdown and read at startup):
+ *   "CPEC" u32 version u32 count, then per record:
+ *   u32 icao, u8 negative, i64 expires, and for positive records three
+ *   length-prefixed strings (u8 length + bytes): registration, type, operator.
+ * Records are written oldest-use first so reloading preserves the LRU order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "enrich_cache.h"
+
+#define CACHE_SLOTS (ENRICH_CACHE_MAX_ENTRIES * 2) // Keep load factor at or below 0.5
+#define CACHE_MASK (CACHE_SLOTS - 1)
+#define CACHE_FILE_MAGIC "CPEC"
+#define CACHE_FILE_VERSION 1u
+
+#if (CACHE_SLOTS & CACHE_MASK) != 0
+#error "ENRICH_CACHE_MAX_ENTRIES must be a power of two"
+#endif
+
+struct CacheEntry {
+    uint32_t icao;
+    bool used;
+    bool negative;
+    int64_t expires;
+    uint64_t last_used;
+    struct Enrichment info;
+};
+
+static struct CacheEntry g_slots[CACHE_SLOTS];
+static size_t g_count = 0;
+static uint64_t g_use_clock = 0;
+static struct EnrichCacheStats g_stats;
+
+static uint32_t home_slot(uint32_t icao) {
+    return (icao * 2654435761u) & CACHE_MASK; // Knuth multiplicative hash
+}
+
+static int find_slot(uint32_t icao) {
+    for (uint32_t i = home_slot(icao), n = 0; n < CACHE_SLOTS; i = (i + 1) & CACHE_MASK, n++) {
+        if (!g_slots[i].used) return -1;
+        if (g_slots[i].icao == icao) return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Removes a slot using backward-shift deletion, so probe chains stay intact without tombstones.
+ */
+static void remove_slot(uint32_t i) {
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & CACHE_MASK;
+        if (!g_slots[j].used) break;
+        uint32_t k = home_slot(g_slots[j].icao);
+        // Leave slot j alone if its home lies cyclically in (i, j]
+        bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            g_slots[i] = g_slots[j];
+            i = j;
+        }
+    }
+    g_slots[i].used = false;
+    g_count--;
+}
+
+/**
+ * @brief Evicts one entry: an expired one if there is any, otherwise the least recently used.
+ */
+static void evict_one(time_t now) {
+    int victim = -1;
+    for (uint32_t i = 0; i < CACHE_SLOTS; i++) {
+        if (!g_slots[i].used) continue;
+        if (g_slots[i].expires <= now) {
+            victim = (int)i;
+            break;
+        }
+        if (victim < 0 || g_slots[i].last_used < g_slots[victim].last_used) victim = (int)i;
+    }
+    if (victim >= 0) {
+        remove_slot((uint32_t)victim);
+        g_stats.evictions++;
+    }
+}
+
+static void insert(uint32_t icao, const struct Enrichment* info, int64_t expires, time_t now) {
+    int slot = find_slot(icao);
+    if (slot < 0) {
+        if (g_count >= ENRICH_CACHE_MAX_ENTRIES) evict_one(now);
+        uint32_t i = home_slot(icao);
+        while (g_slots[i].used) i = (i + 1) & CACHE_MASK;
+        slot = (int)i;
+        g_count++;
+    }
+    struct CacheEntry* e = &g_slots[slot];
+    e->icao = icao;
+    e->used = true;
+    e->negative = (info == NULL);
+    e->expires = expires;
+    e->last_used = ++g_use_clock;
+    if (info) e->info = *info; else memset(&e->info, 0, sizeof(e->info));
+}
+
+void enrich_cache_clear() {
+    memset(g_slots, 0, sizeof(g_slots));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_count = 0;
+    g_use_clock = 0;
+}
+
+/**
+ * @brief Looks up an address. Expired entries are dropped and reported as a miss.
+ */
+enum EnrichLookup enrich_cache_get(uint32_t icao, time_t now, struct Enrichment* out) {
+    int slot = find_slot(icao);
+    if (slot >= 0 && g_slots[slot].expires <= now) {
+        remove_slot((uint32_t)slot);
+        slot = -1;
+    }
+    if (slot < 0) {
+        g_stats.misses++;
+        return ENRICH_MISS;
+    }
+    struct CacheEntry* e = &g_slots[slot];
+    e->last_used = ++g_use_clock;
+    if (e->negative) {
+        g_stats.negative_hits++;
+        return ENRICH_HIT_NEGATIVE;
+    }
+    *out = e->info;
+    g_stats.hits++;
+    return ENRICH_HIT;
+}
+
+/**
+ * @brief Stores a lookup result. Pass `info == NULL` to record that the API has no data.
+ */
+void enrich_cache_put(uint32_t icao, const struct Enrichment* info, time_t now) {
+    int64_t ttl = info ? ENRICH_POSITIVE_TTL_SECONDS : ENRICH_NEGATIVE_TTL_SECONDS;
+    insert(icao, info, (int64_t)now + ttl, now);
+}
+
+size_t enrich_cache_count() { return g_count; }
+
+struct EnrichCacheStats enrich_cache_stats() { return g_stats; }
+
+
+// --- Persistence ---
+
+static int compare_last_used(const void* a, const void* b) {
+    uint64_t ua = g_slots[*(const uint32_t*)a].last_used;
+    uint64_t ub = g_slots[*(const uint32_t*)b].last_used;
+    return (ua > ub) - (ua < ub);
+}
+
+static bool write_string(FILE* f, const char* s) {
+    size_t len = strlen(s);
+    if (len > 255) len = 255;
+    uint8_t len8 = (uint8_t)len;
+    return fwrite(&len8, 1, 1, f) == 1 && fwrite(s, 1, len, f) == len;
+}
+
+static bool read_string(FILE* f, char* dst, size_t dst_size) {
+    uint8_t len8;
+    char tmp[256];
+    if (fread(&len8, 1, 1, f) != 1) return false;
+    if (len8 > 0 && fread(tmp, 1, len8, f) != len8) return false;
+    tmp[len8] = '\0';
+    snprintf(dst, dst_size, "%s", tmp);
+    return true;
+}
+
+/**
+ * @brief Writes all unexpired entries to `path` (via a temporary file and rename).
+ */
+bool enrich_cache_save(const char* path, time_t now) {
+    static uint32_t order[ENRICH_CACHE_MAX_ENTRIES];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < CACHE_SLOTS && n < ENRICH_CACHE_MAX_ENTRIES; i++) {
+        if (g_slots[i].used && g_slots[i].expires > now) order[n++] = i;
+    }
+    qsort(order, n, sizeof(order[0]), compare_last_used);
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "WARNING: Could not write enrichment cache %s\n", tmp_path);
+        return false;
+    }
+
+    uint32_t version = CACHE_FILE_VERSION;
+    bool ok = fwrite(CACHE_FILE_MAGIC, 1, 4, f) == 4 &&
+              fwrite(&version, sizeof(version), 1, f) == 1 &&
+              fwrite(&n, sizeof(n), 1, f) == 1;
+    for (uint32_t k = 0; ok && k < n; k++) {
+        const struct CacheEntry* e = &g_slots[order[k]];
+        uint8_t negative = e->negative ? 1 : 0;
+        ok = fwrite(&e->icao, sizeof(e->icao), 1, f) == 1 &&
+             fwrite(&negative, 1, 1, f) == 1 &&
+             fwrite(&e->expires, sizeof(e->expires), 1, f) == 1;
+        if (ok && !e->negative) {
+            ok = write_string(f, e->info.registration) &&
+                 write_string(f, e->info.aircraft_type) &&
+                 write_string(f, e->info.operator);
+        }
+    }
+    if (fclose(f) != 0) ok = false;
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "WARNING: Failed to save enrichment cache to %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces the cache contents with the unexpired entries stored in `path`.
+ * A missing file is not an error; a corrupt one is discarded.
+ */
+bool enrich_cache_load(const char* path, time_t now) {
+    enrich_cache_clear();
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint32_t version = 0, n = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, CACHE_FILE_MAGIC, 4) == 0 &&
+              fread(&version, sizeof(version), 1, f) == 1 && version == CACHE_FILE_VERSION &&
+              fread(&n, sizeof(n), 1, f) == 1;
+
+    for (uint32_t k = 0; ok && k < n; k++) {
+        uint32_t icao;
+        uint8_t negative;
+        int64_t expires;
+        struct Enrichment info;
+        memset(&info, 0, sizeof(info));
+        ok = fread(&icao, sizeof(icao), 1, f) == 1 &&
+             fread(&negative, 1, 1, f) == 1 &&
+             fread(&expires, sizeof(expires), 1, f) == 1;
+        if (ok && !negative) {
+            ok = read_string(f, info.registration, sizeof(info.registration)) &&
+                 read_string(f, info.aircraft_type, sizeof(info.aircraft_type)) &&
+                 read_string(f, info.operator, sizeof(info.operator));
+        }
+        if (ok && expires > now) insert(icao, negative ? NULL : &info, expires, now);
+    }
+    fclose(f);
+
+    if (!ok) {
+        fprintf(stderr, "WARNING: Ignoring corrupt enrichment cache %s\n", path);
+        enrich_cache_clear();
+        return false;
+    }
+    printf("INFO: Loaded %zu cached aircraft lookups from %s\n", g_count, path);
+    return true;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file enrich_cache.h
+ * @brief ICAO-keyed cache of registration/type/operator lookups with TTLs and LRU bound.
+ *
+ * Owned by the fetch worker thread; not thread-safe.
+ */
+
+#ifndef ENRICH_CACHE_H
+#define ENRICH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "aircraft.h"
+
+enum EnrichLookup {
+    ENRICH_MISS = 0,
+    ENRICH_HIT,          // Cached details copied to `out`
+    ENRICH_HIT_NEGATIVE, // The API is known to have nothing for this address
+};
+
+struct EnrichCacheStats {
+    unsigned long hits, negative_hits, misses, evictions;
+};
+
+void enrich_cache_clear();
+enum EnrichLookup enrich_cache_get(uint32_t icao, time_t now, struct Enrichment* out);
+void enrich_cache_put(uint32_t icao, const struct Enrichment* info, time_t now);
+size_t enrich_cache_count();
+struct EnrichCacheStats enrich_cache_stats();
+bool enrich_cache_load(const char* path, time_t now);
+bool enrich_cache_save(const char* path, time_t now);
+
+#endif // ENRICH_CACHE_H
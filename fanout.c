@@ -0,0 +1,373 @@
+/**
+ * @file fanout.c
+ * @brief Publishes each snapshot as one UDP datagram and turns received datagrams back into snapshots.
+ *
+ * A publishing instance (publish=1) sends to the `fanout` address, normally an
+ * IPv4 multicast group, whenever the snapshot content changes, and at least
+ * every FANOUT_KEEPALIVE_S so late joiners catch up. Subscribers (ingest=subscribe)
+ * never contact dump1090 or the API; they decode the datagrams and hand them to
+ * the display like any other snapshot.
+ *
+ * Each datagram carries the complete displayed state (closest aircraft, traffic
+ * panel, counts, predicted breaches) in 300 to 600 bytes, so a lost packet costs
+ * nothing but latency.
+ * All fields are big-endian; strings are length-prefixed. Layout:
+ *
+ *   "CPF1" | u32 seq | f64 fix_age_s | payload
+ *
+ * fix_age_s replaces the publisher-local monotonic position_time; it sits in the
+ * header so that change detection can compare payloads alone. The predicted
+ * breaches come last, so a subscriber that predates them simply stops reading
+ * before them, and a packet without them decodes with none.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "fanout.h"
+#include "timeutil.h"
+
+#define FANOUT_MAGIC "CPF1"
+#define FANOUT_HEADER 16 // Magic, seq and fix age
+#define FANOUT_KEEPALIVE_S 10.0 // Above REFRESH_INTERVAL_SECONDS, so unchanged polling cycles stay quiet
+#define FANOUT_STALE_S (3 * FANOUT_KEEPALIVE_S) // Subscriber gives up on a silent publisher
+#define FANOUT_POLL_MS 250
+#define FANOUT_TTL 1 // Multicast stays on the local network
+
+static int g_pub_fd = -1;
+static struct sockaddr_in g_pub_addr;
+static uint32_t g_pub_seq = 0;
+static uint8_t g_last_payload[FANOUT_MAX_PACKET];
+static size_t g_last_payload_len = 0;
+static double g_last_send = 0.0;
+
+
+// --- Wire encoding ---
+
+struct Wire {
+    uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+};
+
+static void put_bytes(struct Wire* w, const void* src, size_t n) {
+    if (!w->ok || (size_t)(w->end - w->p) < n) { w->ok = false; return; }
+    memcpy(w->p, src, n);
+    w->p += n;
+}
+
+static void put_u8(struct Wire* w, uint8_t v) { put_bytes(w, &v, 1); }
+
+static void put_u32(struct Wire* w, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+    put_bytes(w, b, 4);
+}
+
+static void put_f64(struct Wire* w, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(w, (uint32_t)(bits >> 32));
+    put_u32(w, (uint32_t)bits);
+}
+
+static void put_str(struct Wire* w, const char* s, size_t max) {
+    size_t n = strnlen(s, max - 1);
+    put_u8(w, (uint8_t)n);
+    put_bytes(w, s, n);
+}
+
+static void get_bytes(struct Wire* w, void* dst, size_t n) {
+    if (!w->ok || (size_t)(w->end - w->p) < n) { w->ok = false; memset(dst, 0, n); return; }
+    memcpy(dst, w->p, n);
+    w->p += n;
+}
+
+static uint8_t get_u8(struct Wire* w) {
+    uint8_t v;
+    get_bytes(w, &v, 1);
+    return v;
+}
+
+static uint32_t get_u32(struct Wire* w) {
+    uint8_t b[4];
+    get_bytes(w, b, 4);
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+}
+
+static double get_f64(struct Wire* w) {
+    uint64_t bits = (uint64_t)get_u32(w) << 32;
+    bits |= get_u32(w);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void get_str(struct Wire* w, char* dst, size_t max) {
+    size_t n = get_u8(w);
+    if (n >= max) { w->ok = false; n = 0; }
+    get_bytes(w, dst, n);
+    dst[n] = '\0';
+}
+
+/**
+ * @brief Serializes the displayed parts of `snap`.
+ * @param now monotonic_seconds() at send time, used to turn position_time into an age.
+ * @return The packet length, or 0 if `len` is too small.
+ */
+size_t fanout_encode(const struct Snapshot* snap, uint32_t seq, double now, uint8_t* out, size_t len) {
+    const struct Aircraft* ac = &snap->closest;
+    struct Wire w = { out, out + len, true };
+    put_bytes(&w, FANOUT_MAGIC, 4);
+    put_u32(&w, seq);
+    put_f64(&w, ac->position_time > 0.0 ? now - ac->position_time : -1.0);
+
+    put_u8(&w, snap->plane_found);
+    put_u8(&w, (uint8_t)snap->enrich_source);
+    put_str(&w, ac->flight, sizeof(ac->flight));
+    put_str(&w, ac->hex, sizeof(ac->hex));
+    put_str(&w, ac->squawk, sizeof(ac->squawk));
+    put_str(&w, ac->registration, sizeof(ac->registration));
+    put_str(&w, ac->aircraft_type, sizeof(ac->aircraft_type));
+    put_str(&w, ac->operator, sizeof(ac->operator));
+    put_f64(&w, ac->lat);
+    put_f64(&w, ac->lon);
+    put_f64(&w, ac->distance_km);
+    put_f64(&w, ac->bearing_deg);
+    put_f64(&w, ac->ground_speed_kts);
+    put_f64(&w, ac->track_deg);
+    put_u32(&w, (uint32_t)ac->altitude_ft);
+    put_u32(&w, (uint32_t)ac->vert_rate_fpm);
+
+    put_u32(&w, (uint32_t)snap->in_radius_count);
+    put_u32(&w, (uint32_t)snap->in_zone_count);
+    put_u8(&w, (uint8_t)snap->traffic_count);
+    for (int i = 0; i < snap->traffic_count; i++) {
+        const struct TrafficEntry* e = &snap->traffic[i];
+        put_str(&w, e->label, sizeof(e->label));
+        put_f64(&w, e->distance_km);
+        put_u32(&w, (uint32_t)e->altitude_ft);
+    }
+
+    int listed = snap->predicted_count < SNAPSHOT_PREDICTED_MAX ? snap->predicted_count : SNAPSHOT_PREDICTED_MAX;
+    put_u32(&w, (uint32_t)snap->predicted_count);
+    put_u8(&w, (uint8_t)listed);
+    for (int i = 0; i < listed; i++) {
+        const struct PredictedEntry* e = &snap->predicted[i];
+        put_str(&w, e->label, sizeof(e->label));
+        put_str(&w, e->hex, sizeof(e->hex));
+        put_f64(&w, e->t_enter_s);
+        put_f64(&w, e->cpa_km);
+        put_u32(&w, (uint32_t)e->altitude_ft);
+    }
+    return w.ok ? (size_t)(w.p - out) : 0;
+}
+
+/**
+ * @brief Parses a packet from fanout_encode() into `snap`; transfer and scan stats are zeroed.
+ * @param now monotonic_seconds() at receive time, so position_time stays usable for dead reckoning.
+ * @return false if the packet is truncated or not a fan-out packet.
+ */
+bool fanout_decode(const uint8_t* in, size_t len, double now, struct Snapshot* snap, uint32_t* seq) {
+    struct Wire w = { (uint8_t*)in, in + len, true };
+    char magic[4];
+    get_bytes(&w, magic, 4);
+    if (!w.ok || memcmp(magic, FANOUT_MAGIC, 4) != 0) return false;
+
+    struct Snapshot s;
+    memset(&s, 0, sizeof(s));
+    struct Aircraft* ac = &s.closest;
+    *seq = get_u32(&w);
+    double fix_age = get_f64(&w);
+
+    s.plane_found = get_u8(&w) != 0;
+    s.enrich_source = (enum EnrichSource)get_u8(&w);
+    get_str(&w, ac->flight, sizeof(ac->flight));
+    get_str(&w, ac->hex, sizeof(ac->hex));
+    get_str(&w, ac->squawk, sizeof(ac->squawk));
+    get_str(&w, ac->registration, sizeof(ac->registration));
+    get_str(&w, ac->aircraft_type, sizeof(ac->aircraft_type));
+    get_str(&w, ac->operator, sizeof(ac->operator));
+    ac->lat = get_f64(&w);
+    ac->lon = get_f64(&w);
+    ac->distance_km = get_f64(&w);
+    ac->bearing_deg = get_f64(&w);
+    ac->ground_speed_kts = get_f64(&w);
+    ac->track_deg = get_f64(&w);
+    ac->altitude_ft = (int32_t)get_u32(&w);
+    ac->vert_rate_fpm = (int32_t)get_u32(&w);
+    ac->position_time = fix_age >= 0.0 ? now - fix_age : 0.0;
+
+    s.in_radius_count = (int32_t)get_u32(&w);
+    s.in_zone_count = (int32_t)get_u32(&w);
+    s.traffic_count = get_u8(&w);
+    if (s.traffic_count > SNAPSHOT_TRAFFIC_MAX) return false;
+    for (int i = 0; i < s.traffic_count; i++) {
+        struct TrafficEntry* e = &s.traffic[i];
+        get_str(&w, e->label, sizeof(e->label));
+        e->distance_km = get_f64(&w);
+        e->altitude_ft = (int32_t)get_u32(&w);
+    }
+    if (w.ok && w.p < w.end) {
+        s.predicted_count = (int32_t)get_u32(&w);
+        int listed = get_u8(&w);
+        if (listed > SNAPSHOT_PREDICTED_MAX) return false;
+        for (int i = 0; i < listed; i++) {
+            struct PredictedEntry* e = &s.predicted[i];
+            get_str(&w, e->label, sizeof(e->label));
+            get_str(&w, e->hex, sizeof(e->hex));
+            e->t_enter_s = get_f64(&w);
+            e->cpa_km = get_f64(&w);
+            e->altitude_ft = (int32_t)get_u32(&w);
+        }
+    }
+    if (!w.ok) return false;
+    *snap = s;
+    return true;
+}
+
+
+// --- Publisher ---
+
+static bool parse_group(const char* group, int port, struct sockaddr_in* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons((uint16_t)port);
+    return inet_pton(AF_INET, group, &addr->sin_addr) == 1;
+}
+
+/**
+ * @brief Opens the sending socket. `group` may also be a unicast or broadcast IPv4 address.
+ */
+bool fanout_open_publisher(const char* group, int port) {
+    if (!parse_group(group, port, &g_pub_addr)) {
+        fprintf(stderr, "ERROR: fanout address '%s' is not an IPv4 address\n", group);
+        return false;
+    }
+    g_pub_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (g_pub_fd < 0) {
+        fprintf(stderr, "ERROR: Failed to open the fan-out socket: %s\n", strerror(errno));
+        return false;
+    }
+    unsigned char ttl = FANOUT_TTL;
+    int on = 1;
+    setsockopt(g_pub_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(g_pub_fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    g_last_payload_len = 0;
+    printf("INFO: Publishing snapshots to %s:%d\n", group, port);
+    return true;
+}
+
+/**
+ * @brief Sends `snap` if its content changed since the last packet or the keepalive is due.
+ */
+void fanout_send(const struct Snapshot* snap) {
+    if (g_pub_fd < 0) return;
+    uint8_t packet[FANOUT_MAX_PACKET];
+    double now = monotonic_seconds();
+    size_t len = fanout_encode(snap, g_pub_seq + 1, now, packet, sizeof(packet));
+    if (len == 0) return;
+
+    size_t payload_len = len - FANOUT_HEADER;
+    bool same = payload_len == g_last_payload_len && memcmp(packet + FANOUT_HEADER, g_last_payload, payload_len) == 0;
+    if (same && now - g_last_send < FANOUT_KEEPALIVE_S) return;
+
+    if (sendto(g_pub_fd, packet, len, 0, (const struct sockaddr*)&g_pub_addr, sizeof(g_pub_addr)) < 0) {
+        fprintf(stderr, "WARNING: Fan-out send failed: %s\n", strerror(errno));
+        return;
+    }
+    g_pub_seq++;
+    memcpy(g_last_payload, packet + FANOUT_HEADER, payload_len);
+    g_last_payload_len = payload_len;
+    g_last_send = now;
+}
+
+void fanout_close_publisher() {
+    if (g_pub_fd >= 0) close(g_pub_fd);
+    g_pub_fd = -1;
+}
+
+
+// --- Subscriber ---
+
+static int open_subscriber(const char* group, int port) {
+    struct sockaddr_in addr;
+    if (!parse_group(group, port, &addr)) {
+        fprintf(stderr, "ERROR: fanout address '%s' is not an IPv4 address\n", group);
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)); // Several displays on one host
+
+    struct sockaddr_in bind_addr = addr;
+    bool multicast = IN_MULTICAST(ntohl(addr.sin_addr.s_addr));
+    if (!multicast) bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (const struct sockaddr*)&bind_addr, sizeof(bind_addr)) != 0) {
+        fprintf(stderr, "ERROR: Failed to bind fan-out port %d: %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (multicast) {
+        struct ip_mreq mreq = { .imr_multiaddr = addr.sin_addr, .imr_interface.s_addr = htonl(INADDR_ANY) };
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            fprintf(stderr, "ERROR: Failed to join multicast group %s: %s\n", group, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+/**
+ * @brief Receives snapshots until `stop` is set, in place of fetching. Runs on the fetch worker thread.
+ */
+void fanout_subscribe_run(const char* group, int port, struct Snapshot* snap, const atomic_bool* stop, SnapshotSink publish) {
+    int fd = open_subscriber(group, port);
+    if (fd < 0) return;
+    printf("INFO: Subscribed to snapshots on %s:%d\n", group, port);
+
+    uint32_t last_seq = 0;
+    double last_packet = 0.0;
+    bool have_packet = false, reported_stale = false;
+    while (!atomic_load(stop)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, FANOUT_POLL_MS);
+        double now = monotonic_seconds();
+
+        if (ready > 0) {
+            uint8_t packet[FANOUT_MAX_PACKET];
+            ssize_t got = recv(fd, packet, sizeof(packet), 0);
+            uint32_t seq;
+            struct Snapshot s;
+            if (got > 0 && fanout_decode(packet, (size_t)got, now, &s, &seq)) {
+                // Drop reordered packets, unless the publisher went quiet (it may have restarted)
+                bool fresh = !have_packet || (int32_t)(seq - last_seq) > 0 || now - last_packet > FANOUT_KEEPALIVE_S * 2;
+                if (fresh) {
+                    *snap = s;
+                    publish(snap);
+                    last_seq = seq;
+                    last_packet = now;
+                    have_packet = true;
+                    reported_stale = false;
+                }
+            }
+        }
+
+        if (have_packet && !reported_stale && now - last_packet > FANOUT_STALE_S) {
+            memset(snap, 0, sizeof(*snap));
+            aircraft_reset(&snap->closest, "Publisher not responding");
+            snap->in_zone_count = -1;
+            publish(snap);
+            reported_stale = true;
+        }
+    }
+    close(fd);
+}
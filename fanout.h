@@ -0,0 +1,26 @@
+/**
+ * @file fanout.h
+ * @brief Fan-out of snapshots over UDP: one publisher computes, any number of displays subscribe.
+ */
+
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+#define FANOUT_MAX_PACKET 1024
+
+size_t fanout_encode(const struct Snapshot* snap, uint32_t seq, double now, uint8_t* out, size_t len);
+bool fanout_decode(const uint8_t* in, size_t len, double now, struct Snapshot* snap, uint32_t* seq);
+
+bool fanout_open_publisher(const char* group, int port);
+void fanout_send(const struct Snapshot* snap);
+void fanout_close_publisher();
+void fanout_subscribe_run(const char* group, int port, struct Snapshot* snap, const atomic_bool* stop, SnapshotSink publish);
+
+#endif // FANOUT_H
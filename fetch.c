@@ -0,0 +1,358 @@
+/**
+ * @file fetch.c
+ * @brief Fetches aircraft data from dump1090 and the ADSB API on a dedicated thread.
+ *
+ * The worker owns all blocking network I/O. Each finished cycle is handed to the
+ * render loop through the snapshot seqlock, so a slow server can delay the data
+ * but never the window or its event handling.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "aircraft.h"
+#include "aircraft_json.h"
+#include "aircraft_table.h"
+#include "config.h"
+#include "enrich.h"
+#include "fanout.h"
+#include "fetch.h"
+#include "geo.h"
+#include "geo_batch.h"
+#include "http.h"
+#include "latency.h"
+#include "replay.h"
+#include "sbs.h"
+#include "scan.h"
+#include "scope.h"
+#include "timeutil.h"
+#include "trace.h"
+#include "warmstart.h"
+
+// --- Worker state ---
+static pthread_t g_fetch_thread;
+static pthread_mutex_t g_fetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_fetch_wake;
+static atomic_bool g_fetch_stop = false;
+static atomic_bool g_fetch_poll_now = false; // Cut the current poll wait short, see fetch_worker_poll_now()
+static bool g_fetch_running = false;
+static SnapshotCallback g_on_snapshot = NULL;
+static void* g_on_snapshot_userdata = NULL;
+// Persistent per-endpoint handles, created and used only on the worker thread
+static struct HttpEndpoint g_dump1090_endpoints[MAX_SOURCES]; // One per g_sources entry
+
+
+/**
+ * @brief Hands a finished snapshot to readers and wakes the display.
+ */
+static void publish_snapshot(const struct Snapshot* snap) {
+    snapshot_publish(snap);
+    if (g_fanout_publish) fanout_send(snap);
+    if (g_on_snapshot) g_on_snapshot(g_on_snapshot_userdata);
+}
+
+/**
+ * @brief The end of a cycle: eviction, every selection, then enrichment of the closest aircraft.
+ */
+static void select_and_enrich(struct Snapshot* snap, double now) {
+    double t = latency_start();
+    scan_evict(now, &snap->scan_stats);
+
+    // Select from the indexed table; the full record is built once, for the winner
+    bool found = scan_select_closest(snap, &g_observer);
+    select_traffic(snap, &g_observer);
+    select_sites(snap);
+    select_predicted(snap, &g_observer, now);
+    scope_update(&g_observer);
+    latency_end(LAT_SELECT, t);
+    if (found) {
+        // Cached details are shown instantly; a miss starts an API lookup that lands in a later publish
+        t = latency_start();
+        snap->enrich_source = enrich_aircraft(&snap->closest, &snap->api_stats);
+        latency_end(LAT_ENRICH, t);
+    }
+}
+
+/**
+ * @brief Publishes what the last run knew, before the first live cycle. The saved state needs no network.
+ * @return true if the table should be backfilled from dump1090's history once the first live cycle is out.
+ */
+static bool warm_start(struct Snapshot* snap) {
+    size_t restored = warmstart_load_state(WARM_STATE_FILE);
+    if (g_ingest_mode != INGEST_POLL_JSON) return false; // The SBS loop publishes from the table itself
+    if (restored == 0) return true;
+    memset(&snap->scan_stats, 0, sizeof(snap->scan_stats));
+    snap->enrich_source = ENRICH_SOURCE_NONE;
+    scan_begin_cycle();
+    select_and_enrich(snap, monotonic_seconds());
+    publish_snapshot(snap);
+    return false;
+}
+
+/**
+ * @brief Drives a pending API lookup until it finishes or `deadline` passes; stop is checked every ENRICH_POLL_MS.
+ * A lookup for the aircraft still shown is patched into `snap` and republished.
+ */
+static void await_enrichment(struct Snapshot* snap, const struct timespec* deadline) {
+    struct EnrichResult result;
+    while (enrich_pending() && !atomic_load(&g_fetch_stop)) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long left_ms = (long)(deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+        if (left_ms <= 0) return; // Still in flight; the next cycle keeps driving it
+        if (!enrich_poll(left_ms < ENRICH_POLL_MS ? (int)left_ms : ENRICH_POLL_MS, &result)) continue;
+        if (snap->plane_found && strcmp(result.hex, snap->closest.hex) == 0) {
+            aircraft_apply_enrichment(&snap->closest, &result.info);
+            snap->enrich_source = result.ok ? ENRICH_SOURCE_API : ENRICH_SOURCE_NONE;
+            snap->api_stats = result.stats;
+            publish_snapshot(snap);
+        }
+    }
+}
+
+/**
+ * @brief Seconds until the next poll, from how soon anything could reach the alert radius.
+ * The closest aircraft is polled about four times before its closure rate (ground speed
+ * along the line to the observer) would bring it inside, and at least once before its
+ * full ground speed could if it turned. Every other aircraft is at least as far out as
+ * the second nearest, and is assumed to close at up to REFRESH_MAX_CLOSURE_KTS. A
+ * predicted breach by any aircraft is also polled about four times before it happens. The
+ * result is clamped to refresh_min..refresh_max; a cycle where no receiver answered
+ * retries after REFRESH_INTERVAL_SECONDS.
+ */
+static double next_poll_interval(const struct Snapshot* snap, bool updated) {
+    if (!updated) return fmin(fmax(REFRESH_INTERVAL_SECONDS, g_refresh_min_s), g_refresh_max_s);
+    if (!snap->plane_found) return g_refresh_max_s;
+
+    const struct Aircraft* ac = &snap->closest;
+    double margin_km = ac->distance_km - PROXIMITY_ALERT_KM;
+    if (margin_km <= 0.0) return g_refresh_min_s;
+
+    double kts_to_kms = 1.852 / 3600.0;
+    double interval = g_refresh_max_s;
+    if (ac->ground_speed_kts > 0.0) {
+        interval = margin_km / (ac->ground_speed_kts * kts_to_kms);
+        // Heading straight for the observer means a track opposite to the observer's bearing to it
+        double closing_kts = ac->ground_speed_kts * cos(deg2rad(ac->track_deg - (ac->bearing_deg + 180.0)));
+        if (closing_kts > 0.0) interval = fmin(interval, margin_km / (closing_kts * kts_to_kms) / 4.0);
+    }
+    if (snap->traffic_count > 1) {
+        double others_km = snap->traffic[1].distance_km - PROXIMITY_ALERT_KM;
+        interval = fmin(interval, fmax(others_km, 0.0) / (REFRESH_MAX_CLOSURE_KTS * kts_to_kms));
+    }
+    if (snap->predicted_count > 0) interval = fmin(interval, snap->predicted[0].t_enter_s / 4.0);
+    return fmin(fmax(interval, g_refresh_min_s), g_refresh_max_s);
+}
+
+/**
+ * @brief Releases the dump1090 endpoints and the fan-out socket opened at worker start.
+ */
+static void close_sources() {
+    for (size_t i = 0; i < g_source_count; i++) http_endpoint_cleanup(&g_dump1090_endpoints[i]);
+    fanout_close_publisher();
+}
+
+/**
+ * @brief Worker thread body: fetch, publish, then sleep until the next refresh or a stop request.
+ */
+static void* fetch_thread_main(void* arg) {
+    (void)arg;
+    trace_thread_name("fetch");
+    struct Snapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    aircraft_reset(&snap.closest, "Waiting for data...");
+
+    if (g_ingest_mode == INGEST_SUBSCRIBE) {
+        // Another instance does the fetching; it must not be configured to publish back
+        g_fanout_publish = false;
+        fanout_subscribe_run(g_fanout_group, g_fanout_port, &snap, &g_fetch_stop, publish_snapshot);
+        return NULL;
+    }
+    if (g_fanout_publish && !fanout_open_publisher(g_fanout_group, g_fanout_port)) g_fanout_publish = false;
+
+    for (size_t i = 0; i < g_source_count; i++) {
+        http_endpoint_init(&g_dump1090_endpoints[i], "dump1090", SOURCE_TIMEOUT_SECONDS);
+        http_endpoint_set_conditional(&g_dump1090_endpoints[i], true);
+    }
+    if (!scan_init(g_table_capacity)) {
+        // Without a table nothing can be tracked; say so rather than waiting for data forever
+        aircraft_reset(&snap.closest, "Out of memory");
+        publish_snapshot(&snap);
+        close_sources();
+        return NULL;
+    }
+    enrich_init();
+    bool live = g_ingest_mode == INGEST_POLL_JSON || g_ingest_mode == INGEST_SBS;
+    bool backfill = live && g_warm_start && warm_start(&snap);
+
+    if (g_ingest_mode == INGEST_SBS) {
+        sbs_ingest_run(g_server_ip, g_sbs_port, &snap, &g_fetch_stop, publish_snapshot);
+    } else if (g_ingest_mode == INGEST_REPLAY) {
+        replay_run(g_replay_path, g_replay_speed, g_replay_from_s, &snap, &g_fetch_stop, publish_snapshot);
+    } else if (g_record_path[0]) {
+        replay_record_open(g_record_path);
+    }
+
+    while (!atomic_load(&g_fetch_stop)) {
+        double cycle_start = latency_start();
+        bool updated = fetch_and_process_data(&snap);
+        latency_end(LAT_CYCLE, cycle_start);
+        double interval = next_poll_interval(&snap, updated);
+        snap.next_refresh_s = interval;
+        if (updated) publish_snapshot(&snap);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        long interval_ns = (long)(interval * 1e9) % 1000000000L;
+        deadline.tv_sec += (time_t)interval + (deadline.tv_nsec + interval_ns) / 1000000000L;
+        deadline.tv_nsec = (deadline.tv_nsec + interval_ns) % 1000000000L;
+        await_enrichment(&snap, &deadline);
+        // One history round trip per cycle, after the lookups; the trails land in the cycle after the last
+        if (backfill && updated) backfill = warmstart_backfill_step();
+
+        pthread_mutex_lock(&g_fetch_lock);
+        while (!atomic_load(&g_fetch_stop) && !atomic_exchange(&g_fetch_poll_now, false)) {
+            if (pthread_cond_timedwait(&g_fetch_wake, &g_fetch_lock, &deadline) != 0) break;
+        }
+        pthread_mutex_unlock(&g_fetch_lock);
+    }
+
+    if (backfill) warmstart_backfill_cancel();
+    replay_record_close();
+    if (live && g_warm_start) warmstart_save_state(WARM_STATE_FILE);
+    enrich_shutdown();
+    close_sources();
+    return NULL;
+}
+
+/**
+ * @brief Starts the background fetch thread. The first fetch begins immediately.
+ */
+bool fetch_worker_start(SnapshotCallback on_snapshot, void* userdata) {
+    if (g_fetch_running) return true;
+
+    if (!http_init(&g_fetch_stop)) return false;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_fetch_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_on_snapshot = on_snapshot;
+    g_on_snapshot_userdata = userdata;
+    atomic_store(&g_fetch_stop, false);
+    if (g_latency || g_metrics_port > 0) latency_enable(true);
+    if (g_metrics_port > 0) latency_serve_metrics(g_metrics_port);
+    if (g_trace_path[0]) trace_open(g_trace_path);
+
+    if (pthread_create(&g_fetch_thread, NULL, fetch_thread_main, NULL) != 0) {
+        fprintf(stderr, "ERROR: Failed to start fetch thread\n");
+        pthread_cond_destroy(&g_fetch_wake);
+        http_cleanup();
+        return false;
+    }
+    g_fetch_running = true;
+    return true;
+}
+
+/**
+ * @brief Starts the next poll now instead of at the end of the current interval. Any thread.
+ * Only affects polling mode; the SBS and replay loops publish continuously anyway.
+ */
+void fetch_worker_poll_now() {
+    if (!g_fetch_running) return;
+    pthread_mutex_lock(&g_fetch_lock);
+    atomic_store(&g_fetch_poll_now, true);
+    pthread_cond_signal(&g_fetch_wake);
+    pthread_mutex_unlock(&g_fetch_lock);
+}
+
+/**
+ * @brief Signals the fetch thread to exit and waits for it. In-flight transfers are aborted.
+ */
+void fetch_worker_stop() {
+    if (!g_fetch_running) return;
+
+    pthread_mutex_lock(&g_fetch_lock);
+    atomic_store(&g_fetch_stop, true);
+    pthread_cond_signal(&g_fetch_wake);
+    pthread_mutex_unlock(&g_fetch_lock);
+
+    pthread_join(g_fetch_thread, NULL);
+    pthread_cond_destroy(&g_fetch_wake);
+    latency_stop_metrics();
+    trace_close();
+    http_cleanup();
+    g_fetch_running = false;
+}
+
+/**
+ * @brief Feeds one finished dump1090 transfer's curl phase timings into the stage histograms.
+ */
+static void record_transfer_latency(const struct TransferStats* st) {
+    if (!atomic_load_explicit(&g_latency_on, memory_order_relaxed) || !st->ok) return;
+    latency_record(LAT_DNS, st->dns_ms / 1000.0);
+    latency_record(LAT_CONNECT, st->connect_ms / 1000.0);
+    if (st->tls_ms > 0.0) latency_record(LAT_TLS, st->tls_ms / 1000.0); // Plain-HTTP receivers have no handshake
+    latency_record(LAT_WAIT, st->wait_ms / 1000.0);
+    latency_record(LAT_TRANSFER, st->transfer_ms / 1000.0);
+}
+
+/**
+ * @brief Fetches data from every dump1090 source and the ADSB API, then updates `snap`.
+ * Sources are fetched concurrently, so a cycle takes as long as the slowest one.
+ * @return true if `snap` was updated and should be published, false if every source failed.
+ */
+bool fetch_and_process_data(struct Snapshot* snap) {
+    struct HttpEndpoint* eps[MAX_SOURCES];
+    const char* urls[MAX_SOURCES];
+    for (size_t i = 0; i < g_source_count; i++) {
+        eps[i] = &g_dump1090_endpoints[i];
+        urls[i] = g_sources[i];
+    }
+    http_get_all(eps, urls, g_source_count);
+
+    memset(&snap->dump1090_stats, 0, sizeof(snap->dump1090_stats));
+    memset(&snap->api_stats, 0, sizeof(snap->api_stats));
+    memset(&snap->scan_stats, 0, sizeof(snap->scan_stats));
+    snap->enrich_source = ENRICH_SOURCE_NONE;
+    scan_begin_cycle();
+    snap->sources_total = (int)g_source_count;
+    snap->sources_ok = 0;
+
+    double fetched_at = monotonic_seconds();
+
+    // Merge every answering receiver into the table; the freshest position per aircraft wins
+    unsigned long long wire_total = 0, plain_total = 0;
+    for (size_t i = 0; i < g_source_count; i++) {
+        const struct HttpEndpoint* ep = eps[i];
+        record_transfer_latency(&ep->last);
+        if (ep->last.total_ms > snap->dump1090_stats.total_ms) snap->dump1090_stats = ep->last;
+        wire_total += ep->last.wire_total;
+        plain_total += ep->last.plain_total;
+        if (ep->last.not_modified) {
+            // dump1090 has not rewritten the file: the table already holds its contents
+            snap->sources_ok++;
+            continue;
+        }
+        if (!ep->last.ok || ep->body.size == 0) continue;
+        const struct ParsedAircraft* parsed;
+        long count = scan_ingest_document(ep->body.memory, ep->body.size, fetched_at, (uint8_t)i, &snap->scan_stats, &parsed);
+        if (count < 0) continue;
+        replay_record_source((uint8_t)i, parsed, (size_t)count);
+        snap->sources_ok++;
+    }
+    snap->dump1090_stats.wire_total = wire_total;
+    snap->dump1090_stats.plain_total = plain_total;
+    if (snap->sources_ok == 0) return false;
+    replay_record_cycle();
+    select_and_enrich(snap, fetched_at);
+    return true;
+}
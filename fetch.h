@@ -0,0 +1,24 @@
+/**
+ * @file fetch.h
+ * @brief Background network worker that polls dump1090 and publishes snapshots.
+ */
+
+#ifndef FETCH_H
+#define FETCH_H
+
+#include <stdbool.h>
+
+#include "snapshot.h"
+
+/**
+ * @brief Called on the worker thread right after a new snapshot has been published.
+ * Must be cheap and thread-safe (e.g. pushing an SDL event).
+ */
+typedef void (*SnapshotCallback)(void* userdata);
+
+bool fetch_worker_start(SnapshotCallback on_snapshot, void* userdata);
+void fetch_worker_stop();
+void fetch_worker_poll_now();
+bool fetch_and_process_data(struct Snapshot* snap);
+
+#endif // FETCH_H
@@ -0,0 +1,77 @@
+/**
+ * @file geo.c
+ * @brief Great-circle distance, bearing and compass helpers.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "geo.h"
+
+double deg2rad(double deg) { return (deg * M_PI / 180.0); }
+
+double haversine_distance(double lat1, double lon1, double lat2, double lon2) {
+    double dLat = deg2rad(lat2 - lat1);
+    double dLon = deg2rad(lon2 - lon1);
+    double a = sin(dLat / 2) * sin(dLat / 2) + cos(deg2rad(lat1)) * cos(deg2rad(lat2)) * sin(dLon / 2) * sin(dLon / 2);
+    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+    return EARTH_RADIUS_KM * c;
+}
+
+/**
+ * @brief Calculates the initial bearing from point 1 to point 2.
+ * @return The bearing in degrees (0-360).
+ */
+double calculate_bearing(double lat1, double lon1, double lat2, double lon2) {
+    double lon_diff = deg2rad(lon2 - lon1);
+    lat1 = deg2rad(lat1);
+    lat2 = deg2rad(lat2);
+    double y = sin(lon_diff) * cos(lat2);
+    double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon_diff);
+    double bearing = atan2(y, x);
+    bearing = fmod((bearing * 180.0 / M_PI + 360.0), 360.0); // Convert to degrees and normalize
+    return bearing;
+}
+
+/**
+ * @brief Point reached by travelling `distance_km` along the great circle leaving (lat, lon) at `bearing_deg`.
+ */
+void destination_point(double lat, double lon, double bearing_deg, double distance_km, double* out_lat, double* out_lon) {
+    double angular = distance_km / EARTH_RADIUS_KM;
+    double theta = deg2rad(bearing_deg);
+    double lat1 = deg2rad(lat);
+    double lat2 = asin(sin(lat1) * cos(angular) + cos(lat1) * sin(angular) * cos(theta));
+    double lon2 = deg2rad(lon) + atan2(sin(theta) * sin(angular) * cos(lat1), cos(angular) - sin(lat1) * sin(lat2));
+    *out_lat = lat2 * 180.0 / M_PI;
+    *out_lon = fmod(lon2 * 180.0 / M_PI + 540.0, 360.0) - 180.0;
+}
+
+/**
+ * @brief Even-odd ray cast in plain lat/lon; fine for airport-sized polygons that do not cross the antimeridian.
+ */
+bool point_in_polygon(const struct GeoPoint* poly, size_t n_points, double lat, double lon) {
+    bool inside = false;
+    for (size_t i = 0, j = n_points - 1; i < n_points; j = i++) {
+        const struct GeoPoint* a = &poly[i];
+        const struct GeoPoint* b = &poly[j];
+        if ((a->lat > lat) != (b->lat > lat) &&
+            lon < (b->lon - a->lon) * (lat - a->lat) / (b->lat - a->lat) + a->lon) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+const char* track_to_direction(double track_deg) {
+    static const char *directions[] = {"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"};
+    int index = (int)((track_deg / 22.5) + 0.5) % 16;
+    return directions[index];
+}
+
+const char* get_squawk_description(const char* squawk) {
+    if (strcmp(squawk, "7700") == 0) return "General Emergency";
+    if (strcmp(squawk, "7600") == 0) return "Radio Failure";
+    if (strcmp(squawk, "7500") == 0) return "Hijacking";
+    if (strcmp(squawk, "7000") == 0) return "VFR Conspicuity";
+    return "Discrete Code";
+}
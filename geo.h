@@ -0,0 +1,26 @@
+/**
+ * @file geo.h
+ * @brief Great-circle distance, bearing and compass helpers.
+ */
+
+#ifndef GEO_H
+#define GEO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EARTH_RADIUS_KM 6371.0
+
+struct GeoPoint {
+    double lat, lon;
+};
+
+double deg2rad(double deg);
+double haversine_distance(double lat1, double lon1, double lat2, double lon2);
+double calculate_bearing(double lat1, double lon1, double lat2, double lon2);
+void destination_point(double lat, double lon, double bearing_deg, double distance_km, double* out_lat, double* out_lon);
+bool point_in_polygon(const struct GeoPoint* poly, size_t n_points, double lat, double lon);
+const char* track_to_direction(double track_deg);
+const char* get_squawk_description(const char* squawk);
+
+#endif // GEO_H
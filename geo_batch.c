@@ -0,0 +1,303 @@
+/**
+ * @file geo_batch.c
+ * @brief Batch nearest/radius queries: a vectorized equirectangular pre-filter, exact haversine on the survivors.
+ *
+ * The observer's sin/cos are computed once instead of per aircraft. The pre-filter
+ * works on structure-of-arrays positions so it maps onto SIMD registers; it is
+ * written with GCC/Clang vector extensions rather than per-ISA intrinsics, so the
+ * same code becomes SSE2, AVX2 (with -mavx2 or -march=native) or NEON. The only
+ * transcendental it needs, cos of the mid-latitude, is a short even polynomial.
+ * Only aircraft whose approximate distance is within a small margin of the best
+ * (or of the radius) go through the exact great-circle formula.
+ *
+ * The closest-point-of-approach kernel uses the same local flat-earth frame:
+ * each aircraft is a position and a constant ground velocity relative to the
+ * observer, so the time of closest approach has a closed form and the whole
+ * pass is a handful of multiply-adds per aircraft with no branches.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "geo.h"
+#include "geo_batch.h"
+
+#define DEG_TO_RAD (M_PI / 180.0)
+
+// The equirectangular approximation is within a fraction of a percent of the
+// great-circle distance at receiver ranges; these margins keep the filter exact.
+#define PREFILTER_SLACK 1.02
+#define PREFILTER_ABS_KM 0.1
+
+void observer_init(struct Observer* obs, double lat, double lon) {
+    obs->lat = lat;
+    obs->lon = lon;
+    obs->lat_rad = deg2rad(lat);
+    obs->lon_rad = deg2rad(lon);
+    obs->sin_lat = sin(obs->lat_rad);
+    obs->cos_lat = cos(obs->lat_rad);
+}
+
+/**
+ * @brief haversine_distance() from the observer, reusing its cached cos(lat).
+ */
+double observer_distance_km(const struct Observer* obs, double lat, double lon) {
+    double lat_rad = deg2rad(lat);
+    double s_lat = sin((lat_rad - obs->lat_rad) / 2);
+    double s_lon = sin(deg2rad(lon - obs->lon) / 2);
+    double a = s_lat * s_lat + obs->cos_lat * cos(lat_rad) * s_lon * s_lon;
+    return EARTH_RADIUS_KM * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+/**
+ * @brief calculate_bearing() from the observer, reusing its cached sin/cos(lat).
+ * @return The bearing in degrees (0-360).
+ */
+double observer_bearing(const struct Observer* obs, double lat, double lon) {
+    double lon_diff = deg2rad(lon - obs->lon);
+    double lat_rad = deg2rad(lat);
+    double cos_lat2 = cos(lat_rad);
+    double y = sin(lon_diff) * cos_lat2;
+    double x = obs->cos_lat * sin(lat_rad) - obs->sin_lat * cos_lat2 * cos(lon_diff);
+    return fmod(atan2(y, x) * 180.0 / M_PI + 360.0, 360.0);
+}
+
+bool position_batch_init(struct PositionBatch* b, size_t capacity) {
+    memset(b, 0, sizeof(*b));
+    b->lat = malloc(capacity * sizeof(*b->lat));
+    b->lon = malloc(capacity * sizeof(*b->lon));
+    b->ref = malloc(capacity * sizeof(*b->ref));
+    b->scratch = malloc(capacity * sizeof(*b->scratch));
+    if (!b->lat || !b->lon || !b->ref || !b->scratch) {
+        position_batch_free(b);
+        return false;
+    }
+    b->capacity = capacity;
+    return true;
+}
+
+void position_batch_free(struct PositionBatch* b) {
+    free(b->lat);
+    free(b->lon);
+    free(b->ref);
+    free(b->scratch);
+    memset(b, 0, sizeof(*b));
+}
+
+void position_batch_clear(struct PositionBatch* b) { b->count = 0; }
+
+bool position_batch_add(struct PositionBatch* b, double lat, double lon, uint32_t ref) {
+    if (b->count >= b->capacity) return false;
+    b->lat[b->count] = lat;
+    b->lon[b->count] = lon;
+    b->ref[b->count] = ref;
+    b->count++;
+    return true;
+}
+
+// cos(x) for |x| <= pi/2 (a latitude), error below 1e-6.
+#define COS_POLY(x2) (1.0 + (x2) * (-1.0 / 2 + (x2) * (1.0 / 24 + (x2) * (-1.0 / 720 + (x2) * (1.0 / 40320 + (x2) * (-1.0 / 3628800))))))
+
+static inline double approx_distance_sq(const struct Observer* obs, double lat, double lon) {
+    double dlon = lon - obs->lon;
+    if (dlon > 180.0) dlon -= 360.0;
+    else if (dlon < -180.0) dlon += 360.0;
+    double mid = (lat + obs->lat) * (0.5 * DEG_TO_RAD);
+    double mid2 = mid * mid;
+    double x = dlon * DEG_TO_RAD * COS_POLY(mid2);
+    double y = (lat - obs->lat) * DEG_TO_RAD;
+    return (x * x + y * y) * (EARTH_RADIUS_KM * EARTH_RADIUS_KM);
+}
+
+/**
+ * @brief Writes the approximate squared distance (km^2) of every batch entry to `out_km_sq`.
+ */
+void batch_approx_distance_sq(const struct Observer* obs, const struct PositionBatch* b, double* out_km_sq) {
+    size_t i = 0;
+#if defined(__GNUC__)
+    typedef double vdouble __attribute__((vector_size(32)));
+    typedef long long vmask __attribute__((vector_size(32)));
+    const vdouble obs_lat = { obs->lat, obs->lat, obs->lat, obs->lat };
+    const vdouble obs_lon = { obs->lon, obs->lon, obs->lon, obs->lon };
+    const vdouble half_circle = { 180.0, 180.0, 180.0, 180.0 };
+    const vdouble full_circle = { 360.0, 360.0, 360.0, 360.0 };
+    for (; i + 4 <= b->count; i += 4) {
+        vdouble lat, lon;
+        memcpy(&lat, &b->lat[i], sizeof(lat));
+        memcpy(&lon, &b->lon[i], sizeof(lon));
+        vdouble dlon = lon - obs_lon;
+        vmask over = dlon > half_circle, under = dlon < -half_circle;
+        dlon -= (vdouble)((vmask)full_circle & over);
+        dlon += (vdouble)((vmask)full_circle & under);
+        vdouble mid = (lat + obs_lat) * (0.5 * DEG_TO_RAD);
+        vdouble mid2 = mid * mid;
+        vdouble x = dlon * DEG_TO_RAD * COS_POLY(mid2);
+        vdouble y = (lat - obs_lat) * DEG_TO_RAD;
+        vdouble d2 = (x * x + y * y) * (EARTH_RADIUS_KM * EARTH_RADIUS_KM);
+        memcpy(&out_km_sq[i], &d2, sizeof(d2));
+    }
+#endif
+    for (; i < b->count; i++) out_km_sq[i] = approx_distance_sq(obs, b->lat[i], b->lon[i]);
+}
+
+/**
+ * @brief Finds the batch entry closest to the observer.
+ * @return false if the batch is empty.
+ */
+bool batch_nearest(const struct Observer* obs, struct PositionBatch* b, struct BatchHit* hit) {
+    if (b->count == 0) return false;
+    batch_approx_distance_sq(obs, b, b->scratch);
+
+    double min_sq = b->scratch[0];
+    for (size_t i = 1; i < b->count; i++) {
+        if (b->scratch[i] < min_sq) min_sq = b->scratch[i];
+    }
+    double limit = sqrt(min_sq) * PREFILTER_SLACK + PREFILTER_ABS_KM;
+    double limit_sq = limit * limit;
+
+    bool found = false;
+    for (size_t i = 0; i < b->count; i++) {
+        if (b->scratch[i] > limit_sq) continue;
+        double d = observer_distance_km(obs, b->lat[i], b->lon[i]);
+        if (!found || d < hit->distance_km) {
+            found = true;
+            hit->slot = i;
+            hit->ref = b->ref[i];
+            hit->distance_km = d;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Collects entries strictly closer than `radius_km`, in batch order.
+ * @return The number of matches; only the first `max_out` are written.
+ */
+size_t batch_within(const struct Observer* obs, struct PositionBatch* b, double radius_km,
+                    struct BatchHit* out, size_t max_out) {
+    if (b->count == 0) return 0;
+    batch_approx_distance_sq(obs, b, b->scratch);
+    double limit = radius_km * PREFILTER_SLACK + PREFILTER_ABS_KM;
+    double limit_sq = limit * limit;
+
+    size_t n = 0;
+    for (size_t i = 0; i < b->count; i++) {
+        if (b->scratch[i] > limit_sq) continue;
+        double d = observer_distance_km(obs, b->lat[i], b->lon[i]);
+        if (d >= radius_km) continue;
+        if (n < max_out) out[n] = (struct BatchHit){ i, b->ref[i], d };
+        n++;
+    }
+    return n;
+}
+
+
+// --- Closest point of approach ---
+
+bool motion_batch_init(struct MotionBatch* b, size_t capacity) {
+    memset(b, 0, sizeof(*b));
+    b->lat = malloc(capacity * sizeof(*b->lat));
+    b->lon = malloc(capacity * sizeof(*b->lon));
+    b->east_kms = malloc(capacity * sizeof(*b->east_kms));
+    b->north_kms = malloc(capacity * sizeof(*b->north_kms));
+    b->ref = malloc(capacity * sizeof(*b->ref));
+    b->t_cpa_s = malloc(capacity * sizeof(*b->t_cpa_s));
+    b->cpa_km_sq = malloc(capacity * sizeof(*b->cpa_km_sq));
+    if (!b->lat || !b->lon || !b->east_kms || !b->north_kms || !b->ref || !b->t_cpa_s || !b->cpa_km_sq) {
+        motion_batch_free(b);
+        return false;
+    }
+    b->capacity = capacity;
+    return true;
+}
+
+void motion_batch_free(struct MotionBatch* b) {
+    free(b->lat);
+    free(b->lon);
+    free(b->east_kms);
+    free(b->north_kms);
+    free(b->ref);
+    free(b->t_cpa_s);
+    free(b->cpa_km_sq);
+    memset(b, 0, sizeof(*b));
+}
+
+void motion_batch_clear(struct MotionBatch* b) { b->count = 0; }
+
+bool motion_batch_add(struct MotionBatch* b, double lat, double lon, double ground_speed_kts, double track_deg,
+                      uint32_t ref) {
+    if (b->count >= b->capacity) return false;
+    double speed_kms = ground_speed_kts * (1.852 / 3600.0);
+    b->lat[b->count] = lat;
+    b->lon[b->count] = lon;
+    b->east_kms[b->count] = speed_kms * sin(track_deg * DEG_TO_RAD);
+    b->north_kms[b->count] = speed_kms * cos(track_deg * DEG_TO_RAD);
+    b->ref[b->count] = ref;
+    b->count++;
+    return true;
+}
+
+/**
+ * @brief Kilometres east and north of the observer in the local flat-earth frame batch_cpa() uses.
+ */
+void observer_project(const struct Observer* obs, double lat, double lon, double* east_km, double* north_km) {
+    double dlon = lon - obs->lon;
+    if (dlon > 180.0) dlon -= 360.0;
+    else if (dlon < -180.0) dlon += 360.0;
+    double mid = (lat + obs->lat) * (0.5 * DEG_TO_RAD);
+    *east_km = dlon * DEG_TO_RAD * COS_POLY(mid * mid) * EARTH_RADIUS_KM;
+    *north_km = (lat - obs->lat) * DEG_TO_RAD * EARTH_RADIUS_KM;
+}
+
+static inline void cpa_one(const struct Observer* obs, double lat, double lon, double ve, double vn, double* t_out,
+                           double* d2_out) {
+    double x, y;
+    observer_project(obs, lat, lon, &x, &y);
+    double t = -(x * ve + y * vn) / (ve * ve + vn * vn + 1e-12);
+    if (t < 0.0) t = 0.0;
+    double cx = x + ve * t, cy = y + vn * t;
+    *t_out = t;
+    *d2_out = cx * cx + cy * cy;
+}
+
+/**
+ * @brief Fills `t_cpa_s` and `cpa_km_sq` for every entry.
+ * A receding aircraft has its closest approach at 0, i.e. at the fix itself.
+ */
+void batch_cpa(const struct Observer* obs, struct MotionBatch* b) {
+    size_t i = 0;
+#if defined(__GNUC__)
+    typedef double vdouble __attribute__((vector_size(32)));
+    typedef long long vmask __attribute__((vector_size(32)));
+    const vdouble obs_lat = { obs->lat, obs->lat, obs->lat, obs->lat };
+    const vdouble obs_lon = { obs->lon, obs->lon, obs->lon, obs->lon };
+    const vdouble half_circle = { 180.0, 180.0, 180.0, 180.0 };
+    const vdouble full_circle = { 360.0, 360.0, 360.0, 360.0 };
+    const vdouble zero = { 0.0, 0.0, 0.0, 0.0 };
+    for (; i + 4 <= b->count; i += 4) {
+        vdouble lat, lon, ve, vn;
+        memcpy(&lat, &b->lat[i], sizeof(lat));
+        memcpy(&lon, &b->lon[i], sizeof(lon));
+        memcpy(&ve, &b->east_kms[i], sizeof(ve));
+        memcpy(&vn, &b->north_kms[i], sizeof(vn));
+        vdouble dlon = lon - obs_lon;
+        vmask over = dlon > half_circle, under = dlon < -half_circle;
+        dlon -= (vdouble)((vmask)full_circle & over);
+        dlon += (vdouble)((vmask)full_circle & under);
+        vdouble mid = (lat + obs_lat) * (0.5 * DEG_TO_RAD);
+        vdouble mid2 = mid * mid;
+        vdouble x = dlon * DEG_TO_RAD * COS_POLY(mid2) * EARTH_RADIUS_KM;
+        vdouble y = (lat - obs_lat) * DEG_TO_RAD * EARTH_RADIUS_KM;
+        vdouble t = -(x * ve + y * vn) / (ve * ve + vn * vn + 1e-12);
+        t = (vdouble)((vmask)t & ~(t < zero));
+        vdouble cx = x + ve * t, cy = y + vn * t;
+        vdouble d2 = cx * cx + cy * cy;
+        memcpy(&b->t_cpa_s[i], &t, sizeof(t));
+        memcpy(&b->cpa_km_sq[i], &d2, sizeof(d2));
+    }
+#endif
+    for (; i < b->count; i++) {
+        cpa_one(obs, b->lat[i], b->lon[i], b->east_kms[i], b->north_kms[i], &b->t_cpa_s[i], &b->cpa_km_sq[i]);
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * @file geo_batch.h
+ * @brief Observer-relative distance and bearing, and batch nearest/radius and CPA kernels over SoA positions.
+ */
+
+#ifndef GEO_BATCH_H
+#define GEO_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A fixed observer with its trigonometric terms computed once.
+struct Observer {
+    double lat, lon;
+    double lat_rad, lon_rad, sin_lat, cos_lat;
+};
+
+// Structure-of-arrays position buffer; `ref` maps each entry back to the caller's record.
+struct PositionBatch {
+    double* lat;
+    double* lon;
+    uint32_t* ref;
+    double* scratch; // Approximate squared distances from the last query
+    size_t count, capacity;
+};
+
+// One aircraft picked out of a batch.
+struct BatchHit {
+    size_t slot;        // Index into the batch
+    uint32_t ref;       // The caller's record
+    double distance_km; // Exact great-circle distance from the observer
+};
+
+// Positions with ground velocity, for closest-point-of-approach prediction
+struct MotionBatch {
+    double* lat;
+    double* lon;
+    double* east_kms;  // Ground velocity, km/s
+    double* north_kms;
+    uint32_t* ref;
+    double* t_cpa_s;   // Outputs of batch_cpa(): seconds from the fix to the closest approach,
+    double* cpa_km_sq; // and the squared distance from the observer there
+    size_t count, capacity;
+};
+
+void observer_init(struct Observer* obs, double lat, double lon);
+double observer_distance_km(const struct Observer* obs, double lat, double lon);
+double observer_bearing(const struct Observer* obs, double lat, double lon);
+void observer_project(const struct Observer* obs, double lat, double lon, double* east_km, double* north_km);
+
+bool position_batch_init(struct PositionBatch* b, size_t capacity);
+void position_batch_free(struct PositionBatch* b);
+void position_batch_clear(struct PositionBatch* b);
+bool position_batch_add(struct PositionBatch* b, double lat, double lon, uint32_t ref);
+
+void batch_approx_distance_sq(const struct Observer* obs, const struct PositionBatch* b, double* out_km_sq);
+bool batch_nearest(const struct Observer* obs, struct PositionBatch* b, struct BatchHit* hit);
+size_t batch_within(const struct Observer* obs, struct PositionBatch* b, double radius_km,
+                    struct BatchHit* out, size_t max_out);
+
+bool motion_batch_init(struct MotionBatch* b, size_t capacity);
+void motion_batch_free(struct MotionBatch* b);
+void motion_batch_clear(struct MotionBatch* b);
+bool motion_batch_add(struct MotionBatch* b, double lat, double lon, double ground_speed_kts, double track_deg,
+                      uint32_t ref);
+void batch_cpa(const struct Observer* obs, struct MotionBatch* b);
+
+#endif // GEO_BATCH_H
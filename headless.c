@@ -0,0 +1,233 @@
+/**
+ * @file headless.c
+ * @brief Display-less daemon: runs the fetch worker and prints closest-aircraft events to stdout.
+ *
+ * Built by `make headless` without SDL, SDL_ttf, SDL_mixer or the embedded font,
+ * for servers with no display or audio. Each event is one line of key=value
+ * pairs prefixed with a Unix timestamp and an event name:
+ *
+ *   closest  the (dead-reckoned) closest aircraft changed
+ *   none     no aircraft with a position is in range
+ *   alert    the (dead-reckoned) closest aircraft came inside PROXIMITY_ALERT_KM
+ *   clear    it left the alert radius again
+ *   predict  an aircraft outside the radius is on course to enter it within predict_horizon
+ *
+ * With site= lines configured, each site also reports, from fixes only:
+ *
+ *   site_closest  the site's closest aircraft changed
+ *   site_alert    an aircraft came inside the site's alert radius
+ *   site_clear    the site's alert radius is empty again
+ *
+ * With latency=1 or metrics_port= set, a `stats` line with p50/p99 milliseconds
+ * per pipeline stage is also printed every stats_interval seconds.
+ *
+ * Configuration is loaded from `location.conf`, as for the windowed build.
+ *
+ * Usage:
+ * ./find_closest_plane_headless [--record log] [--replay log [--speed N] [--from seconds]] [--trace trace.json]
+ * (SIGINT or SIGTERM to exit)
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aircraft.h"
+#include "config.h"
+#include "fetch.h"
+#include "geo_batch.h"
+#include "latency.h"
+#include "snapshot.h"
+#include "timeutil.h"
+
+static volatile sig_atomic_t g_running = 1;
+static int g_wake_pipe[2] = { -1, -1 }; // Written by the fetch worker after each publish
+
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+/**
+ * @brief Fetch worker callback; a full pipe already means "wake up", so the write may fail harmlessly.
+ */
+static void notify_snapshot(void* userdata) {
+    (void)userdata;
+    char b = 1;
+    ssize_t r = write(g_wake_pipe[1], &b, 1);
+    (void)r;
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Copies `src` without its leading and trailing blanks; dump1090 pads callsigns to 8 characters.
+ */
+static const char* trimmed(const char* src, char* dst, size_t len) {
+    while (*src == ' ') src++;
+    snprintf(dst, len, "%s", *src ? src : "N/A");
+    size_t n = strlen(dst);
+    while (n > 0 && dst[n - 1] == ' ') dst[--n] = '\0';
+    return dst;
+}
+
+/**
+ * @brief Reports the site events implied by a new snapshot; `last` holds what was reported before.
+ */
+static void emit_sites(const struct Snapshot* snap, struct SiteStatus* last) {
+    for (int i = 0; i < snap->site_count; i++) {
+        const struct SiteStatus* st = &snap->sites[i];
+        const char* name = g_sites[i].name;
+        char flight[sizeof(st->flight)];
+        if (st->found && strcmp(st->hex, last[i].hex) != 0) {
+            printf("%.3f site_closest site=%s hex=%s flight=%s dist_km=%.2f bearing=%.0f alt_ft=%d\n", wall_seconds(),
+                   name, st->hex, trimmed(st->flight, flight, sizeof(flight)), st->distance_km, st->bearing_deg,
+                   st->altitude_ft);
+        }
+        if (st->alert && !last[i].alert) {
+            printf("%.3f site_alert site=%s hex=%s flight=%s dist_km=%.2f in_radius=%d\n", wall_seconds(), name,
+                   st->hex, trimmed(st->flight, flight, sizeof(flight)), st->distance_km, st->in_radius_count);
+        } else if (!st->alert && last[i].alert) {
+            printf("%.3f site_clear site=%s\n", wall_seconds(), name);
+        }
+        last[i] = *st;
+    }
+}
+
+/**
+ * @brief Reports aircraft newly predicted to breach the alert radius; `last` holds the previously listed ones.
+ */
+static void emit_predicted(const struct Snapshot* snap, struct PredictedEntry* last, int* last_count) {
+    int listed = snap->predicted_count < SNAPSHOT_PREDICTED_MAX ? snap->predicted_count : SNAPSHOT_PREDICTED_MAX;
+    for (int i = 0; i < listed; i++) {
+        const struct PredictedEntry* e = &snap->predicted[i];
+        bool known = false;
+        for (int j = 0; j < *last_count && !known; j++) known = strcmp(last[j].hex, e->hex) == 0;
+        if (known) continue;
+        char label[sizeof(e->label)];
+        printf("%.3f predict hex=%s flight=%s in_s=%.0f cpa_km=%.2f alt_ft=%d\n", wall_seconds(), e->hex,
+               trimmed(e->label, label, sizeof(label)), e->t_enter_s, e->cpa_km, e->altitude_ft);
+    }
+    memcpy(last, snap->predicted, (size_t)listed * sizeof(*last));
+    *last_count = listed;
+}
+
+static void emit_aircraft(const char* event, const struct Aircraft* ac) {
+    char flight[sizeof(ac->flight)], reg[sizeof(ac->registration)], type[sizeof(ac->aircraft_type)];
+    printf("%.3f %s hex=%s flight=%s dist_km=%.2f bearing=%.0f alt_ft=%d gs_kts=%.0f track=%.0f vrate_fpm=%d"
+           " squawk=%s reg=%s type=%s\n",
+           wall_seconds(), event, ac->hex, trimmed(ac->flight, flight, sizeof(flight)), ac->distance_km,
+           ac->bearing_deg, ac->altitude_ft, ac->ground_speed_kts, ac->track_deg, ac->vert_rate_fpm, ac->squawk,
+           trimmed(ac->registration, reg, sizeof(reg)), trimmed(ac->aircraft_type, type, sizeof(type)));
+}
+
+static bool open_wake_pipe(void) {
+    if (pipe(g_wake_pipe) != 0) return false;
+    for (int i = 0; i < 2; i++) {
+        fcntl(g_wake_pipe[i], F_SETFL, fcntl(g_wake_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(g_wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv) {
+    load_config();
+    if (!parse_arguments(argc, argv)) return 1;
+    setvbuf(stdout, NULL, _IOLBF, 0); // One event per line, even when piped
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!open_wake_pipe()) {
+        fprintf(stderr, "ERROR: Failed to create the wake-up pipe: %s\n", strerror(errno));
+        return 1;
+    }
+    if (!fetch_worker_start(notify_snapshot, NULL)) {
+        fprintf(stderr, "Failed to start the fetch worker!\n");
+        return 1;
+    }
+
+    struct Snapshot view;
+    memset(&view, 0, sizeof(view));
+    uint32_t view_seq = 0;
+    static struct SiteStatus reported_sites[MAX_SITES]; // Site state as last reported
+    static struct PredictedEntry reported_predicted[SNAPSHOT_PREDICTED_MAX];
+    int reported_predicted_count = 0;
+    bool reported_none = false;
+    char reported_closest[sizeof(view.closest.hex)] = ""; // Hex of the last `closest` line
+    bool alert = false;
+    double next_stats = monotonic_seconds() + g_stats_interval_s;
+
+    while (g_running) {
+        struct pollfd pfd = { g_wake_pipe[0], POLLIN, 0 };
+        if (poll(&pfd, 1, IDLE_WAKE_MS) > 0) {
+            char drain[64];
+            while (read(g_wake_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (!g_running) break;
+
+        bool fresh = snapshot_sequence() != view_seq;
+        if (fresh) {
+            view_seq = snapshot_read(&view);
+            emit_sites(&view, reported_sites);
+            emit_predicted(&view, reported_predicted, &reported_predicted_count);
+        }
+
+        if (g_stats_interval_s > 0 && atomic_load(&g_latency_on) && monotonic_seconds() >= next_stats) {
+            char stats[1024];
+            if (latency_format_stats(stats, sizeof(stats)) > 0) printf("%.3f stats %s\n", wall_seconds(), stats);
+            next_stats = monotonic_seconds() + g_stats_interval_s;
+        }
+
+        if (!view.plane_found) {
+            if (fresh && !reported_none) {
+                printf("%.3f none\n", wall_seconds());
+                reported_none = true;
+                reported_closest[0] = '\0';
+            }
+            if (alert) {
+                printf("%.3f clear\n", wall_seconds());
+                alert = false;
+            }
+            continue;
+        }
+        reported_none = false;
+
+        // Same projection as the window, so alerts fire between refreshes
+        struct Aircraft shown = view.closest;
+        if (g_dead_reckoning) snapshot_project_closest(&view, monotonic_seconds(), &g_observer, &shown);
+
+        if (strcmp(shown.hex, reported_closest) != 0) {
+            emit_aircraft("closest", &shown);
+            memcpy(reported_closest, shown.hex, sizeof(reported_closest));
+        }
+        bool inside = shown.distance_km < PROXIMITY_ALERT_KM;
+        if (inside && !alert) {
+            emit_aircraft("alert", &shown);
+        } else if (!inside && alert) {
+            emit_aircraft("clear", &shown);
+        }
+        alert = inside;
+    }
+
+    fetch_worker_stop();
+    close(g_wake_pipe[0]);
+    close(g_wake_pipe[1]);
+    return 0;
+}
@@ -0,0 +1,451 @@
+/**
+ * @file http.c
+ * @brief Persistent libcurl handles with keep-alive, HTTP/2 and a shared DNS/TLS cache.
+ *
+ * Creating a fresh easy handle per request throws away the connection, so every
+ * refresh paid a TCP handshake to dump1090 and a full TLS handshake to the API.
+ * Each endpoint now keeps one handle for the life of the worker; libcurl reuses
+ * its connection, and the CURLSH object shares resolved names and TLS sessions
+ * between the handles. All handles are owned by the fetch worker thread.
+ *
+ * Each endpoint also owns its response buffer. It is sized from Content-Length
+ * when the server sends one, grows by doubling otherwise, and is never shrunk,
+ * so after the first few cycles a fetch performs no heap allocation.
+ *
+ * Every handle advertises the compressions libcurl was built with (gzip, and
+ * brotli where available) and decodes into the same buffer, so callers always
+ * see plain JSON. Endpoints marked conditional also remember the ETag and
+ * Last-Modified of their last full response and revalidate with
+ * If-None-Match/If-Modified-Since; a `304 Not Modified` costs a few hundred
+ * header bytes and leaves `last.not_modified` set so the caller can skip parsing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http.h"
+#include "trace.h"
+
+#define BODY_MIN_CAPACITY (16 * 1024)
+
+static CURLSH* g_share = NULL;
+static CURLM* g_multi = NULL; // Drives http_get_all(); created on first use
+static CURLM* g_async_multi = NULL; // Transfers started with http_start(), driven by http_poll()
+static const atomic_bool* g_abort_flag = NULL;
+
+static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp);
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp);
+static int TransferProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
+
+/**
+ * @brief Initializes libcurl and the shared cache. `abort_flag`, when set, cancels in-flight transfers.
+ */
+bool http_init(const atomic_bool* abort_flag) {
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        fprintf(stderr, "ERROR: curl_global_init failed\n");
+        return false;
+    }
+    g_abort_flag = abort_flag;
+
+    g_share = curl_share_init();
+    if (g_share) {
+        curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    } else {
+        fprintf(stderr, "WARNING: curl_share_init failed, continuing without a shared cache\n");
+    }
+    return true;
+}
+
+void http_cleanup() {
+    if (g_multi) {
+        curl_multi_cleanup(g_multi);
+        g_multi = NULL;
+    }
+    if (g_async_multi) {
+        curl_multi_cleanup(g_async_multi);
+        g_async_multi = NULL;
+    }
+    if (g_share) {
+        curl_share_cleanup(g_share);
+        g_share = NULL;
+    }
+    curl_global_cleanup();
+}
+
+/**
+ * @brief Creates the long-lived handle for one endpoint with keep-alive and HTTP/2 negotiation.
+ */
+bool http_endpoint_init(struct HttpEndpoint* ep, const char* name, long timeout_s) {
+    static uint32_t last_trace_id = 0;
+    memset(ep, 0, sizeof(*ep));
+    ep->name = name;
+    ep->trace_id = ++last_trace_id;
+    ep->handle = curl_easy_init();
+    if (!ep->handle) return false;
+
+    CURL* h = ep->handle;
+    curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(h, CURLOPT_TIMEOUT, timeout_s);
+    curl_easy_setopt(h, CURLOPT_NOSIGNAL, 1L); // Required when libcurl is used off the main thread
+    curl_easy_setopt(h, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(h, CURLOPT_XFERINFOFUNCTION, TransferProgressCallback);
+    curl_easy_setopt(h, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(h, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(h, CURLOPT_TCP_KEEPINTVL, 15L);
+    // HTTP/2 over TLS when the server offers it via ALPN; plain http stays on HTTP/1.1.
+    curl_easy_setopt(h, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    // "" offers every encoding this libcurl can decode; asking for one it cannot would break the body
+    curl_easy_setopt(h, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(h, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(h, CURLOPT_HEADERDATA, (void *)ep);
+    if (g_share) curl_easy_setopt(h, CURLOPT_SHARE, g_share);
+    return true;
+}
+
+/**
+ * @brief Enables revalidation with the last response's ETag/Last-Modified. Only for URLs polled repeatedly.
+ */
+void http_endpoint_set_conditional(struct HttpEndpoint* ep, bool enabled) {
+    ep->conditional = enabled;
+    ep->validated_url[0] = ep->etag[0] = ep->last_modified[0] = '\0';
+    ep->headers_stale = true;
+}
+
+void http_endpoint_cleanup(struct HttpEndpoint* ep) {
+    if (ep->in_flight) curl_multi_remove_handle(g_async_multi, ep->handle);
+    ep->in_flight = false;
+    curl_slist_free_all(ep->request_headers);
+    ep->request_headers = NULL;
+    if (ep->handle) {
+        curl_easy_cleanup(ep->handle);
+        ep->handle = NULL;
+    }
+    free(ep->body.memory);
+    memset(&ep->body, 0, sizeof(ep->body));
+}
+
+/**
+ * @brief Ensures room for `needed` bytes plus a terminating NUL, doubling the capacity as required.
+ */
+static bool body_reserve(struct MemoryStruct* mem, size_t needed) {
+    if (needed + 1 <= mem->capacity) return true;
+    size_t cap = mem->capacity ? mem->capacity : BODY_MIN_CAPACITY;
+    while (cap < needed + 1) cap *= 2;
+    char* ptr = realloc(mem->memory, cap);
+    if (!ptr) return false;
+    mem->memory = ptr;
+    mem->capacity = cap;
+    mem->grows++;
+    return true;
+}
+
+/**
+ * @brief Sets the If-None-Match/If-Modified-Since headers for `url`, rebuilding them only when the validators changed.
+ */
+static void set_validators(struct HttpEndpoint* ep, const char* url) {
+    if (strcmp(ep->validated_url, url) != 0) {
+        // Validators from another URL say nothing about this one
+        snprintf(ep->validated_url, sizeof(ep->validated_url), "%s", url);
+        ep->etag[0] = ep->last_modified[0] = '\0';
+        ep->headers_stale = true;
+    }
+    if (ep->headers_stale) {
+        curl_slist_free_all(ep->request_headers);
+        ep->request_headers = NULL;
+        char line[HTTP_ETAG_MAX + 32];
+        if (ep->etag[0]) {
+            snprintf(line, sizeof(line), "If-None-Match: %s", ep->etag);
+            ep->request_headers = curl_slist_append(ep->request_headers, line);
+        }
+        if (ep->last_modified[0]) {
+            snprintf(line, sizeof(line), "If-Modified-Since: %s", ep->last_modified);
+            struct curl_slist* list = curl_slist_append(ep->request_headers, line);
+            if (list) ep->request_headers = list;
+        }
+        curl_easy_setopt(ep->handle, CURLOPT_HTTPHEADER, ep->request_headers);
+        ep->headers_stale = false;
+    }
+    ep->next_etag[0] = ep->next_last_modified[0] = '\0';
+}
+
+static bool prepare_get(struct HttpEndpoint* ep, const char* url) {
+    if (!ep->handle) return false;
+    ep->body.size = 0;
+    if (!body_reserve(&ep->body, 0)) return false;
+    ep->body.memory[0] = '\0';
+    curl_easy_setopt(ep->handle, CURLOPT_URL, url);
+    curl_easy_setopt(ep->handle, CURLOPT_WRITEDATA, (void *)ep);
+    if (ep->conditional) set_validators(ep, url);
+    return true;
+}
+
+/**
+ * @brief Records the outcome and timings of a finished transfer in `ep->last`.
+ */
+static bool finish_get(struct HttpEndpoint* ep, CURLcode res) {
+    CURL* h = ep->handle;
+    struct TransferStats* st = &ep->last;
+    unsigned long long wire_total = st->wire_total, plain_total = st->plain_total;
+    memset(st, 0, sizeof(*st));
+    st->ok = (res == CURLE_OK);
+    if (ep->body.size > ep->body.high_water) ep->body.high_water = ep->body.size;
+    st->body_bytes = ep->body.size;
+    st->buffer_capacity = ep->body.capacity;
+    st->buffer_high_water = ep->body.high_water;
+    st->buffer_grows = ep->body.grows;
+
+    // All *_TIME_T values are cumulative microseconds from the start of the transfer.
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0, pretransfer = 0, starttransfer = 0, total = 0;
+    curl_easy_getinfo(h, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(h, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(h, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(h, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(h, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(h, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(h, CURLINFO_NUM_CONNECTS, &st->new_connections);
+    curl_easy_getinfo(h, CURLINFO_HTTP_VERSION, &st->http_version);
+    curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &st->status);
+
+    // SIZE_DOWNLOAD counts body bytes as received, i.e. before content decoding
+    curl_off_t downloaded = 0;
+    long header_bytes = 0;
+    curl_easy_getinfo(h, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    curl_easy_getinfo(h, CURLINFO_HEADER_SIZE, &header_bytes);
+    st->wire_bytes = (size_t)downloaded + (size_t)header_bytes;
+    st->not_modified = st->ok && st->status == 304;
+    if (st->ok && st->status == 200) {
+        ep->plain_size = ep->body.size;
+        if (ep->conditional && (strcmp(ep->etag, ep->next_etag) != 0 || strcmp(ep->last_modified, ep->next_last_modified) != 0)) {
+            memcpy(ep->etag, ep->next_etag, sizeof(ep->etag));
+            memcpy(ep->last_modified, ep->next_last_modified, sizeof(ep->last_modified));
+            ep->headers_stale = true;
+        }
+    }
+    st->wire_total = wire_total + st->wire_bytes;
+    st->plain_total = plain_total + (size_t)header_bytes + (st->not_modified ? ep->plain_size : ep->body.size);
+
+    st->dns_ms = namelookup / 1000.0;
+    st->connect_ms = connect > namelookup ? (connect - namelookup) / 1000.0 : 0.0;
+    st->tls_ms = appconnect > connect ? (appconnect - connect) / 1000.0 : 0.0;
+    st->wait_ms = starttransfer > pretransfer ? (starttransfer - pretransfer) / 1000.0 : 0.0;
+    st->transfer_ms = total > starttransfer ? (total - starttransfer) / 1000.0 : 0.0;
+    st->total_ms = total / 1000.0;
+
+    if (atomic_load_explicit(&g_trace_on, memory_order_relaxed)) {
+        // Placed on the timeline from curl's phase offsets, ending now
+        double start = monotonic_seconds() - total / 1e6;
+        trace_async(ep->name, "http", ep->trace_id, start, total / 1e6, "status", st->status);
+        if (namelookup > 0) trace_async("dns", "http", ep->trace_id, start, namelookup / 1e6, NULL, 0);
+        if (connect > namelookup) trace_async("connect", "http", ep->trace_id, start + namelookup / 1e6,
+                                              (connect - namelookup) / 1e6, NULL, 0);
+        if (appconnect > connect) trace_async("tls", "http", ep->trace_id, start + connect / 1e6,
+                                              (appconnect - connect) / 1e6, NULL, 0);
+        if (starttransfer > pretransfer) trace_async("wait", "http", ep->trace_id, start + pretransfer / 1e6,
+                                                     (starttransfer - pretransfer) / 1e6, NULL, 0);
+        if (total > starttransfer) trace_async("transfer", "http", ep->trace_id, start + starttransfer / 1e6,
+                                               (total - starttransfer) / 1e6, "bytes", (long long)st->wire_bytes);
+    }
+    return st->ok;
+}
+
+/**
+ * @brief Performs a GET on the endpoint's persistent handle into `ep->body`.
+ * Timings for the transfer are stored in `ep->last`.
+ */
+bool http_get(struct HttpEndpoint* ep, const char* url) {
+    if (!prepare_get(ep, url)) return false;
+    return finish_get(ep, curl_easy_perform(ep->handle));
+}
+
+/**
+ * @brief Performs GETs on `n` endpoints concurrently and returns once every transfer has finished.
+ * Each endpoint's own CURLOPT_TIMEOUT bounds its transfer, so the call takes as long as the slowest
+ * endpoint and a dead one cannot hold up the rest past its timeout. Results are in each `ep->last`.
+ * @return The number of transfers that succeeded.
+ */
+size_t http_get_all(struct HttpEndpoint** eps, const char* const* urls, size_t n) {
+    if (n == 1) return http_get(eps[0], urls[0]) ? 1 : 0;
+    if (!g_multi && !(g_multi = curl_multi_init())) {
+        // No multi handle: fall back to sequential transfers
+        size_t ok = 0;
+        for (size_t i = 0; i < n; i++) ok += http_get(eps[i], urls[i]);
+        return ok;
+    }
+
+    size_t running_total = 0;
+    for (size_t i = 0; i < n; i++) {
+        eps[i]->last.ok = false;
+        if (!prepare_get(eps[i], urls[i])) continue;
+        curl_easy_setopt(eps[i]->handle, CURLOPT_PRIVATE, (void*)eps[i]);
+        if (curl_multi_add_handle(g_multi, eps[i]->handle) == CURLM_OK) running_total++;
+    }
+
+    size_t ok = 0, done = 0;
+    int still_running = 0;
+    do {
+        CURLMcode mc = curl_multi_perform(g_multi, &still_running);
+        if (mc == CURLM_OK && still_running) mc = curl_multi_poll(g_multi, NULL, 0, 100, NULL);
+        if (mc != CURLM_OK) break;
+
+        CURLMsg* msg;
+        int queued;
+        while ((msg = curl_multi_info_read(g_multi, &queued)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            struct HttpEndpoint* ep = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&ep);
+            CURLcode res = msg->data.result;
+            curl_multi_remove_handle(g_multi, msg->easy_handle);
+            if (ep && finish_get(ep, res)) ok++;
+            done++;
+        }
+    } while (done < running_total);
+
+    // Only reached early if the multi interface itself failed
+    for (size_t i = 0; i < n && done < running_total; i++) curl_multi_remove_handle(g_multi, eps[i]->handle);
+    return ok;
+}
+
+/**
+ * @brief Starts a GET that runs in the background while the caller does other work.
+ * Drive it with http_poll(); `ep->body` and `ep->last` are only valid once that returns true.
+ */
+bool http_start(struct HttpEndpoint* ep, const char* url) {
+    if (ep->in_flight) return false;
+    if (!g_async_multi && !(g_async_multi = curl_multi_init())) return false;
+    if (!prepare_get(ep, url)) return false;
+    curl_easy_setopt(ep->handle, CURLOPT_PRIVATE, (void*)ep);
+    if (curl_multi_add_handle(g_async_multi, ep->handle) != CURLM_OK) return false;
+    ep->in_flight = true;
+    return true;
+}
+
+/**
+ * @brief Advances background transfers, waiting up to `timeout_ms` for activity.
+ * @return true once the transfer started on `ep` has finished (successfully or not).
+ */
+bool http_poll(struct HttpEndpoint* ep, int timeout_ms) {
+    if (!ep->in_flight) return false;
+    int running = 0;
+    curl_multi_perform(g_async_multi, &running);
+    if (running && timeout_ms > 0) {
+        curl_multi_poll(g_async_multi, NULL, 0, timeout_ms, NULL);
+        curl_multi_perform(g_async_multi, &running);
+    }
+
+    CURLMsg* msg;
+    int queued;
+    while ((msg = curl_multi_info_read(g_async_multi, &queued)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        struct HttpEndpoint* done = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&done);
+        CURLcode res = msg->data.result;
+        curl_multi_remove_handle(g_async_multi, msg->easy_handle);
+        if (done) {
+            done->in_flight = false;
+            finish_get(done, res);
+        }
+    }
+    return !ep->in_flight;
+}
+
+const char* http_version_name(long http_version) {
+    switch (http_version) {
+        case CURL_HTTP_VERSION_1_0: return "HTTP/1.0";
+        case CURL_HTTP_VERSION_1_1: return "HTTP/1.1";
+        case CURL_HTTP_VERSION_2_0: return "HTTP/2";
+#ifdef CURL_HTTP_VERSION_3
+        case CURL_HTTP_VERSION_3: return "HTTP/3";
+#endif
+        default: return "-";
+    }
+}
+
+/**
+ * @brief Formats one endpoint's timings as a single display/log line.
+ */
+void http_format_stats(char* buf, size_t len, const char* label, const struct TransferStats* st) {
+    if (st->total_ms <= 0.0) {
+        snprintf(buf, len, "%-9s --", label);
+        return;
+    }
+    double saved = st->plain_total > 0 ? 100.0 * (1.0 - (double)st->wire_total / (double)st->plain_total) : 0.0;
+    snprintf(buf, len, "%-9s %s %s dns %.0f conn %.0f tls %.0f wait %.0f xfer %.0f ms buf %zu/%zuK %s%.0f%% saved",
+             label, http_version_name(st->http_version),
+             st->new_connections > 0 ? "new" : "reused",
+             st->dns_ms, st->connect_ms, st->tls_ms, st->wait_ms, st->transfer_ms,
+             st->buffer_high_water / 1024, st->buffer_capacity / 1024,
+             st->not_modified ? "304 " : "", saved);
+}
+
+
+// --- Utility Function Implementations ---
+
+static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    struct HttpEndpoint *ep = (struct HttpEndpoint *)userp;
+    struct MemoryStruct *mem = &ep->body;
+    if (mem->size == 0) {
+        // Headers are complete by the first body chunk: size the buffer once up front.
+        // For an encoded body this is the compressed length, so only a lower bound.
+        curl_off_t length = -1;
+        if (curl_easy_getinfo(ep->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length > 0) {
+            body_reserve(mem, (size_t)length);
+        }
+    }
+    if (!body_reserve(mem, mem->size + realsize)) return 0;
+    memcpy(&(mem->memory[mem->size]), contents, realsize);
+    mem->size += realsize;
+    mem->memory[mem->size] = 0;
+    return realsize;
+}
+
+/**
+ * @brief Case-insensitive match of a "Name:" header prefix; returns the trimmed value or NULL.
+ */
+static const char* header_value(const char* line, size_t len, const char* name, size_t* value_len) {
+    size_t n = strlen(name);
+    if (len <= n || strncasecmp(line, name, n) != 0 || line[n] != ':') return NULL;
+    const char* v = line + n + 1;
+    const char* end = line + len;
+    while (v < end && (*v == ' ' || *v == '\t')) v++;
+    while (end > v && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')) end--;
+    *value_len = (size_t)(end - v);
+    return v;
+}
+
+/**
+ * @brief Picks the validators out of the response headers of conditional endpoints.
+ */
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    size_t len = size * nitems;
+    struct HttpEndpoint *ep = (struct HttpEndpoint *)userp;
+    if (!ep->conditional) return len;
+    if (len >= 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        // New status line (a redirect or 100 Continue came first): start over
+        ep->next_etag[0] = ep->next_last_modified[0] = '\0';
+        return len;
+    }
+    size_t vlen;
+    const char* v;
+    if ((v = header_value(buffer, len, "ETag", &vlen)) && vlen < sizeof(ep->next_etag)) {
+        memcpy(ep->next_etag, v, vlen);
+        ep->next_etag[vlen] = '\0';
+    } else if ((v = header_value(buffer, len, "Last-Modified", &vlen)) && vlen < sizeof(ep->next_last_modified)) {
+        memcpy(ep->next_last_modified, v, vlen);
+        ep->next_last_modified[vlen] = '\0';
+    }
+    return len;
+}
+
+/**
+ * @brief Aborts an in-flight transfer as soon as shutdown is requested, so exit never waits on CURLOPT_TIMEOUT.
+ */
+static int TransferProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void)clientp; (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    return (g_abort_flag && atomic_load(g_abort_flag)) ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file http.h
+ * @brief Long-lived libcurl handles, one per endpoint, sharing DNS and TLS session caches.
+ */
+
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <curl/curl.h>
+
+/**
+ * @brief Response body buffer. Kept per endpoint and reused across transfers;
+ * it only grows (geometrically), so the steady state does no heap allocation.
+ */
+struct MemoryStruct {
+    char *memory;
+    size_t size;       // Bytes of the current body (always NUL-terminated)
+    size_t capacity;   // Allocated bytes
+    size_t high_water; // Largest body seen
+    unsigned long grows; // Number of reallocations so far
+};
+
+/**
+ * @brief Per-transfer timing breakdown, in milliseconds.
+ * A reused connection shows up as zero connect/TLS time and `new_connections == 0`.
+ */
+struct TransferStats {
+    double dns_ms, connect_ms, tls_ms, wait_ms, transfer_ms, total_ms;
+    long new_connections;
+    long http_version; // CURL_HTTP_VERSION_* actually negotiated
+    long status;       // HTTP response code, 0 if none was received
+    size_t body_bytes, buffer_capacity, buffer_high_water;
+    unsigned long buffer_grows;
+    size_t wire_bytes;   // Headers plus (possibly compressed) body actually received
+    bool not_modified;   // 304: the previous body is still current and was not re-sent
+    unsigned long long wire_total;  // Cumulative bytes received by this endpoint
+    unsigned long long plain_total; // What the same transfers would have cost uncompressed and unconditional
+    bool ok;
+};
+
+#define HTTP_ETAG_MAX 128
+#define HTTP_DATE_MAX 64
+
+struct HttpEndpoint {
+    const char* name;
+    CURL* handle;
+    struct MemoryStruct body; // Body of the last transfer, valid until the next http_get()
+    struct TransferStats last;
+    bool in_flight; // Started with http_start() and not yet finished
+    uint32_t trace_id; // Track of this endpoint's transfers in a trace
+
+    // Conditional GET state, only used when `conditional` is set
+    bool conditional;
+    char validated_url[256];            // URL the validators below belong to
+    char etag[HTTP_ETAG_MAX];           // Sent as If-None-Match
+    char last_modified[HTTP_DATE_MAX];  // Sent as If-Modified-Since
+    char next_etag[HTTP_ETAG_MAX];      // Validators of the response being received
+    char next_last_modified[HTTP_DATE_MAX];
+    struct curl_slist* request_headers;
+    bool headers_stale;                 // Validators changed since `request_headers` was built
+    size_t plain_size;                  // Decoded size of the last full body, what a 304 saved
+};
+
+bool http_init(const atomic_bool* abort_flag);
+void http_cleanup();
+bool http_endpoint_init(struct HttpEndpoint* ep, const char* name, long timeout_s);
+void http_endpoint_set_conditional(struct HttpEndpoint* ep, bool enabled);
+void http_endpoint_cleanup(struct HttpEndpoint* ep);
+bool http_get(struct HttpEndpoint* ep, const char* url);
+size_t http_get_all(struct HttpEndpoint** eps, const char* const* urls, size_t n);
+bool http_start(struct HttpEndpoint* ep, const char* url);
+bool http_poll(struct HttpEndpoint* ep, int timeout_ms);
+const char* http_version_name(long http_version);
+void http_format_stats(char* buf, size_t len, const char* label, const struct TransferStats* st);
+
+#endif // HTTP_H
@@ -0,0 +1,225 @@
+/**
+ * @file latency.c
+ * @brief Lock-free log-bucketed latency histograms, a Prometheus text endpoint and a stats line.
+ *
+ * Each stage has LATENCY_BUCKETS counters spaced four per octave (about 19%
+ * apart), so p50/p99 are read to within one bucket from 1 us to half a minute.
+ * Recording is a relaxed fetch_add on one counter plus the running sum and max;
+ * there is no lock and no allocation, so the fetch worker, the render loop and
+ * the metrics thread never wait on each other. Counts are cumulative since
+ * start, as Prometheus expects.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "latency.h"
+
+#define METRICS_POLL_MS 250
+#define METRICS_BUFFER (64 * 1024)
+
+atomic_bool g_latency_on = false;
+
+static _Atomic uint64_t g_counts[LAT_STAGE_COUNT][LATENCY_BUCKETS];
+static _Atomic uint64_t g_sum_ns[LAT_STAGE_COUNT];
+static _Atomic uint64_t g_max_ns[LAT_STAGE_COUNT];
+
+static const char* const g_stage_names[LAT_STAGE_COUNT] = {
+    "dns", "connect", "tls", "wait", "transfer", "parse", "scan", "select", "enrich", "api", "cycle", "frame",
+};
+
+static pthread_t g_metrics_thread;
+static atomic_bool g_metrics_stop = false;
+static bool g_metrics_running = false;
+static int g_metrics_fd = -1;
+
+
+void latency_enable(bool on) {
+    atomic_store_explicit(&g_latency_on, on, memory_order_relaxed);
+}
+
+const char* latency_stage_name(enum LatencyStage stage) {
+    return g_stage_names[stage];
+}
+
+/**
+ * @brief Upper edge of bucket `i` in seconds; bucket 0 holds everything under 1 us.
+ */
+static double bucket_upper_s(int i) {
+    return pow(2.0, i / 4.0) * 1e-6;
+}
+
+void latency_record(enum LatencyStage stage, double seconds) {
+    if (!atomic_load_explicit(&g_latency_on, memory_order_relaxed) || seconds < 0.0) return;
+    double us = seconds * 1e6;
+    int i = us <= 1.0 ? 0 : (int)ceil(4.0 * log2(us));
+    if (i >= LATENCY_BUCKETS) i = LATENCY_BUCKETS - 1;
+    atomic_fetch_add_explicit(&g_counts[stage][i], 1, memory_order_relaxed);
+
+    uint64_t ns = (uint64_t)(seconds * 1e9);
+    atomic_fetch_add_explicit(&g_sum_ns[stage], ns, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&g_max_ns[stage], memory_order_relaxed);
+    while (ns > max && !atomic_compare_exchange_weak_explicit(&g_max_ns[stage], &max, ns, memory_order_relaxed,
+                                                              memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Count, mean inputs and percentiles of one stage. Percentiles are bucket upper edges, capped at the max.
+ */
+void latency_summary(enum LatencyStage stage, struct LatencySummary* out) {
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&g_counts[stage][i], memory_order_relaxed);
+        total += counts[i];
+    }
+    memset(out, 0, sizeof(*out));
+    out->count = total;
+    out->sum_s = (double)atomic_load_explicit(&g_sum_ns[stage], memory_order_relaxed) / 1e9;
+    out->max_s = (double)atomic_load_explicit(&g_max_ns[stage], memory_order_relaxed) / 1e9;
+    if (total == 0) return;
+
+    uint64_t p50_rank = (total + 1) / 2, p99_rank = (uint64_t)ceil((double)total * 0.99), seen = 0;
+    bool have_p50 = false;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += counts[i];
+        if (!have_p50 && seen >= p50_rank) {
+            out->p50_s = bucket_upper_s(i);
+            have_p50 = true;
+        }
+        if (seen >= p99_rank) {
+            out->p99_s = bucket_upper_s(i);
+            break;
+        }
+    }
+    if (out->p50_s > out->max_s) out->p50_s = out->max_s;
+    if (out->p99_s > out->max_s) out->p99_s = out->max_s;
+}
+
+/**
+ * @brief Writes every stage as a Prometheus histogram, with one `le` per octave.
+ * @return Bytes written, excluding the terminator.
+ */
+size_t latency_format_prometheus(char* buf, size_t len) {
+    size_t off = 0;
+#define EMIT(...) do { int n = snprintf(buf + off, len - off, __VA_ARGS__); if (n > 0) off += (size_t)n; if (off >= len) return len - 1; } while (0)
+    EMIT("# HELP closest_plane_stage_seconds Latency of each fetch-cycle stage and of window repaints.\n"
+         "# TYPE closest_plane_stage_seconds histogram\n");
+    for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+        uint64_t cumulative = 0;
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            cumulative += atomic_load_explicit(&g_counts[s][i], memory_order_relaxed);
+            if (i % 4 == 0) EMIT("closest_plane_stage_seconds_bucket{stage=\"%s\",le=\"%.9g\"} %llu\n", g_stage_names[s],
+                                 bucket_upper_s(i), (unsigned long long)cumulative);
+        }
+        EMIT("closest_plane_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", g_stage_names[s],
+             (unsigned long long)cumulative);
+        EMIT("closest_plane_stage_seconds_sum{stage=\"%s\"} %.9f\n", g_stage_names[s],
+             (double)atomic_load_explicit(&g_sum_ns[s], memory_order_relaxed) / 1e9);
+        EMIT("closest_plane_stage_seconds_count{stage=\"%s\"} %llu\n", g_stage_names[s], (unsigned long long)cumulative);
+    }
+#undef EMIT
+    return off;
+}
+
+/**
+ * @brief One key=value line with p50/p99 in milliseconds for every stage that has samples.
+ */
+size_t latency_format_stats(char* buf, size_t len) {
+    size_t off = 0;
+    buf[0] = '\0';
+    for (int s = 0; s < LAT_STAGE_COUNT && off < len; s++) {
+        struct LatencySummary sum;
+        latency_summary((enum LatencyStage)s, &sum);
+        if (sum.count == 0) continue;
+        int n = snprintf(buf + off, len - off, "%s%s_p50_ms=%.3f %s_p99_ms=%.3f", off ? " " : "", g_stage_names[s],
+                         sum.p50_s * 1e3, g_stage_names[s], sum.p99_s * 1e3);
+        if (n > 0) off += (size_t)n;
+    }
+    return off < len ? off : len - 1;
+}
+
+
+// --- Metrics endpoint ---
+
+static void serve_one(int client) {
+    static char body[METRICS_BUFFER];
+    char request[1024];
+    struct pollfd pfd = { client, POLLIN, 0 };
+    ssize_t got = poll(&pfd, 1, 1000) > 0 ? recv(client, request, sizeof(request) - 1, 0) : -1;
+    if (got <= 0) return;
+    request[got] = '\0';
+
+    char header[160];
+    size_t body_len = 0;
+    int status = 404;
+    if (strncmp(request, "GET /metrics", 12) == 0 || strncmp(request, "GET / ", 6) == 0) {
+        status = 200;
+        body_len = latency_format_prometheus(body, sizeof(body));
+    }
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n", status == 200 ? "200 OK" : "404 Not Found", body_len);
+    if (send(client, header, (size_t)header_len, MSG_NOSIGNAL) < 0) return;
+    for (size_t sent = 0; sent < body_len;) {
+        ssize_t n = send(client, body + sent, body_len - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+}
+
+static void* metrics_thread_main(void* arg) {
+    (void)arg;
+    while (!atomic_load(&g_metrics_stop)) {
+        struct pollfd pfd = { g_metrics_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, METRICS_POLL_MS) <= 0) continue;
+        int client = accept(g_metrics_fd, NULL, NULL);
+        if (client < 0) continue;
+        serve_one(client);
+        close(client);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Serves the histograms as Prometheus text on `port` (all interfaces) from a background thread.
+ */
+bool latency_serve_metrics(int port) {
+    if (g_metrics_running) return true;
+    g_metrics_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (g_metrics_fd < 0) return false;
+    int one = 1;
+    setsockopt(g_metrics_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(g_metrics_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(g_metrics_fd, 4) != 0) {
+        fprintf(stderr, "WARNING: Cannot serve metrics on port %d: %s\n", port, strerror(errno));
+        close(g_metrics_fd);
+        g_metrics_fd = -1;
+        return false;
+    }
+    atomic_store(&g_metrics_stop, false);
+    if (pthread_create(&g_metrics_thread, NULL, metrics_thread_main, NULL) != 0) {
+        close(g_metrics_fd);
+        g_metrics_fd = -1;
+        return false;
+    }
+    g_metrics_running = true;
+    printf("INFO: Serving latency metrics on :%d/metrics\n", port);
+    return true;
+}
+
+void latency_stop_metrics() {
+    if (!g_metrics_running) return;
+    atomic_store(&g_metrics_stop, true);
+    pthread_join(g_metrics_thread, NULL);
+    close(g_metrics_fd);
+    g_metrics_fd = -1;
+    g_metrics_running = false;
+}
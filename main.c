@@ -7,6 +7,9 @@
  * from an online API. It renders all information as text and a graphical compass
  * in the window and plays an audible alert if an aircraft comes within a 5km radius.
  *
+ * Network I/O runs on a background worker (see fetch.c); the render loop only
+ * ever reads the latest published snapshot, so it never blocks on the network.
+ *
  * Configuration is loaded from `location.conf`.
  *
  * Dependencies:
@@ -17,77 +20,71 @@
  * Place `PressStart2P-Regular.ttf` in the same directory and run `make`.
  *
  * Usage:
- * ./find_closest_plane
- * (Press Esc to exit)
+ * ./find_closest_plane [--record log] [--replay log [--speed N] [--from seconds]] [--trace trace.json]
+ * (Press Esc to exit, L to toggle the per-stage latency overlay, R for the radar view and +/- to zoom it)
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
-#include <curl/curl.h>
 #include <math.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
 
-#include <cjson/cJSON.h>
 #include "font_data.h" // Embedded font from xxd
+#include "alert_tone.h" // Beep PCM from tools/mktone
+#include "aircraft.h"
+#include "config.h"
+#include "fetch.h"
+#include "geo.h"
+#include "http.h"
+#include "latency.h"
+#include "radar.h"
+#include "scope.h"
+#include "snapshot.h"
+#include "text.h"
+#include "timeutil.h"
+#include "trace.h"
 
 // --- Configuration ---
 #define WINDOW_WIDTH 1024
-#define FONT_SIZE 20
-#define EARTH_RADIUS_KM 6371.0
-#define REFRESH_INTERVAL_SECONDS 5
-#define PROXIMITY_ALERT_KM 5.0
-#define DUMP1090_PORT 8080
-
-// --- Structs ---
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
-
-struct Aircraft {
-    char flight[24], hex[10], squawk[6], registration[24], aircraft_type[24], operator[40];
-    double lat, lon, distance_km;
-    int altitude_ft, vert_rate_fpm;
-    double ground_speed_kts, track_deg;
-    double bearing_deg; // Bearing from user to aircraft
-};
+#ifndef FONT_SIZE
+#error "FONT_SIZE comes from the Makefile, which also pre-rasterizes the atlas at that size"
+#endif
 
 // --- Globals ---
 SDL_Window* g_window = NULL;
 SDL_Renderer* g_renderer = NULL;
 TTF_Font* g_font = NULL;
 Mix_Chunk* g_alert_sound = NULL;
-bool g_audio_available = false;
-struct Aircraft g_closest_plane;
-// Configuration globals
-char g_server_ip[40];
-double g_user_lat;
-double g_user_lon;
+bool g_audio_available = false; // Mixer opened; written by the audio thread, read after it is joined
+SDL_Thread* g_audio_thread = NULL;
+SDL_atomic_t g_audio_ready; // Set by open_audio() once g_alert_sound may be played
+bool g_alert_pending = false; // An alert fired before audio was ready; play it as soon as it is
+bool g_text_atlas = false; // Glyph atlas built; otherwise render_text falls back to per-line TTF
+Uint32 g_snapshot_event = (Uint32)-1; // SDL user event pushed by the fetch worker
+static struct ScopeFrame g_scope_view; // Latest radar frame read from the worker, too big for the stack
 
 
 // --- Function Prototypes ---
 // (Function definitions are below main)
-void load_config();
 bool init_sdl();
 void close_sdl();
 void render_text(const char* text, int x, int y, SDL_Color color);
 void render_compass(int center_x, int center_y, double bearing);
-Mix_Chunk* create_beep(int freq, int duration_ms);
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp);
-double deg2rad(double deg);
-double haversine_distance(double lat1, double lon1, double lat2, double lon2);
-double calculate_bearing(double lat1, double lon1, double lat2, double lon2);
-const char* track_to_direction(double track_deg);
-const char* get_squawk_description(const char* squawk);
-void fetch_and_process_data();
+void render_traffic(int x, int y, const struct Snapshot* snap);
+void render_latency(int window_w, int window_h);
+void render_radar(int window_w, int window_h, int top, double range_km);
+static int open_audio(void* data);
+static void play_alert(void);
+static void notify_snapshot(void* userdata);
 
 
-int main(void) {
+int main(int argc, char** argv) {
     load_config();
+    if (!parse_arguments(argc, argv)) return 1;
 
     if (!init_sdl()) {
         fprintf(stderr, "Failed to initialize SDL components!\n");
@@ -99,50 +96,156 @@ int main(void) {
 
 
     // Initialize with default values
-    snprintf(g_closest_plane.flight, sizeof(g_closest_plane.flight), "Waiting for data...");
-    snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), " ");
-    snprintf(g_closest_plane.registration, sizeof(g_closest_plane.registration), " ");
-    snprintf(g_closest_plane.aircraft_type, sizeof(g_closest_plane.aircraft_type), " ");
-    snprintf(g_closest_plane.hex, sizeof(g_closest_plane.hex), " ");
-    snprintf(g_closest_plane.squawk, sizeof(g_closest_plane.squawk), " ");
-    g_closest_plane.distance_km = 999999.9;
-    g_closest_plane.bearing_deg = 0.0;
+    struct Snapshot view;
+    memset(&view, 0, sizeof(view));
+    aircraft_reset(&view.closest, "Waiting for data...");
+    view.plane_found = false;
+    view.in_zone_count = -1;
+    uint32_t view_seq = 0;
+    struct Aircraft shown = view.closest; // Whichever aircraft is closest once projected to the current time
+    const struct Aircraft* plane = &shown;
+
+    bool show_radar = g_radar;
+    double radar_range_km = g_radar_range_km;
+    uint32_t scope_seq = 0;
+    radar_init();
+    scope_enable(show_radar);
+
+    g_snapshot_event = SDL_RegisterEvents(1);
+    if (!fetch_worker_start(notify_snapshot, NULL)) {
+        fprintf(stderr, "Failed to start the fetch worker!\n");
+        close_sdl();
+        return 1;
+    }
+    trace_thread_name("render");
 
     bool running = true;
     SDL_Event event;
-    Uint32 last_update_time = 0;
     bool proximity_alert_triggered = false;
+    bool predicted_alert_triggered = false;
+    double view_time = monotonic_seconds(); // When `view` was read; predicted times count down from it
+
+    // With max_fps=0 the loop sleeps in SDL_WaitEventTimeout and only repaints when
+    // something visible changed. A positive max_fps repaints continuously at that rate.
+    Uint32 frame_ms = g_max_fps > 0 ? (Uint32)(1000 / g_max_fps) : 0;
+    Uint32 next_frame = SDL_GetTicks();
+    Uint32 last_draw = next_frame;
+    bool redraw = true;
+    bool show_latency = false;
 
     while (running) {
         // --- Event Handling ---
-        while (SDL_PollEvent(&event) != 0) {
-            if (event.type == SDL_QUIT) {
-                running = false;
-            }
-            if (event.type == SDL_KEYDOWN) {
-                if (event.key.keysym.sym == SDLK_ESCAPE) {
+        int timeout_ms = IDLE_WAKE_MS;
+        if (redraw) {
+            timeout_ms = 0;
+        } else if (frame_ms > 0) {
+            Sint32 remaining = (Sint32)(next_frame - SDL_GetTicks());
+            timeout_ms = remaining > 0 ? remaining : 0;
+        }
+        if (SDL_WaitEventTimeout(&event, timeout_ms)) {
+            do {
+                if (event.type == SDL_QUIT) {
                     running = false;
                 }
-            }
+                if (event.type == SDL_KEYDOWN) {
+                    if (event.key.keysym.sym == SDLK_ESCAPE) {
+                        running = false;
+                    } else if (event.key.keysym.sym == SDLK_l) {
+                        // Showing the overlay starts recording; hiding it stops unless configured on
+                        show_latency = !show_latency;
+                        latency_enable(show_latency || g_latency || g_metrics_port > 0);
+                        redraw = true;
+                    } else if (event.key.keysym.sym == SDLK_r) {
+                        // The worker only builds radar frames while the view is up; poll now to fill it
+                        show_radar = !show_radar;
+                        scope_enable(show_radar);
+                        if (show_radar) fetch_worker_poll_now();
+                        redraw = true;
+                    } else if (event.key.keysym.sym == SDLK_EQUALS || event.key.keysym.sym == SDLK_PLUS ||
+                               event.key.keysym.sym == SDLK_KP_PLUS) {
+                        radar_range_km = fmax(radar_range_km / 2, RADAR_RANGE_MIN_KM);
+                        redraw = true;
+                    } else if (event.key.keysym.sym == SDLK_MINUS || event.key.keysym.sym == SDLK_KP_MINUS) {
+                        radar_range_km = fmin(radar_range_km * 2, RADAR_RANGE_MAX_KM);
+                        redraw = true;
+                    }
+                }
+                if (event.type == SDL_WINDOWEVENT) {
+                    switch (event.window.event) {
+                        case SDL_WINDOWEVENT_EXPOSED:
+                        case SDL_WINDOWEVENT_SHOWN:
+                        case SDL_WINDOWEVENT_RESTORED:
+                        case SDL_WINDOWEVENT_SIZE_CHANGED:
+                            redraw = true;
+                            break;
+                    }
+                }
+            } while (SDL_PollEvent(&event) != 0);
+        }
+        if (!running) break;
+
+        // --- Pick up the latest snapshot from the fetch worker ---
+        // The worker's event wakes us, but polling the sequence also covers a dropped event.
+        if (snapshot_sequence() != view_seq) {
+            view_seq = snapshot_read(&view);
+            view_time = monotonic_seconds();
+            redraw = true;
+        }
+        if (show_radar && scope_sequence() != scope_seq) {
+            scope_seq = scope_read(&g_scope_view);
+            radar_update(&g_scope_view);
+            redraw = true;
         }
 
-        // --- Data Fetching Timer ---
-        if (SDL_GetTicks() - last_update_time > REFRESH_INTERVAL_SECONDS * 1000) {
-            fetch_and_process_data();
-            last_update_time = SDL_GetTicks();
+        // --- Dead Reckoning ---
+        // Every contender is re-projected from its last fix on every pass and the nearest shown,
+        // so the alert can fire between refreshes even for an aircraft that overtakes the closest.
+        shown = view.closest;
+        if (g_dead_reckoning && view.plane_found) {
+            snapshot_project_closest(&view, monotonic_seconds(), &g_observer, &shown);
+            // On-demand mode still refreshes the projected figures about once a second
+            if (frame_ms == 0 && SDL_GetTicks() - last_draw >= IDLE_WAKE_MS) redraw = true;
         }
+        bool counting_down = show_latency || view.predicted_count > 0;
+        if (counting_down && frame_ms == 0 && SDL_GetTicks() - last_draw >= IDLE_WAKE_MS) redraw = true;
 
         // --- Proximity Alert Logic ---
-        if (g_closest_plane.distance_km < PROXIMITY_ALERT_KM) {
-            if (!proximity_alert_triggered && g_alert_sound) {
-                Mix_PlayChannel(-1, g_alert_sound, 0);
+        if (g_alert_pending) play_alert();
+        if (plane->distance_km < PROXIMITY_ALERT_KM) {
+            if (!proximity_alert_triggered) {
+                play_alert();
                 proximity_alert_triggered = true;
+                redraw = true;
             }
-        } else {
+        } else if (proximity_alert_triggered) {
             proximity_alert_triggered = false;
+            redraw = true;
         }
 
+        // Advance warning: something outside the radius is on course to enter it
+        if (view.predicted_count > 0) {
+            if (!predicted_alert_triggered && !proximity_alert_triggered) play_alert();
+            predicted_alert_triggered = true;
+        } else {
+            predicted_alert_triggered = false;
+        }
+        // A tone held back for audio is dropped if what raised it ended first
+        if (!proximity_alert_triggered && !predicted_alert_triggered) g_alert_pending = false;
+
+        if (frame_ms > 0) {
+            Uint32 now = SDL_GetTicks();
+            if ((Sint32)(now - next_frame) >= 0) {
+                redraw = true;
+                next_frame += frame_ms;
+                if ((Sint32)(now - next_frame) >= 0) next_frame = now + frame_ms; // Fell behind; don't try to catch up
+            }
+        }
+        if (!redraw) continue;
+        redraw = false;
+        last_draw = SDL_GetTicks();
+
         // --- Rendering ---
+        double frame_start = latency_start();
         SDL_SetRenderDrawColor(g_renderer, 10, 20, 40, 255); // Dark blue background
         SDL_RenderClear(g_renderer);
         
@@ -158,51 +261,102 @@ int main(void) {
         render_text("--- Closest Aircraft Monitor ---", 10, y_pos, yellow); y_pos += 40;
 
         if (proximity_alert_triggered) {
-            render_text("!!! PROXIMITY ALERT !!!", 10, y_pos, red); y_pos += 30;
+            if (view.in_radius_count > 1) {
+                snprintf(buffer, sizeof(buffer), "!!! PROXIMITY ALERT (%d) !!!", view.in_radius_count);
+                render_text(buffer, 10, y_pos, red);
+            } else {
+                render_text("!!! PROXIMITY ALERT !!!", 10, y_pos, red);
+            }
+            y_pos += 30;
+        }
+        if (view.predicted_count > 0) {
+            const struct PredictedEntry* p = &view.predicted[0];
+            double in_s = fmax(p->t_enter_s - (monotonic_seconds() - view_time), 0.0);
+            int n = snprintf(buffer, sizeof(buffer), "Predicted: %s %.1f km in %.0f s", p->label, p->cpa_km, in_s);
+            if (view.predicted_count > 1 && n > 0 && (size_t)n < sizeof(buffer)) {
+                snprintf(buffer + n, sizeof(buffer) - (size_t)n, " (+%d)", view.predicted_count - 1);
+            }
+            render_text(buffer, 10, y_pos, yellow); y_pos += 30;
         }
 
-        snprintf(buffer, sizeof(buffer), "Flight:       %s", g_closest_plane.flight);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+        if (show_radar) {
+            render_radar(window_w, window_h, y_pos, radar_range_km);
+        } else {
+            snprintf(buffer, sizeof(buffer), "Flight:       %s", plane->flight);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
         
-        snprintf(buffer, sizeof(buffer), "Operator:     %s", g_closest_plane.operator);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Operator:     %s", plane->operator);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
 
-        snprintf(buffer, sizeof(buffer), "Registration: %s", g_closest_plane.registration);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Registration: %s", plane->registration);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
         
-        snprintf(buffer, sizeof(buffer), "Type:         %s", g_closest_plane.aircraft_type);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Type:         %s", plane->aircraft_type);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
 
-        snprintf(buffer, sizeof(buffer), "Hex:          %s", g_closest_plane.hex);
-        render_text(buffer, 10, y_pos, white); y_pos += 40;
+            snprintf(buffer, sizeof(buffer), "Hex:          %s", plane->hex);
+            render_text(buffer, 10, y_pos, white); y_pos += 40;
 
-        snprintf(buffer, sizeof(buffer), "Squawk:       %s (%s)", g_closest_plane.squawk, get_squawk_description(g_closest_plane.squawk));
-        render_text(buffer, 10, y_pos, cyan); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Squawk:       %s (%s)", plane->squawk, get_squawk_description(plane->squawk));
+            render_text(buffer, 10, y_pos, cyan); y_pos += 25;
 
-        snprintf(buffer, sizeof(buffer), "Distance:     %.2f km", g_closest_plane.distance_km);
-        render_text(buffer, 10, y_pos, cyan); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Distance:     %.2f km", plane->distance_km);
+            render_text(buffer, 10, y_pos, cyan); y_pos += 25;
 
-        snprintf(buffer, sizeof(buffer), "Location:     %.4f, %.4f", g_closest_plane.lat, g_closest_plane.lon);
-        render_text(buffer, 10, y_pos, white); y_pos += 40;
+            snprintf(buffer, sizeof(buffer), "Location:     %.4f, %.4f", plane->lat, plane->lon);
+            render_text(buffer, 10, y_pos, white); y_pos += 40;
 
-        snprintf(buffer, sizeof(buffer), "Altitude:     %d ft", g_closest_plane.altitude_ft);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Altitude:     %d ft", plane->altitude_ft);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
         
-        snprintf(buffer, sizeof(buffer), "Vert. Rate:   %d fpm", g_closest_plane.vert_rate_fpm);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
-
-        snprintf(buffer, sizeof(buffer), "Speed:        %.0f kts", g_closest_plane.ground_speed_kts);
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
-
-        snprintf(buffer, sizeof(buffer), "Track:        %.0f deg (%s)", g_closest_plane.track_deg, track_to_direction(g_closest_plane.track_deg));
-        render_text(buffer, 10, y_pos, white); y_pos += 25;
+            snprintf(buffer, sizeof(buffer), "Vert. Rate:   %d fpm", plane->vert_rate_fpm);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
+
+            snprintf(buffer, sizeof(buffer), "Speed:        %.0f kts", plane->ground_speed_kts);
+            render_text(buffer, 10, y_pos, white); y_pos += 25;
+
+            snprintf(buffer, sizeof(buffer), "Track:        %.0f deg (%s)", plane->track_deg, track_to_direction(plane->track_deg));
+            render_text(buffer, 10, y_pos, white); y_pos += 40;
+
+            // Per-cycle network timings, to confirm connections are being reused
+            SDL_Color grey = {140, 140, 160, 255};
+            char source_label[16] = "dump1090";
+            if (view.sources_total > 1) snprintf(source_label, sizeof(source_label), "rx %d/%d", view.sources_ok, view.sources_total);
+            http_format_stats(buffer, sizeof(buffer), source_label, &view.dump1090_stats);
+            render_text(buffer, 10, y_pos, grey); y_pos += 25;
+            if (view.scan_stats.listed > 0) {
+                snprintf(buffer, sizeof(buffer), "%-9s %zu listed, %zu moved, %zu skipped, %zu evicted, next poll %.1fs", "table",
+                         view.scan_stats.listed, view.scan_stats.updated, view.scan_stats.skipped, view.scan_stats.evicted,
+                         view.next_refresh_s);
+                render_text(buffer, 10, y_pos, grey); y_pos += 25;
+            }
+            if (view.enrich_source == ENRICH_SOURCE_CACHE) {
+                snprintf(buffer, sizeof(buffer), "%-9s cache hit", "adsb.lol");
+            } else if (view.enrich_source == ENRICH_SOURCE_DATABASE) {
+                snprintf(buffer, sizeof(buffer), "%-9s offline database", "adsb.lol");
+            } else if (view.enrich_source == ENRICH_SOURCE_PENDING) {
+                snprintf(buffer, sizeof(buffer), "%-9s lookup in flight", "adsb.lol");
+            } else if (view.enrich_source == ENRICH_SOURCE_BACKOFF) {
+                snprintf(buffer, sizeof(buffer), "%-9s backing off after errors", "adsb.lol");
+            } else {
+                http_format_stats(buffer, sizeof(buffer), "adsb.lol", &view.api_stats);
+            }
+            render_text(buffer, 10, y_pos, grey); y_pos += 25;
 
-        // Render the compass indicator
-        render_compass(window_w - 150, 150, g_closest_plane.bearing_deg);
+            // Render the compass indicator
+            render_compass(window_w - 150, 150, plane->bearing_deg);
+            render_traffic(window_w - 340, 260, &view);
+        }
+        if (show_latency) render_latency(window_w, window_h);
 
+        text_flush();
+        double present_start = trace_begin();
         SDL_RenderPresent(g_renderer);
+        trace_end("SDL_RenderPresent", "render", present_start);
+        latency_end(LAT_FRAME, frame_start);
     }
 
+    fetch_worker_stop();
     close_sdl();
     return 0;
 }
@@ -211,121 +365,102 @@ int main(void) {
 // --- Function Definitions ---
 
 /**
- * @brief Loads server IP and location from `location.conf`. Falls back to defaults.
- */
-void load_config() {
-    // Set default (dummy) values first
-    strcpy(g_server_ip, "127.0.0.1"); // Safe default
-    g_user_lat = 51.5074; // London
-    g_user_lon = -0.1278;
-
-    FILE* file = fopen("location.conf", "r");
-    if (!file) {
-        printf("INFO: location.conf not found. Using default values.\n");
-        return;
-    }
-
-    char line[128];
-    while (fgets(line, sizeof(line), file)) {
-        char* key = strtok(line, "=");
-        char* value = strtok(NULL, "\n");
-        if (key && value) {
-            if (strcmp(key, "server_ip") == 0) {
-                strncpy(g_server_ip, value, sizeof(g_server_ip) - 1);
-            } else if (strcmp(key, "lat") == 0) {
-                g_user_lat = atof(value);
-            } else if (strcmp(key, "lon") == 0) {
-                g_user_lon = atof(value);
-            }
-        }
-    }
-    fclose(file);
-    printf("INFO: Loaded settings from location.conf\n");
-}
-
-
-/**
- * @brief Initializes SDL, TTF, Mixer, creates a window, renderer, and loads resources.
+ * @brief Initializes SDL, creates a window and renderer, and loads resources.
+ *
+ * The glyph atlas comes prebuilt from font_atlas.h, so SDL_ttf is only started
+ * when it cannot be used. The mixer is opened on a background thread, since
+ * opening the audio device can take longer than everything else here; the
+ * alert stays silent until it is ready.
  */
 bool init_sdl() {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
         return false;
     }
 
-    if (TTF_Init() == -1) {
-        SDL_Log("TTF_Init failed: %s", TTF_GetError());
-        SDL_Quit();
-        return false;
-    }
-
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
-        SDL_Log("Mix_OpenAudio failed: %s", Mix_GetError());
-        g_audio_available = false;
-    } else {
-        g_audio_available = true;
-    }
+    SDL_AtomicSet(&g_audio_ready, 0);
+    g_audio_thread = SDL_CreateThread(open_audio, "audio", NULL);
+    if (!g_audio_thread) open_audio(NULL);
 
     g_window = SDL_CreateWindow("Closest Aircraft Finder", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 0, 0, SDL_WINDOW_FULLSCREEN_DESKTOP);
     if (!g_window) {
         SDL_Log("SDL_CreateWindow failed: %s", SDL_GetError());
-        if (g_audio_available) {
-            Mix_CloseAudio();
-            Mix_Quit();
-        }
-        TTF_Quit();
-        SDL_Quit();
+        close_sdl();
         return false;
     }
 
-    g_renderer = SDL_CreateRenderer(g_window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+    if (g_vsync) renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    g_renderer = SDL_CreateRenderer(g_window, -1, renderer_flags);
     if (!g_renderer) {
         SDL_Log("SDL_CreateRenderer failed: %s", SDL_GetError());
-        SDL_DestroyWindow(g_window);
-        if (g_audio_available) {
-            Mix_CloseAudio();
-            Mix_Quit();
-        }
-        TTF_Quit();
-        SDL_Quit();
+        close_sdl();
         return false;
     }
 
-    // Load font from embedded memory
+    g_text_atlas = text_init_prebuilt(g_renderer, FONT_SIZE);
+    if (g_text_atlas) return true;
+
+    // Fallback: rasterize from the embedded font
+    if (TTF_Init() == -1) {
+        SDL_Log("TTF_Init failed: %s", TTF_GetError());
+        close_sdl();
+        return false;
+    }
     SDL_RWops* rw = SDL_RWFromConstMem(PressStart2P_Regular_ttf, PressStart2P_Regular_ttf_len);
     g_font = TTF_OpenFontRW(rw, 1, FONT_SIZE); // 1 to close the stream after
     if (!g_font) {
         SDL_Log("TTF_OpenFontRW failed: %s", TTF_GetError());
-        SDL_DestroyRenderer(g_renderer);
-        SDL_DestroyWindow(g_window);
-        if (g_audio_available) {
-            Mix_CloseAudio();
-            Mix_Quit();
-        }
-        TTF_Quit();
-        SDL_Quit();
+        close_sdl();
         return false;
     }
+    g_text_atlas = text_init(g_renderer, g_font);
+    return true;
+}
 
-    if (g_audio_available) {
-        // Create synthesized beep sound
-        g_alert_sound = create_beep(880, 500); // 880Hz (A5 note) for 500ms
-        if (!g_alert_sound) {
-            SDL_Log("Failed to create alert sound");
-        }
+/**
+ * @brief Opens the mixer and loads the alert tone. Runs on the audio thread started by init_sdl().
+ */
+static int open_audio(void* data) {
+    (void)data;
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        SDL_Log("SDL audio init failed: %s", SDL_GetError());
+        return 0;
     }
-
-    return true;
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+        SDL_Log("Mix_OpenAudio failed: %s", Mix_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return 0;
+    }
+    g_audio_available = true;
+
+    // 880 Hz (A5) for 500 ms, converted by the mixer to the device format
+    SDL_RWops* rw = SDL_RWFromConstMem(alert_tone_wav, alert_tone_wav_len);
+    g_alert_sound = Mix_LoadWAV_RW(rw, 1); // 1 => SDL frees rw
+    if (!g_alert_sound) {
+        SDL_Log("Failed to load alert sound: %s", Mix_GetError());
+        return 0;
+    }
+    g_alert_sound->volume = MIX_MAX_VOLUME / 4;
+    SDL_AtomicSet(&g_audio_ready, 1);
+    return 0;
 }
 
 /**
- * @brief Cleans up all SDL resources.
+ * @brief Cleans up all SDL resources. Also undoes a partial init_sdl().
  */
 void close_sdl() {
+    if (g_audio_thread) {
+        SDL_WaitThread(g_audio_thread, NULL);
+        g_audio_thread = NULL;
+    }
+    SDL_AtomicSet(&g_audio_ready, 0);
     if (g_alert_sound) {
         Mix_FreeChunk(g_alert_sound);
         g_alert_sound = NULL;
     }
+    text_shutdown();
+    g_text_atlas = false;
     if (g_font) {
         TTF_CloseFont(g_font);
         g_font = NULL;
@@ -343,15 +478,20 @@ void close_sdl() {
         Mix_Quit();
         g_audio_available = false;
     }
-    TTF_Quit();
+    if (TTF_WasInit()) TTF_Quit();
     SDL_Quit();
 }
 
 /**
  * @brief Renders a line of text to the screen at a given position and color.
+ * With the glyph atlas the text is queued and drawn by the next text_flush().
  */
 void render_text(const char* text, int x, int y, SDL_Color color) {
     if (!text || strlen(text) == 0) return;
+    if (g_text_atlas) {
+        text_draw(text, x, y, color);
+        return;
+    }
     SDL_Surface* text_surface = TTF_RenderText_Blended(g_font, text, color);
     if (text_surface) {
         SDL_Texture* text_texture = SDL_CreateTextureFromSurface(g_renderer, text_surface);
@@ -399,220 +539,119 @@ void render_compass(int center_x, int center_y, double bearing) {
     SDL_RenderDrawLine(g_renderer, end_x, end_y, arrow_x2, arrow_y2);
 }
 
-
 /**
- * @brief Creates a simple sine wave beep sound and returns it as an SDL_mixer Chunk.
+ * @brief Renders the nearest-traffic panel, the approach-zone count and the alerting sites.
  */
-Mix_Chunk* create_beep(int freq, int duration_ms) {
-    int sample_rate = 44100;
-    int num_samples = (duration_ms * sample_rate) / 1000;
-    int buffer_size = num_samples * sizeof(Sint16);
-    Sint16* buffer = (Sint16*)malloc(buffer_size);
-
-    if (!buffer) return NULL;
-
-    double volume = 4000;
-    for (int i = 0; i < num_samples; i++) {
-        buffer[i] = (Sint16)(volume * sin(2.0 * M_PI * freq * i / sample_rate));
+void render_traffic(int x, int y, const struct Snapshot* snap) {
+    SDL_Color yellow = {255, 255, 0, 255};
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color grey = {140, 140, 160, 255};
+    char buffer[64];
+
+    render_text("Nearby traffic", x, y, yellow); y += 30;
+    for (int i = 0; i < snap->traffic_count; i++) {
+        const struct TrafficEntry* e = &snap->traffic[i];
+        snprintf(buffer, sizeof(buffer), "%-8.8s%6.1fkm", e->label, e->distance_km);
+        render_text(buffer, x, y, i == 0 ? white : grey); y += 25;
     }
-
-    SDL_RWops* rw = SDL_RWFromMem(buffer, buffer_size);
-    if (!rw) {
-        free(buffer);
-        return NULL;
+    if (snap->in_zone_count >= 0) {
+        y += 15;
+        snprintf(buffer, sizeof(buffer), "In zone: %d", snap->in_zone_count);
+        render_text(buffer, x, y, snap->in_zone_count > 0 ? yellow : grey); y += 25;
     }
-
-    Mix_Chunk* chunk = Mix_LoadWAV_RW(rw, 1); // 1 => SDL frees rw
-    free(buffer); // Mix_LoadWAV_RW copies data, so we can free the buffer
-
-    if (chunk) {
-        chunk->volume = MIX_MAX_VOLUME / 4;
+    if (snap->site_count > 0) {
+        SDL_Color red = {255, 0, 0, 255};
+        y += 15;
+        snprintf(buffer, sizeof(buffer), "Sites: %d/%d alert", snap->sites_alerting, snap->site_count);
+        render_text(buffer, x, y, snap->sites_alerting > 0 ? red : grey); y += 25;
+        // Only alerting sites are listed; there may be hundreds in total
+        int shown = 0;
+        for (int i = 0; i < snap->site_count && shown < SNAPSHOT_TRAFFIC_MAX; i++) {
+            const struct SiteStatus* st = &snap->sites[i];
+            if (!st->alert) continue;
+            snprintf(buffer, sizeof(buffer), "%-8.8s%6.1fkm", g_sites[i].name, st->distance_km);
+            render_text(buffer, x, y, red); y += 25;
+            shown++;
+        }
     }
-
-    return chunk;
 }
 
 /**
- * @brief Fetches data from dump1090 and the ADSB API, then updates the global g_closest_plane struct.
+ * @brief Draws p50/p99/max per stage over the bottom of the window; stages without samples are left out.
  */
-void fetch_and_process_data() {
-    char dump1090_url[256];
-    snprintf(dump1090_url, sizeof(dump1090_url),
-             "http://%s:%d/dump1090-fa/data/aircraft.json", g_server_ip, DUMP1090_PORT);
-
-    CURL *curl_handle = curl_easy_init();
-    if (!curl_handle) return;
-    
-    struct MemoryStruct chunk = { .memory = malloc(1), .size = 0 };
-    if (!chunk.memory) {
-        curl_easy_cleanup(curl_handle);
-        return;
-    }
-    curl_easy_setopt(curl_handle, CURLOPT_URL, dump1090_url);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 10L);
-    CURLcode res = curl_easy_perform(curl_handle);
-
-    if (res == CURLE_OK && chunk.size > 0) {
-        cJSON *root = cJSON_Parse(chunk.memory);
-        if (root) {
-             cJSON *aircraft_array = cJSON_GetObjectItemCaseSensitive(root, "aircraft");
-             if (cJSON_IsArray(aircraft_array)) {
-                struct Aircraft local_closest = { .distance_km = 999999.9 };
-                bool plane_found = false;
-                
-                cJSON* aircraft_json;
-                cJSON_ArrayForEach(aircraft_json, aircraft_array) {
-                    cJSON *lat_json = cJSON_GetObjectItemCaseSensitive(aircraft_json, "lat");
-                    cJSON *lon_json = cJSON_GetObjectItemCaseSensitive(aircraft_json, "lon");
-                    if (cJSON_IsNumber(lat_json) && cJSON_IsNumber(lon_json)) {
-                         double dist = haversine_distance(g_user_lat, g_user_lon, lat_json->valuedouble, lon_json->valuedouble);
-                         if (dist < local_closest.distance_km) {
-                            plane_found = true;
-                            local_closest.distance_km = dist;
-                            local_closest.lat = lat_json->valuedouble;
-                            local_closest.lon = lon_json->valuedouble;
-                            local_closest.bearing_deg = calculate_bearing(g_user_lat, g_user_lon, local_closest.lat, local_closest.lon);
-                            
-                            // Extract all other data from dump1090 json
-                            cJSON *item;
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "flight");
-                            if (item && item->valuestring) snprintf(local_closest.flight, sizeof(local_closest.flight), "%s", item->valuestring); else snprintf(local_closest.flight, sizeof(local_closest.flight), "N/A");
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "hex");
-                            if (item && item->valuestring) snprintf(local_closest.hex, sizeof(local_closest.hex), "%s", item->valuestring); else snprintf(local_closest.hex, sizeof(local_closest.hex), "N/A");
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "squawk");
-                            if (item && item->valuestring) snprintf(local_closest.squawk, sizeof(local_closest.squawk), "%s", item->valuestring); else snprintf(local_closest.squawk, sizeof(local_closest.squawk), "N/A");
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "alt_baro");
-                            if (item) local_closest.altitude_ft = item->valueint; else local_closest.altitude_ft = 0;
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "gs");
-                            if (item) local_closest.ground_speed_kts = item->valuedouble; else local_closest.ground_speed_kts = 0;
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "track");
-                            if (item) local_closest.track_deg = item->valuedouble; else local_closest.track_deg = 0;
-                            item = cJSON_GetObjectItemCaseSensitive(aircraft_json, "baro_rate");
-                            if (item) local_closest.vert_rate_fpm = item->valueint; else local_closest.vert_rate_fpm = 0;
-                         }
-                    }
-                }
-                
-                if (plane_found) {
-                     g_closest_plane = local_closest; // Copy basic data over
-
-                    // Set default values for API fields before the lookup
-                    snprintf(g_closest_plane.registration, sizeof(g_closest_plane.registration), "N/A");
-                    snprintf(g_closest_plane.aircraft_type, sizeof(g_closest_plane.aircraft_type), "N/A");
-                    snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), "N/A");
-
-                    // Now fetch API data for the confirmed closest plane
-                    char api_url[256];
-                    snprintf(api_url, sizeof(api_url), "https://api.adsb.lol/v2/hex/%s", g_closest_plane.hex);
-                    struct MemoryStruct api_chunk = { .memory = malloc(1), .size = 0 };
-                    if (api_chunk.memory) {
-                        curl_easy_setopt(curl_handle, CURLOPT_URL, api_url);
-                        curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&api_chunk);
-                        if(curl_easy_perform(curl_handle) == CURLE_OK && api_chunk.size > 0) {
-                            cJSON *api_root = cJSON_Parse(api_chunk.memory);
-                            if(api_root) {
-                                cJSON *ac_array = cJSON_GetObjectItemCaseSensitive(api_root, "ac");
-                                if (cJSON_IsArray(ac_array) && cJSON_GetArraySize(ac_array) > 0) {
-                                    cJSON *ac_info = cJSON_GetArrayItem(ac_array, 0);
-                                    cJSON *item;
-                                    item = cJSON_GetObjectItemCaseSensitive(ac_info, "r");
-                                    if (item && item->valuestring) snprintf(g_closest_plane.registration, sizeof(g_closest_plane.registration), "%s", item->valuestring);
-                                    item = cJSON_GetObjectItemCaseSensitive(ac_info, "t");
-                                    if (item && item->valuestring) snprintf(g_closest_plane.aircraft_type, sizeof(g_closest_plane.aircraft_type), "%s", item->valuestring);
-                                    item = cJSON_GetObjectItemCaseSensitive(ac_info, "operator");
-                                    if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
-                                        snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), "%s", item->valuestring);
-                                    } else {
-                                        // Fallback keys used by some APIs
-                                        item = cJSON_GetObjectItemCaseSensitive(ac_info, "ownOp");
-                                        if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
-                                            snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), "%s", item->valuestring);
-                                        } else {
-                                            item = cJSON_GetObjectItemCaseSensitive(ac_info, "op");
-                                            if (item && cJSON_IsString(item) && item->valuestring && item->valuestring[0] != '\0') {
-                                                snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), "%s", item->valuestring);
-                                            }
-                                        }
-                                    }
-                                }
-                                cJSON_Delete(api_root);
-                            }
-                        }
-                        free(api_chunk.memory);
-                    }
-                } else {
-                    // No planes detected, reset to default state
-                    snprintf(g_closest_plane.flight, sizeof(g_closest_plane.flight), "No aircraft in range");
-                    snprintf(g_closest_plane.operator, sizeof(g_closest_plane.operator), " ");
-                    snprintf(g_closest_plane.registration, sizeof(g_closest_plane.registration), " ");
-                    snprintf(g_closest_plane.aircraft_type, sizeof(g_closest_plane.aircraft_type), " ");
-                    snprintf(g_closest_plane.hex, sizeof(g_closest_plane.hex), " ");
-                    snprintf(g_closest_plane.squawk, sizeof(g_closest_plane.squawk), " ");
-                    g_closest_plane.distance_km = 999999.9;
-                }
-             }
-             cJSON_Delete(root);
-        }
+void render_latency(int window_w, int window_h) {
+    SDL_Color yellow = {255, 255, 0, 255};
+    SDL_Color white = {255, 255, 255, 255};
+    struct LatencySummary rows[LAT_STAGE_COUNT];
+    int used = 0;
+    for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+        latency_summary((enum LatencyStage)s, &rows[s]);
+        used += rows[s].count > 0;
     }
 
-    free(chunk.memory);
-    curl_easy_cleanup(curl_handle);
-}
-
-
-// --- Utility Function Implementations ---
-
-double deg2rad(double deg) { return (deg * M_PI / 180.0); }
-
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if (ptr == NULL) return 0;
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
-    return realsize;
-}
-
-double haversine_distance(double lat1, double lon1, double lat2, double lon2) {
-    double dLat = deg2rad(lat2 - lat1);
-    double dLon = deg2rad(lon2 - lon1);
-    double a = sin(dLat / 2) * sin(dLat / 2) + cos(deg2rad(lat1)) * cos(deg2rad(lat2)) * sin(dLon / 2) * sin(dLon / 2);
-    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-    return EARTH_RADIUS_KM * c;
+    int height = 45 + (used > 0 ? used : 1) * 25;
+    SDL_Rect box = { 0, window_h - height, window_w, height };
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 210);
+    SDL_RenderFillRect(g_renderer, &box);
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_NONE);
+
+    char buffer[96];
+    int y = box.y + 10;
+    render_text("stage       p50 ms   p99 ms   max ms      n", 10, y, yellow); y += 30;
+    if (used == 0) render_text("no samples yet", 10, y, white);
+    for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+        const struct LatencySummary* r = &rows[s];
+        if (r->count == 0) continue;
+        snprintf(buffer, sizeof(buffer), "%-9s %8.2f %8.2f %8.2f %6llu", latency_stage_name((enum LatencyStage)s),
+                 r->p50_s * 1e3, r->p99_s * 1e3, r->max_s * 1e3, (unsigned long long)r->count);
+        render_text(buffer, 10, y, white); y += 25;
+    }
 }
 
 /**
- * @brief Calculates the initial bearing from point 1 to point 2.
- * @return The bearing in degrees (0-360).
+ * @brief Draws the radar view below `top`, centred on the observer, with a status line under it.
  */
-double calculate_bearing(double lat1, double lon1, double lat2, double lon2) {
-    double lon_diff = deg2rad(lon2 - lon1);
-    lat1 = deg2rad(lat1);
-    lat2 = deg2rad(lat2);
-    double y = sin(lon_diff) * cos(lat2);
-    double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon_diff);
-    double bearing = atan2(y, x);
-    bearing = fmod((bearing * 180.0 / M_PI + 360.0), 360.0); // Convert to degrees and normalize
-    return bearing;
+void render_radar(int window_w, int window_h, int top, double range_km) {
+    SDL_Color grey = {140, 140, 160, 255};
+    char buffer[160];
+    int bottom = window_h - 40;
+    int radius = (bottom - top) / 2 - 10;
+    if (radius > window_w / 2 - 10) radius = window_w / 2 - 10;
+    if (radius < 20) return;
+
+    struct RadarStats stats;
+    radar_draw(g_renderer, window_w / 2, (top + bottom) / 2, radius, range_km, &stats);
+    int n = snprintf(buffer, sizeof(buffer), "radar %.0f km, rings %.1f km | %d shown, %d labelled", range_km,
+                     range_km / RADAR_RING_COUNT, stats.targets, stats.labelled);
+    if (g_scope_view.dropped > 0 && n > 0 && (size_t)n < sizeof(buffer)) {
+        snprintf(buffer + n, sizeof(buffer) - (size_t)n, ", %d over the limit", g_scope_view.dropped);
+    }
+    render_text(buffer, 10, window_h - 30, grey);
 }
 
-
-const char* track_to_direction(double track_deg) {
-    static const char *directions[] = {"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"};
-    int index = (int)((track_deg / 22.5) + 0.5) % 16;
-    return directions[index];
+/**
+ * @brief Plays the alert tone; the call is traced since it can stall on the audio device lock.
+ * Before the audio thread has finished, the tone is held back until the next call once it has.
+ */
+static void play_alert(void) {
+    if (!SDL_AtomicGet(&g_audio_ready)) {
+        g_alert_pending = true;
+        return;
+    }
+    g_alert_pending = false;
+    double play_start = trace_begin();
+    Mix_PlayChannel(-1, g_alert_sound, 0);
+    trace_end("Mix_PlayChannel", "audio", play_start);
 }
 
-const char* get_squawk_description(const char* squawk) {
-    if (strcmp(squawk, "7700") == 0) return "General Emergency";
-    if (strcmp(squawk, "7600") == 0) return "Radio Failure";
-    if (strcmp(squawk, "7500") == 0) return "Hijacking";
-    if (strcmp(squawk, "7000") == 0) return "VFR Conspicuity";
-    return "Discrete Code";
+/**
+ * @brief Wakes the render loop when the fetch worker publishes a snapshot. Runs on the worker thread.
+ */
+static void notify_snapshot(void* userdata) {
+    (void)userdata;
+    SDL_Event event;
+    SDL_memset(&event, 0, sizeof(event));
+    event.type = g_snapshot_event;
+    SDL_PushEvent(&event);
 }
-
@@ -0,0 +1,101 @@
+/**
+ * @file pool.c
+ * @brief Slab pool with a LIFO free list, and a bump arena.
+ *
+ * The pool hands back the most recently freed index first, so a replacement
+ * record lands in memory that is likely still cached. The arena rounds every
+ * allocation up to POOL_ALIGN, which keeps SoA arrays carved from it aligned
+ * for the vector kernels.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+static size_t round_up(size_t n) {
+    return (n + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+}
+
+bool pool_init(struct Pool* p, size_t item_size, uint32_t capacity) {
+    memset(p, 0, sizeof(*p));
+    if (capacity == 0 || capacity > INT32_MAX) return false;
+    p->items = aligned_alloc(POOL_ALIGN, round_up(item_size * capacity));
+    p->next_free = malloc(capacity * sizeof(*p->next_free));
+    if (!p->items || !p->next_free) {
+        pool_free(p);
+        return false;
+    }
+    p->item_size = item_size;
+    p->capacity = capacity;
+    pool_reset(p);
+    return true;
+}
+
+void pool_free(struct Pool* p) {
+    free(p->items);
+    free(p->next_free);
+    memset(p, 0, sizeof(*p));
+}
+
+/**
+ * @brief Returns every item to the free list, lowest index first. Item contents are left as they were.
+ */
+void pool_reset(struct Pool* p) {
+    for (uint32_t i = 0; i < p->capacity; i++) p->next_free[i] = i + 1 < p->capacity ? (int32_t)(i + 1) : -1;
+    p->free_head = p->capacity ? 0 : -1;
+    p->used = 0;
+}
+
+/**
+ * @return A free item's index, or -1 when the pool is full. The item is not cleared.
+ */
+int32_t pool_take(struct Pool* p) {
+    int32_t i = p->free_head;
+    if (i < 0) return -1;
+    p->free_head = p->next_free[i];
+    p->used++;
+    return i;
+}
+
+void pool_give(struct Pool* p, int32_t index) {
+    p->next_free[index] = p->free_head;
+    p->free_head = index;
+    p->used--;
+}
+
+
+// --- Arena ---
+
+bool arena_init(struct Arena* a, size_t capacity) {
+    memset(a, 0, sizeof(*a));
+    capacity = round_up(capacity);
+    a->base = aligned_alloc(POOL_ALIGN, capacity ? capacity : POOL_ALIGN);
+    if (!a->base) return false;
+    a->capacity = capacity;
+    return true;
+}
+
+void arena_free(struct Arena* a) {
+    free(a->base);
+    memset(a, 0, sizeof(*a));
+}
+
+/**
+ * @brief Releases everything allocated since the last reset.
+ */
+void arena_reset(struct Arena* a) {
+    a->used = 0;
+}
+
+/**
+ * @return `size` bytes aligned to POOL_ALIGN, or NULL when the arena is exhausted.
+ */
+void* arena_alloc(struct Arena* a, size_t size) {
+    size = round_up(size);
+    if (size > a->capacity - a->used) return NULL;
+    void* ptr = a->base + a->used;
+    a->used += size;
+    if (a->used > a->high_water) a->high_water = a->used;
+    return ptr;
+}
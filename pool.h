@@ -0,0 +1,51 @@
+/**
+ * @file pool.h
+ * @brief Fixed-capacity memory for the fetch worker: a slab pool with stable indices and a per-cycle bump arena.
+ *
+ * Both take their whole capacity from the heap once, at startup, so a refresh
+ * cycle never allocates and the worst-case footprint is set by configuration.
+ * Neither is thread-safe.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define POOL_ALIGN 64 // Cache line; every pool item array and arena allocation starts on one
+
+// Equal-sized items addressed by index. An index stays valid, and its item in
+// place, from pool_take() until pool_give(), so other structures may hold it.
+struct Pool {
+    uint8_t* items;
+    int32_t* next_free; // Free-list links, -1 at the end
+    size_t item_size;
+    uint32_t capacity, used;
+    int32_t free_head;
+};
+
+// Scratch that lives until the next arena_reset(); allocation is a pointer bump.
+struct Arena {
+    uint8_t* base;
+    size_t capacity, used;
+    size_t high_water; // Largest `used` seen since arena_init()
+};
+
+bool pool_init(struct Pool* p, size_t item_size, uint32_t capacity);
+void pool_free(struct Pool* p);
+void pool_reset(struct Pool* p);
+int32_t pool_take(struct Pool* p);
+void pool_give(struct Pool* p, int32_t index);
+
+static inline void* pool_at(const struct Pool* p, int32_t index) {
+    return p->items + (size_t)index * p->item_size;
+}
+
+bool arena_init(struct Arena* a, size_t capacity);
+void arena_free(struct Arena* a);
+void arena_reset(struct Arena* a);
+void* arena_alloc(struct Arena* a, size_t size);
+
+#endif // POOL_H
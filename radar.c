@@ -0,0 +1,327 @@
+/**
+ * @file radar.c
+ * @brief Radar scope renderer: every target's blip, velocity vector, trail and label from persistent vertex buffers.
+ *
+ * Drawing hundreds of aircraft with one SDL_RenderDrawLine or render_text call
+ * per element costs a driver round trip each. Instead every target owns a fixed
+ * block of a vertex buffer: a quad for the blip, one for the velocity vector and
+ * one per trail segment, plus the label's glyph quads from the text atlas. A
+ * block is rewritten only when its target moved (or the view was panned or
+ * zoomed); the whole scope is then two SDL_RenderGeometry calls, one for the
+ * shapes and one for the labels.
+ *
+ * Level of detail is decided when the index lists are rebuilt, not per frame:
+ * targets outside the range ring are left out, vectors and trail segments that
+ * would be shorter than MIN_SEGMENT_PX are skipped, labels are dropped beyond
+ * RADAR_LABEL_RANGE_KM, and otherwise the nearest target in each label-sized
+ * screen cell gets the only label there.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "radar.h"
+#include "config.h"
+#include "text.h"
+
+#define RADAR_MAX_TARGETS SCOPE_MAX_TARGETS
+#define QUADS_PER_TARGET (2 + TRAIL_POINTS) // Blip, velocity vector, then one per trail segment
+#define QUAD_BLIP 0
+#define QUAD_VECTOR 1
+#define QUAD_TRAIL 2
+#define LABEL_GLYPHS 9 // ScopeTarget.label without its terminator
+#define HASH_SIZE 4096 // Power of two, at least twice RADAR_MAX_TARGETS
+#define BLIP_HALF_PX 2.5f
+#define LINE_HALF_PX 0.75f
+#define MIN_SEGMENT_PX 1.5f
+#define LABEL_CELL_W 72 // About seven glyphs of the 20 pt atlas at RADAR_LABEL_SCALE
+#define LABEL_CELL_H 14
+#define DECLUTTER_CELLS 8192
+#define RING_SEGMENTS 72
+
+struct Blip {
+    struct ScopeTarget target; // As last received
+    float x, y;                // Screen position of the last fix
+    float distance_km;
+    uint32_t quads;            // Bit per quad big enough to draw
+    int label_glyphs;
+    bool live;
+    bool placed;               // Vertices match `target` and the current view
+};
+
+static struct Blip g_blips[RADAR_MAX_TARGETS];
+static int g_free[RADAR_MAX_TARGETS]; // Free slots, lowest on top
+static int g_free_count = 0;
+static int g_slot_end = 0;            // One past the highest live slot
+static int32_t g_hash[HASH_SIZE];     // icao -> slot while radar_update() runs, -1 empty
+static bool g_seen[RADAR_MAX_TARGETS];
+static int g_order[RADAR_MAX_TARGETS]; // Slots inside the range ring, nearest first
+static uint8_t g_cells[DECLUTTER_CELLS];
+static SDL_FPoint g_unit_circle[RING_SEGMENTS + 1];
+
+static SDL_Vertex g_shape_vertices[RADAR_MAX_TARGETS * QUADS_PER_TARGET * 4];
+static int g_shape_indices[RADAR_MAX_TARGETS * QUADS_PER_TARGET * 6];
+static SDL_Vertex g_label_vertices[RADAR_MAX_TARGETS * LABEL_GLYPHS * 4];
+static int g_label_indices[RADAR_MAX_TARGETS * LABEL_GLYPHS * 6];
+static int g_shape_index_count = 0, g_label_index_count = 0;
+static int g_on_scope = 0, g_labelled = 0;
+static bool g_indices_stale = true;
+
+// The view the placed vertices were built for
+static int g_view_x = 0, g_view_y = 0, g_view_radius = 0;
+static double g_view_range = 0.0;
+
+static const SDL_Color g_blip_color = {80, 255, 120, 255};
+static const SDL_Color g_alert_color = {255, 60, 60, 255};
+static const SDL_Color g_vector_color = {200, 255, 200, 200};
+static const SDL_Color g_label_color = {150, 255, 170, 220};
+static const SDL_Color g_ring_color = {0, 90, 40, 255};
+
+/**
+ * @brief Empties the scope. Call once before the first radar_update().
+ */
+void radar_init() {
+    memset(g_blips, 0, sizeof(g_blips));
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) g_free[i] = RADAR_MAX_TARGETS - 1 - i;
+    g_free_count = RADAR_MAX_TARGETS;
+    g_slot_end = 0;
+    g_shape_index_count = g_label_index_count = 0;
+    g_on_scope = g_labelled = 0;
+    g_indices_stale = true;
+    g_view_radius = 0;
+    for (int i = 0; i <= RING_SEGMENTS; i++) {
+        double a = 2.0 * M_PI * i / RING_SEGMENTS;
+        g_unit_circle[i] = (SDL_FPoint){ (float)cos(a), (float)sin(a) };
+    }
+}
+
+static uint32_t hash_icao(uint32_t icao) {
+    return (icao * 2654435761u) & (HASH_SIZE - 1);
+}
+
+/**
+ * @brief Takes in a new frame: targets keep their slot, and only those whose data changed are re-placed.
+ * @return Targets added, changed or removed.
+ */
+int radar_update(const struct ScopeFrame* frame) {
+    memset(g_hash, 0xff, sizeof(g_hash));
+    for (int slot = 0; slot < g_slot_end; slot++) {
+        if (!g_blips[slot].live) continue;
+        uint32_t h = hash_icao(g_blips[slot].target.icao);
+        while (g_hash[h] >= 0) h = (h + 1) & (HASH_SIZE - 1);
+        g_hash[h] = slot;
+    }
+    memset(g_seen, 0, sizeof(g_seen));
+
+    int changed = 0;
+    for (int i = 0; i < frame->count; i++) {
+        const struct ScopeTarget* t = &frame->targets[i];
+        int slot = -1;
+        for (uint32_t h = hash_icao(t->icao); g_hash[h] >= 0; h = (h + 1) & (HASH_SIZE - 1)) {
+            if (g_blips[g_hash[h]].target.icao == t->icao) {
+                slot = g_hash[h];
+                break;
+            }
+        }
+        struct Blip* b;
+        if (slot < 0) {
+            if (g_free_count == 0) continue;
+            slot = g_free[--g_free_count];
+            if (slot >= g_slot_end) g_slot_end = slot + 1;
+            b = &g_blips[slot];
+            b->live = true;
+            b->placed = false;
+            changed++;
+        } else {
+            b = &g_blips[slot];
+            if (memcmp(&b->target, t, sizeof(*t)) != 0) {
+                b->placed = false;
+                changed++;
+            }
+        }
+        b->target = *t;
+        g_seen[slot] = true;
+    }
+
+    for (int slot = 0; slot < g_slot_end; slot++) {
+        if (!g_blips[slot].live || g_seen[slot]) continue;
+        g_blips[slot].live = false;
+        g_free[g_free_count++] = slot;
+        changed++;
+    }
+    while (g_slot_end > 0 && !g_blips[g_slot_end - 1].live) g_slot_end--;
+    if (changed) g_indices_stale = true;
+    return changed;
+}
+
+static void put_quad(SDL_Vertex* v, float x0, float y0, float x1, float y1, float nx, float ny, SDL_Color c) {
+    v[0] = (SDL_Vertex){ { x0 + nx, y0 + ny }, c, { 0, 0 } };
+    v[1] = (SDL_Vertex){ { x1 + nx, y1 + ny }, c, { 0, 0 } };
+    v[2] = (SDL_Vertex){ { x0 - nx, y0 - ny }, c, { 0, 0 } };
+    v[3] = (SDL_Vertex){ { x1 - nx, y1 - ny }, c, { 0, 0 } };
+}
+
+/**
+ * @brief A line as a thin quad.
+ * @return false, with nothing written, if it would be shorter than MIN_SEGMENT_PX.
+ */
+static bool put_segment(SDL_Vertex* v, float x0, float y0, float x1, float y1, SDL_Color c) {
+    float dx = x1 - x0, dy = y1 - y0;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len < MIN_SEGMENT_PX) return false;
+    put_quad(v, x0, y0, x1, y1, -dy / len * LINE_HALF_PX, dx / len * LINE_HALF_PX, c);
+    return true;
+}
+
+/**
+ * @brief Rewrites one target's vertex block for the current view.
+ */
+static void place_blip(int slot, float scale) {
+    struct Blip* b = &g_blips[slot];
+    const struct ScopeTarget* t = &b->target;
+    SDL_Vertex* v = &g_shape_vertices[(size_t)slot * QUADS_PER_TARGET * 4];
+    float cx = (float)g_view_x, cy = (float)g_view_y;
+    float x = cx + t->east_km * scale, y = cy - t->north_km * scale;
+    b->x = x;
+    b->y = y;
+    b->distance_km = sqrtf(t->east_km * t->east_km + t->north_km * t->north_km);
+
+    put_quad(&v[QUAD_BLIP * 4], x - BLIP_HALF_PX, y, x + BLIP_HALF_PX, y, 0.0f, BLIP_HALF_PX,
+             b->distance_km < PROXIMITY_ALERT_KM ? g_alert_color : g_blip_color);
+    b->quads = 1u << QUAD_BLIP;
+    float vx = x + t->east_kms * (float)RADAR_VECTOR_S * scale, vy = y - t->north_kms * (float)RADAR_VECTOR_S * scale;
+    if (put_segment(&v[QUAD_VECTOR * 4], x, y, vx, vy, g_vector_color)) b->quads |= 1u << QUAD_VECTOR;
+
+    // Earlier fixes, oldest first, joined up to the current one and fading with age
+    for (int k = 0; k < t->trail_len; k++) {
+        float x0 = cx + t->trail_east[k] * scale, y0 = cy - t->trail_north[k] * scale;
+        float x1 = x, y1 = y;
+        if (k + 1 < t->trail_len) {
+            x1 = cx + t->trail_east[k + 1] * scale;
+            y1 = cy - t->trail_north[k + 1] * scale;
+        }
+        SDL_Color c = g_blip_color;
+        c.a = (Uint8)(40 + 140 * (k + 1) / t->trail_len);
+        if (put_segment(&v[(QUAD_TRAIL + k) * 4], x0, y0, x1, y1, c)) b->quads |= 1u << (QUAD_TRAIL + k);
+    }
+
+    b->label_glyphs = text_layout(t->label, x + 2 * BLIP_HALF_PX, y - 2 * BLIP_HALF_PX, RADAR_LABEL_SCALE, g_label_color,
+                                  &g_label_vertices[(size_t)slot * LABEL_GLYPHS * 4], LABEL_GLYPHS);
+    b->placed = true;
+}
+
+static int closer_first(const void* a, const void* b) {
+    float da = g_blips[*(const int*)a].distance_km, db = g_blips[*(const int*)b].distance_km;
+    return (da > db) - (da < db);
+}
+
+static int push_quads(int* out, int base_vertex, int quads) {
+    for (int q = 0; q < quads; q++) {
+        int v = base_vertex + q * 4;
+        out[0] = v; out[1] = v + 1; out[2] = v + 2;
+        out[3] = v + 2; out[4] = v + 1; out[5] = v + 3;
+        out += 6;
+    }
+    return quads * 6;
+}
+
+/**
+ * @brief Picks what gets drawn: the level-of-detail pass, run only when a target or the view changed.
+ */
+static void build_indices() {
+    float r = (float)g_view_radius;
+    int n = 0;
+    for (int slot = 0; slot < g_slot_end; slot++) {
+        const struct Blip* b = &g_blips[slot];
+        float dx = b->x - (float)g_view_x, dy = b->y - (float)g_view_y;
+        if (b->live && dx * dx + dy * dy <= r * r) g_order[n++] = slot;
+    }
+    qsort(g_order, (size_t)n, sizeof(g_order[0]), closer_first);
+
+    g_shape_index_count = 0;
+    for (int i = 0; i < n; i++) {
+        int slot = g_order[i];
+        uint32_t quads = g_blips[slot].quads;
+        for (int q = 0; q < QUADS_PER_TARGET; q++) {
+            if (quads & (1u << q))
+                g_shape_index_count += push_quads(&g_shape_indices[g_shape_index_count], (slot * QUADS_PER_TARGET + q) * 4, 1);
+        }
+    }
+
+    g_label_index_count = 0;
+    g_labelled = 0;
+    int cols = 2 * g_view_radius / LABEL_CELL_W + 1, rows = 2 * g_view_radius / LABEL_CELL_H + 1;
+    if (g_view_range <= RADAR_LABEL_RANGE_KM && cols * rows <= DECLUTTER_CELLS) {
+        memset(g_cells, 0, (size_t)(cols * rows));
+        for (int i = 0; i < n; i++) {
+            const struct Blip* b = &g_blips[g_order[i]];
+            int col = (int)((b->x - (float)(g_view_x - g_view_radius)) / LABEL_CELL_W);
+            int row = (int)((b->y - (float)(g_view_y - g_view_radius)) / LABEL_CELL_H);
+            if (col < 0 || col >= cols || row < 0 || row >= rows || g_cells[row * cols + col]) continue;
+            g_cells[row * cols + col] = 1;
+            g_label_index_count += push_quads(&g_label_indices[g_label_index_count], g_order[i] * LABEL_GLYPHS * 4,
+                                              b->label_glyphs);
+            g_labelled++;
+        }
+    }
+    g_on_scope = n;
+    g_indices_stale = false;
+}
+
+static void draw_rings(SDL_Renderer* renderer) {
+    SDL_FPoint points[RING_SEGMENTS + 1];
+    SDL_SetRenderDrawColor(renderer, g_ring_color.r, g_ring_color.g, g_ring_color.b, g_ring_color.a);
+    for (int k = 1; k <= RADAR_RING_COUNT; k++) {
+        float radius = (float)g_view_radius * k / RADAR_RING_COUNT;
+        for (int i = 0; i <= RING_SEGMENTS; i++) {
+            points[i] = (SDL_FPoint){ g_view_x + g_unit_circle[i].x * radius, g_view_y + g_unit_circle[i].y * radius };
+        }
+        SDL_RenderDrawLinesF(renderer, points, RING_SEGMENTS + 1);
+    }
+    SDL_RenderDrawLine(renderer, g_view_x - g_view_radius, g_view_y, g_view_x + g_view_radius, g_view_y);
+    SDL_RenderDrawLine(renderer, g_view_x, g_view_y - g_view_radius, g_view_x, g_view_y + g_view_radius);
+}
+
+/**
+ * @brief Draws the scope centred on the observer, `range_km` out to the edge.
+ * @param stats Optional; filled with what this frame drew.
+ */
+void radar_draw(SDL_Renderer* renderer, int center_x, int center_y, int radius_px, double range_km,
+                struct RadarStats* stats) {
+    if (center_x != g_view_x || center_y != g_view_y || radius_px != g_view_radius || range_km != g_view_range) {
+        g_view_x = center_x;
+        g_view_y = center_y;
+        g_view_radius = radius_px;
+        g_view_range = range_km;
+        for (int slot = 0; slot < g_slot_end; slot++) g_blips[slot].placed = false;
+    }
+
+    float scale = (float)(radius_px / range_km); // px per km
+    int moved = 0;
+    for (int slot = 0; slot < g_slot_end; slot++) {
+        if (g_blips[slot].live && !g_blips[slot].placed) {
+            place_blip(slot, scale);
+            moved++;
+        }
+    }
+    if (moved || g_indices_stale) build_indices();
+
+    SDL_BlendMode previous;
+    SDL_GetRenderDrawBlendMode(renderer, &previous);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    draw_rings(renderer);
+    int vertices = g_slot_end * QUADS_PER_TARGET * 4;
+    if (g_shape_index_count > 0)
+        SDL_RenderGeometry(renderer, NULL, g_shape_vertices, vertices, g_shape_indices, g_shape_index_count);
+    if (g_label_index_count > 0 && text_atlas())
+        SDL_RenderGeometry(renderer, text_atlas(), g_label_vertices, g_slot_end * LABEL_GLYPHS * 4, g_label_indices,
+                           g_label_index_count);
+    SDL_SetRenderDrawBlendMode(renderer, previous);
+
+    if (stats) {
+        stats->targets = g_on_scope;
+        stats->moved = moved;
+        stats->labelled = g_labelled;
+    }
+}
@@ -0,0 +1,30 @@
+/**
+ * @file radar.h
+ * @brief Plan-position (radar scope) view of every tracked aircraft, drawn from cached vertex buffers.
+ */
+
+#ifndef RADAR_H
+#define RADAR_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "scope.h"
+
+#define RADAR_VECTOR_S 60.0         // Velocity vectors show where the aircraft will be in this long
+#define RADAR_LABEL_RANGE_KM 150.0  // Labels are left off when zoomed out further than this
+#define RADAR_LABEL_SCALE 0.5f      // Of the atlas glyph size
+#define RADAR_RING_COUNT 4          // Range rings, evenly spaced out to the range
+
+struct RadarStats {
+    int targets;  // On the scope, inside the range ring
+    int moved;    // Targets whose vertices were rebuilt by the last radar_draw()
+    int labelled; // After decluttering
+};
+
+void radar_init();
+int radar_update(const struct ScopeFrame* frame);
+void radar_draw(SDL_Renderer* renderer, int center_x, int center_y, int radius_px, double range_km,
+                struct RadarStats* stats);
+
+#endif // RADAR_H
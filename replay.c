@@ -0,0 +1,591 @@
+/**
+ * @file replay.c
+ * @brief Records every ingested aircraft.json to a compact binary log and replays it through the pipeline.
+ *
+ * Keeping raw JSON every REFRESH_INTERVAL_SECONDS runs to gigabytes a week. The
+ * recorder keeps only the fields the pipeline reads, quantized (1e-5 degree,
+ * 0.1 kt, 0.01 degree, 0.1 s), and stores each as a zigzag varint delta against
+ * the same aircraft's values from the same receiver in an earlier frame.
+ * Callsign and squawk are written only when they change.
+ *
+ * File layout, append-only, all integers little-endian:
+ *
+ *   session  "CPRL" u8 version, u64 wall-clock start in Unix ms
+ *   frame    'F' u8 type ('K' keyframe, 'D' delta) u32 payload length, payload
+ *   payload  varint time (keyframe: Unix ms; delta: zigzag ms since the previous frame),
+ *            varint block count, then per block: u8 source, varint count, records
+ *   record   varint key (24-bit ICAO, bit 24 for "~" addresses), varint flags
+ *            (PA_* presence bits, bit 16 callsign follows, bit 17 squawk follows),
+ *            then a zigzag delta per present numeric field and any changed text as u8 length + bytes
+ *
+ * One frame is one refresh cycle. A keyframe clears the delta state, so it can be
+ * decoded on its own; one is written every REPLAY_KEYFRAME_CYCLES, at the start of
+ * every session, and whenever the state table fills up. `<log>.idx` gets a
+ * {u64 Unix ms, u64 offset} entry per keyframe, so replay can seek without
+ * reading the log from the start. Every restart appends a new session.
+ *
+ * Replay runs on the fetch worker in place of libcurl: each frame is decoded into
+ * ParsedAircraft and fed to scan_apply_parsed(), then the cycle is finished
+ * exactly as fetch_and_process_data() does. The table runs on recording time,
+ * so eviction and trails see the real gaps between cycles whatever the speed.
+ * The replaying instance shows fixes as recorded (dead reckoning is off in this
+ * mode), but the published fix time is still shifted onto the worker's monotonic
+ * clock: a fan-out publisher turns it into the fix_age its subscribers
+ * dead-reckon from, and a recording-time stamp would read as a fix from the future.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aircraft.h"
+#include "config.h"
+#include "enrich.h"
+#include "replay.h"
+#include "scan.h"
+#include "scope.h"
+#include "timeutil.h"
+
+#define REPLAY_MAGIC "CPRL"
+#define REPLAY_VERSION 1
+#define REPLAY_KEYFRAME_CYCLES 120 // About ten minutes at the default refresh interval
+#define REPLAY_STATE_SLOTS 8192    // Power of two; aircraft per receiver tracked between keyframes
+#define REPLAY_MAX_GAP_S 10.0      // Longer pauses in the recording (restarts, outages) are shortened to this
+#define REPLAY_POLL_MS 100
+#define NON_ICAO_FLAG (1u << 24)   // As in scan.c
+#define FLAG_FLIGHT (1u << 16)
+#define FLAG_SQUAWK (1u << 17)
+
+// Quantized numeric fields, in record order
+enum { F_LAT, F_LON, F_ALT, F_GS, F_TRACK, F_VRATE, F_SEEN_POS, F_SEEN, F_MESSAGES, F_COUNT };
+static const uint32_t g_field_bits[F_COUNT] = {
+    PA_LAT, PA_LON, PA_ALT_BARO, PA_GS, PA_TRACK, PA_BARO_RATE, PA_SEEN_POS, PA_SEEN, PA_MESSAGES,
+};
+static const double g_field_scale[F_COUNT] = { 1e5, 1e5, 1, 10, 100, 1, 10, 10, 1 };
+
+// Last values written (or read) for one aircraft from one receiver
+struct LogState {
+    uint32_t id; // ((source << 25) | key) + 1; 0 marks an empty slot
+    int64_t q[F_COUNT];
+    char flight[24];
+    char squawk[6];
+};
+
+struct ByteBuf {
+    uint8_t* data;
+    size_t len, cap;
+};
+
+// Only the recorder or the replayer runs in a process, so they share the delta state
+static struct LogState g_state[REPLAY_STATE_SLOTS];
+static size_t g_state_used = 0;
+
+static FILE* g_log = NULL;
+static FILE* g_index = NULL;
+static struct ByteBuf g_blocks;        // Blocks of the frame being built
+static size_t g_block_count = 0;
+static bool g_frame_open = false;
+static bool g_frame_keyframe = false;
+static int g_cycles_since_keyframe = 0;
+static bool g_need_keyframe = true;
+static int64_t g_last_frame_ms = 0;
+
+static struct ParsedAircraft g_replayed[MAX_PARSED_AIRCRAFT];
+
+
+// --- Encoding helpers ---
+
+static bool buf_reserve(struct ByteBuf* b, size_t extra) {
+    if (b->len + extra <= b->cap) return true;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    uint8_t* p = realloc(b->data, cap);
+    if (!p) return false;
+    b->data = p;
+    b->cap = cap;
+    return true;
+}
+
+static void put_u8(struct ByteBuf* b, uint8_t v) {
+    if (buf_reserve(b, 1)) b->data[b->len++] = v;
+}
+
+static void put_varint(struct ByteBuf* b, uint64_t v) {
+    if (!buf_reserve(b, 10)) return;
+    do {
+        uint8_t byte = v & 0x7f;
+        v >>= 7;
+        b->data[b->len++] = byte | (v ? 0x80 : 0);
+    } while (v);
+}
+
+static void put_svarint(struct ByteBuf* b, int64_t v) {
+    put_varint(b, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static void put_text(struct ByteBuf* b, const char* s) {
+    size_t n = strlen(s);
+    put_u8(b, (uint8_t)n);
+    if (buf_reserve(b, n)) {
+        memcpy(b->data + b->len, s, n);
+        b->len += n;
+    }
+}
+
+static void put_le(uint8_t* out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t* in, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+};
+
+static uint64_t get_varint(struct Cursor* c) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (c->p >= c->end) break;
+        uint8_t byte = *c->p++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+    c->ok = false;
+    return 0;
+}
+
+static int64_t get_svarint(struct Cursor* c) {
+    uint64_t v = get_varint(c);
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static void get_text(struct Cursor* c, char* out, size_t len) {
+    size_t n = c->p < c->end ? *c->p++ : 0;
+    if (n >= len || (size_t)(c->end - c->p) < n) {
+        c->ok = false;
+        return;
+    }
+    memcpy(out, c->p, n);
+    out[n] = '\0';
+    c->p += n;
+}
+
+static int64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+// --- Delta state ---
+
+static void state_reset(void) {
+    memset(g_state, 0, sizeof(g_state));
+    g_state_used = 0;
+}
+
+/**
+ * @brief Finds or creates the slot for `id`. NULL when the table is full; encoder and decoder agree on that.
+ * @param fresh Set when the aircraft has no earlier values to delta against.
+ */
+static struct LogState* state_lookup(uint32_t id, bool* fresh) {
+    uint32_t i = (id * 2654435761u) & (REPLAY_STATE_SLOTS - 1);
+    for (size_t probe = 0; probe < REPLAY_STATE_SLOTS; probe++, i = (i + 1) & (REPLAY_STATE_SLOTS - 1)) {
+        if (g_state[i].id == id) {
+            *fresh = false;
+            return &g_state[i];
+        }
+        if (g_state[i].id == 0) {
+            *fresh = true;
+            if (g_state_used >= REPLAY_STATE_SLOTS - 1) return NULL;
+            g_state[i].id = id;
+            g_state_used++;
+            return &g_state[i];
+        }
+    }
+    *fresh = true;
+    return NULL;
+}
+
+static bool parse_key(const char* hex, uint32_t* key) {
+    bool non_icao = hex[0] == '~';
+    if (!icao_from_hex(non_icao ? hex + 1 : hex, key)) return false;
+    if (non_icao) *key |= NON_ICAO_FLAG;
+    return true;
+}
+
+static double field_value(const struct ParsedAircraft* p, int f) {
+    switch (f) {
+        case F_LAT: return p->lat;
+        case F_LON: return p->lon;
+        case F_ALT: return p->altitude_ft;
+        case F_GS: return p->ground_speed_kts;
+        case F_TRACK: return p->track_deg;
+        case F_VRATE: return p->vert_rate_fpm;
+        case F_SEEN_POS: return p->seen_pos_s;
+        case F_SEEN: return p->seen_s;
+        default: return (double)p->messages;
+    }
+}
+
+static void set_field(struct ParsedAircraft* p, int f, int64_t q) {
+    double v = (double)q / g_field_scale[f];
+    switch (f) {
+        case F_LAT: p->lat = v; break;
+        case F_LON: p->lon = v; break;
+        case F_ALT: p->altitude_ft = (int)q; break;
+        case F_GS: p->ground_speed_kts = v; break;
+        case F_TRACK: p->track_deg = v; break;
+        case F_VRATE: p->vert_rate_fpm = (int)q; break;
+        case F_SEEN_POS: p->seen_pos_s = v; break;
+        case F_SEEN: p->seen_s = v; break;
+        default: p->messages = (long)q; break;
+    }
+}
+
+
+// --- Recording ---
+
+/**
+ * @brief Opens (or appends a new session to) the log at `path` and its `.idx` keyframe index.
+ */
+bool replay_record_open(const char* path) {
+    char index_path[300];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    g_log = fopen(path, "ab");
+    g_index = g_log ? fopen(index_path, "ab") : NULL;
+    if (!g_log || !g_index) {
+        fprintf(stderr, "WARNING: Cannot record to %s: %s\n", path, strerror(errno));
+        replay_record_close();
+        return false;
+    }
+    fseek(g_log, 0, SEEK_END); // So ftell() gives true offsets for the index
+    uint8_t header[13];
+    memcpy(header, REPLAY_MAGIC, 4);
+    header[4] = REPLAY_VERSION;
+    g_last_frame_ms = wall_ms();
+    put_le(header + 5, (uint64_t)g_last_frame_ms, 8);
+    fwrite(header, 1, sizeof(header), g_log);
+    g_need_keyframe = true;
+    printf("INFO: Recording ingested aircraft to %s\n", path);
+    return true;
+}
+
+static void begin_frame(void) {
+    if (g_frame_open) return;
+    g_frame_open = true;
+    g_blocks.len = 0;
+    g_block_count = 0;
+    g_frame_keyframe = g_need_keyframe || g_cycles_since_keyframe >= REPLAY_KEYFRAME_CYCLES ||
+                       g_state_used > REPLAY_STATE_SLOTS * 3 / 4;
+    if (g_frame_keyframe) {
+        state_reset();
+        g_cycles_since_keyframe = 0;
+        g_need_keyframe = false;
+    }
+}
+
+static void encode_record(struct ByteBuf* b, uint8_t source, uint32_t key, const struct ParsedAircraft* p) {
+    bool fresh;
+    struct LogState none = { 0 };
+    struct LogState* st = state_lookup(((uint32_t)source << 25 | key) + 1, &fresh);
+    if (!st) st = &none;
+
+    uint32_t flags = p->present & 0xffff;
+    if ((p->present & PA_FLIGHT) && (fresh || strcmp(st->flight, p->flight) != 0)) flags |= FLAG_FLIGHT;
+    if ((p->present & PA_SQUAWK) && (fresh || strcmp(st->squawk, p->squawk) != 0)) flags |= FLAG_SQUAWK;
+    put_varint(b, key);
+    put_varint(b, flags);
+    for (int f = 0; f < F_COUNT; f++) {
+        if (!(p->present & g_field_bits[f])) continue;
+        int64_t q = llround(field_value(p, f) * g_field_scale[f]);
+        put_svarint(b, q - st->q[f]);
+        st->q[f] = q;
+    }
+    if (flags & FLAG_FLIGHT) {
+        put_text(b, p->flight);
+        snprintf(st->flight, sizeof(st->flight), "%s", p->flight);
+    }
+    if (flags & FLAG_SQUAWK) {
+        put_text(b, p->squawk);
+        snprintf(st->squawk, sizeof(st->squawk), "%s", p->squawk);
+    }
+}
+
+/**
+ * @brief Adds one receiver's parsed aircraft to the frame for the current cycle. No-op unless recording.
+ */
+void replay_record_source(uint8_t source, const struct ParsedAircraft* parsed, size_t count) {
+    if (!g_log) return;
+    begin_frame();
+    size_t valid = 0;
+    uint32_t key;
+    for (size_t i = 0; i < count; i++) valid += (parsed[i].present & PA_HEX) && parse_key(parsed[i].hex, &key);
+    put_u8(&g_blocks, source);
+    put_varint(&g_blocks, valid);
+    for (size_t i = 0; i < count; i++) {
+        if ((parsed[i].present & PA_HEX) && parse_key(parsed[i].hex, &key)) encode_record(&g_blocks, source, key, &parsed[i]);
+    }
+    g_block_count++;
+}
+
+/**
+ * @brief Ends the cycle and appends its frame, even with no blocks (every receiver answered 304).
+ */
+void replay_record_cycle() {
+    if (!g_log) return;
+    begin_frame();
+    g_frame_open = false;
+    g_cycles_since_keyframe++;
+
+    int64_t now_ms = wall_ms();
+    struct ByteBuf prefix = { 0 };
+    uint8_t prefix_bytes[32];
+    prefix.data = prefix_bytes;
+    prefix.cap = sizeof(prefix_bytes);
+    if (g_frame_keyframe) put_varint(&prefix, (uint64_t)now_ms);
+    else put_svarint(&prefix, now_ms - g_last_frame_ms);
+    put_varint(&prefix, g_block_count);
+    g_last_frame_ms = now_ms;
+
+    uint8_t header[6] = { 'F', g_frame_keyframe ? 'K' : 'D' };
+    put_le(header + 2, prefix.len + g_blocks.len, 4);
+    long offset = ftell(g_log);
+    bool ok = fwrite(header, 1, sizeof(header), g_log) == sizeof(header) &&
+              fwrite(prefix.data, 1, prefix.len, g_log) == prefix.len &&
+              fwrite(g_blocks.data, 1, g_blocks.len, g_log) == g_blocks.len && fflush(g_log) == 0;
+    if (ok && g_frame_keyframe) {
+        uint8_t entry[16];
+        put_le(entry, (uint64_t)now_ms, 8);
+        put_le(entry + 8, (uint64_t)offset, 8);
+        ok = fwrite(entry, 1, sizeof(entry), g_index) == sizeof(entry) && fflush(g_index) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "WARNING: Writing the replay log failed (%s), recording stopped\n", strerror(errno));
+        replay_record_close();
+    }
+}
+
+void replay_record_close() {
+    if (g_log) fclose(g_log);
+    if (g_index) fclose(g_index);
+    g_log = g_index = NULL;
+    free(g_blocks.data);
+    memset(&g_blocks, 0, sizeof(g_blocks));
+    g_frame_open = false;
+}
+
+
+// --- Replay ---
+
+struct LogReader {
+    FILE* f;
+    struct ByteBuf frame;
+    int64_t time_ms;
+    bool synced; // A keyframe has been read since the last seek or session start
+};
+
+/**
+ * @brief Reads the next frame into `r->frame`, stepping over session headers and deltas with no keyframe before them.
+ * @return 'K' or 'D', or 0 at the end of the log (including a frame cut short by a crash).
+ */
+static int read_frame(struct LogReader* r) {
+    for (;;) {
+        int c = fgetc(r->f);
+        if (c == 'C') {
+            uint8_t rest[12];
+            if (fread(rest, 1, sizeof(rest), r->f) != sizeof(rest) || memcmp(rest, REPLAY_MAGIC + 1, 3) != 0) return 0;
+            if (rest[3] != REPLAY_VERSION) {
+                fprintf(stderr, "WARNING: Replay log version %d is not supported\n", rest[3]);
+                return 0;
+            }
+            r->synced = false;
+            continue;
+        }
+        if (c != 'F') return 0;
+        uint8_t header[5];
+        if (fread(header, 1, sizeof(header), r->f) != sizeof(header)) return 0;
+        size_t len = (size_t)get_le(header + 1, 4);
+        r->frame.len = 0;
+        if (!buf_reserve(&r->frame, len) || fread(r->frame.data, 1, len, r->f) != len) return 0;
+        r->frame.len = len;
+        if (header[0] == 'K') r->synced = true;
+        if (r->synced) return header[0];
+    }
+}
+
+/**
+ * @brief Decodes one block into g_replayed.
+ * @return The number of aircraft, or -1 if the block is corrupt.
+ */
+static long decode_block(struct Cursor* c, uint8_t source) {
+    size_t count = (size_t)get_varint(c);
+    if (count > MAX_PARSED_AIRCRAFT) return -1;
+    for (size_t i = 0; i < count && c->ok; i++) {
+        struct ParsedAircraft* p = &g_replayed[i];
+        memset(p, 0, sizeof(*p));
+        uint32_t key = (uint32_t)get_varint(c);
+        uint32_t flags = (uint32_t)get_varint(c);
+        bool fresh;
+        struct LogState none = { 0 };
+        struct LogState* st = state_lookup(((uint32_t)source << 25 | key) + 1, &fresh);
+        if (!st) st = &none;
+
+        p->present = flags & 0xffff;
+        if (key & NON_ICAO_FLAG) snprintf(p->hex, sizeof(p->hex), "~%06x", key & ~NON_ICAO_FLAG);
+        else snprintf(p->hex, sizeof(p->hex), "%06x", key);
+        for (int f = 0; f < F_COUNT; f++) {
+            if (!(p->present & g_field_bits[f])) continue;
+            st->q[f] += get_svarint(c);
+            set_field(p, f, st->q[f]);
+        }
+        if (flags & FLAG_FLIGHT) get_text(c, st->flight, sizeof(st->flight));
+        if (flags & FLAG_SQUAWK) get_text(c, st->squawk, sizeof(st->squawk));
+        if (p->present & PA_FLIGHT) memcpy(p->flight, st->flight, sizeof(p->flight));
+        if (p->present & PA_SQUAWK) memcpy(p->squawk, st->squawk, sizeof(p->squawk));
+    }
+    return c->ok ? (long)count : -1;
+}
+
+/**
+ * @brief Positions the reader at the last keyframe at most `from_s` after the first one, using `<path>.idx`.
+ * @return false if there is no usable index; the caller then fast-forwards instead.
+ */
+static bool seek_keyframe(struct LogReader* r, const char* path, double from_s) {
+    char index_path[300];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    FILE* idx = fopen(index_path, "rb");
+    if (!idx) return false;
+    uint8_t entry[16];
+    int64_t first_ms = -1;
+    long offset = -1;
+    while (fread(entry, 1, sizeof(entry), idx) == sizeof(entry)) {
+        int64_t t = (int64_t)get_le(entry, 8);
+        if (first_ms < 0) first_ms = t;
+        if (t - first_ms > (int64_t)(from_s * 1000.0)) break;
+        offset = (long)get_le(entry + 8, 8);
+    }
+    fclose(idx);
+    if (offset < 0 || fseek(r->f, offset, SEEK_SET) != 0) return false;
+    r->synced = false;
+    return true;
+}
+
+static bool wait_until(double when, const atomic_bool* stop) {
+    while (!atomic_load(stop)) {
+        double left = when - monotonic_seconds();
+        if (left <= 0) return true;
+        poll(NULL, 0, left * 1000.0 < REPLAY_POLL_MS ? (int)(left * 1000.0) + 1 : REPLAY_POLL_MS);
+    }
+    return false;
+}
+
+/**
+ * @brief Feeds a recorded log through the pipeline until it ends or `stop` is set, then holds the last snapshot.
+ * @param speed Playback rate; 0 replays as fast as possible and reports pipeline throughput at the end.
+ * @param from_s Skips this many seconds of recording, measured from its first keyframe.
+ */
+void replay_run(const char* path, double speed, double from_s, struct Snapshot* snap, const atomic_bool* stop,
+                SnapshotSink publish) {
+    struct LogReader r = { 0 };
+    r.f = fopen(path, "rb");
+    if (!r.f) {
+        fprintf(stderr, "ERROR: Cannot open replay log %s: %s\n", path, strerror(errno));
+        while (!atomic_load(stop)) poll(NULL, 0, REPLAY_POLL_MS);
+        return;
+    }
+    bool seeked = from_s > 0 && seek_keyframe(&r, path, from_s);
+    printf("INFO: Replaying %s at %s\n", path, speed > 0 ? "recorded pace" : "full speed");
+    if (speed > 0 && speed != 1.0) printf("INFO: Replay speed %.2gx\n", speed);
+
+    state_reset();
+    table_clear();
+    memset(&snap->dump1090_stats, 0, sizeof(snap->dump1090_stats));
+    memset(&snap->api_stats, 0, sizeof(snap->api_stats));
+
+    int64_t first_ms = -1, prev_ms = 0, skip_until_ms = -1;
+    double base = monotonic_seconds(), play_clock = 0.0, pipeline_s = 0.0;
+    unsigned long cycles = 0, aircraft = 0;
+    int type;
+    while (!atomic_load(stop) && (type = read_frame(&r)) != 0) {
+        struct Cursor c = { r.frame.data, r.frame.data + r.frame.len, true };
+        if (type == 'K') {
+            r.time_ms = (int64_t)get_varint(&c);
+            state_reset();
+        } else {
+            r.time_ms += get_svarint(&c);
+        }
+        if (first_ms < 0) {
+            first_ms = prev_ms = r.time_ms;
+            if (from_s > 0 && !seeked) skip_until_ms = first_ms + (int64_t)(from_s * 1000.0);
+        }
+        bool skipping = r.time_ms < skip_until_ms; // Fast-forward: apply, but neither wait nor publish
+
+        if (speed > 0 && !skipping) {
+            double gap = (double)(r.time_ms - prev_ms) / 1000.0;
+            play_clock += (gap > REPLAY_MAX_GAP_S ? REPLAY_MAX_GAP_S : gap) / speed;
+            if (!wait_until(base + play_clock, stop)) break;
+        }
+        prev_ms = r.time_ms;
+
+        // Recorded time, so eviction sees the real gaps between cycles
+        double fetched_at = base + (double)(r.time_ms - first_ms) / 1000.0;
+        double t0 = monotonic_seconds();
+        memset(&snap->scan_stats, 0, sizeof(snap->scan_stats));
+        scan_begin_cycle();
+        size_t blocks = (size_t)get_varint(&c);
+        snap->sources_ok = snap->sources_total = 0;
+        for (size_t b = 0; b < blocks && c.ok && c.p < c.end; b++) {
+            uint8_t source = *c.p++;
+            long count = decode_block(&c, source);
+            if (count < 0) break;
+            scan_apply_parsed(g_replayed, (size_t)count, fetched_at, source, &snap->scan_stats);
+            aircraft += (unsigned long)count;
+            snap->sources_ok++;
+        }
+        if (!c.ok) {
+            fprintf(stderr, "WARNING: Corrupt frame in %s, resyncing at the next keyframe\n", path);
+            r.synced = false;
+            continue;
+        }
+        snap->sources_total = snap->sources_ok;
+        scan_evict(fetched_at, &snap->scan_stats);
+        snap->enrich_source = ENRICH_SOURCE_NONE;
+        if (scan_select_closest(snap, &g_observer)) snap->enrich_source = enrich_aircraft(&snap->closest, &snap->api_stats);
+        select_traffic(snap, &g_observer);
+        select_sites(snap);
+        select_predicted(snap, &g_observer, fetched_at);
+        scope_update(&g_observer);
+        pipeline_s += monotonic_seconds() - t0;
+        cycles++;
+        if (skipping) continue;
+        // Recording time to now, for fan-out's fix_age; they drift apart with --speed and shortened gaps
+        if (snap->plane_found && snap->closest.position_time > 0.0) {
+            snap->closest.position_time += monotonic_seconds() - fetched_at;
+        }
+        publish(snap);
+    }
+    fclose(r.f);
+    free(r.frame.data);
+
+    if (cycles > 0) {
+        double elapsed = monotonic_seconds() - base;
+        printf("INFO: Replay finished: %lu cycles, %lu aircraft, %.1f s of recording in %.2f s"
+               " (pipeline %.0f ns/aircraft, %.0f cycles/s)\n",
+               cycles, aircraft, (double)(prev_ms - first_ms) / 1000.0, elapsed,
+               aircraft ? pipeline_s * 1e9 / (double)aircraft : 0.0, pipeline_s > 0 ? (double)cycles / pipeline_s : 0.0);
+    } else {
+        fprintf(stderr, "WARNING: %s holds no complete frames\n", path);
+    }
+    while (!atomic_load(stop)) poll(NULL, 0, REPLAY_POLL_MS);
+}
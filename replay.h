@@ -0,0 +1,25 @@
+/**
+ * @file replay.h
+ * @brief Append-only, delta-encoded log of every ingested aircraft.json, and its replay through the pipeline.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aircraft_json.h"
+#include "snapshot.h"
+
+bool replay_record_open(const char* path);
+void replay_record_source(uint8_t source, const struct ParsedAircraft* parsed, size_t count);
+void replay_record_cycle();
+void replay_record_close();
+
+void replay_run(const char* path, double speed, double from_s, struct Snapshot* snap, const atomic_bool* stop,
+                SnapshotSink publish);
+
+#endif // REPLAY_H
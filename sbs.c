@@ -0,0 +1,338 @@
+/**
+ * @file sbs.c
+ * @brief Incremental BaseStation (SBS-1) stream decoder feeding the persistent aircraft table.
+ *
+ * Instead of re-downloading and re-parsing every aircraft every few seconds, the
+ * worker keeps a TCP connection to dump1090's port 30003 open and applies each
+ * position/velocity message to the aircraft table as it arrives. The closest
+ * aircraft is maintained per message: a message only forces a full rescan when
+ * the current closest aircraft moves away. Snapshots are published at most every
+ * SBS_PUBLISH_INTERVAL_S, except that an aircraft entering the alert radius is
+ * published immediately so the proximity alert is not delayed.
+ *
+ * Only the SBS text format is decoded; it carries positions already resolved by
+ * dump1090, whereas the Beast feed (port 30005) would need a full Mode S and CPR
+ * decoder here.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "aircraft_table.h"
+#include "config.h"
+#include "enrich.h"
+#include "geo_batch.h"
+#include "latency.h"
+#include "sbs.h"
+#include "scan.h"
+#include "scope.h"
+#include "timeutil.h"
+
+#define SBS_PUBLISH_INTERVAL_S 0.1
+#define SBS_POLL_MS 250
+#define SBS_CONNECT_TIMEOUT_S 5.0
+#define SBS_RECONNECT_MAX_S 30
+#define SBS_ENRICH_RETRY_S 30.0
+#define SBS_READ_BUFFER 65536
+#define SBS_MAX_FIELDS 22
+
+struct SbsState {
+    uint32_t closest_icao;
+    bool have_closest;
+    bool dirty;             // Closest aircraft changed since the last publish
+    bool published_inside;  // Last published closest was inside the alert radius
+    double last_publish;
+    double last_evict;
+    struct EnrichResult lookup; // Finished API lookup not yet published
+    bool have_lookup;
+};
+
+
+// --- Parsing ---
+
+/**
+ * @brief Decodes one "MSG,..." line in place. Empty fields are reported as absent.
+ * @return false for non-MSG lines and malformed input.
+ */
+bool sbs_parse_line(char* line, struct SbsMessage* msg) {
+    char* fields[SBS_MAX_FIELDS];
+    int n = 0;
+    char* p = line;
+    fields[n++] = p;
+    for (; *p && n < SBS_MAX_FIELDS; p++) {
+        if (*p == ',') {
+            *p = '\0';
+            fields[n++] = p + 1;
+        } else if (*p == '\r' || *p == '\n') {
+            *p = '\0';
+            break;
+        }
+    }
+    for (; *p; p++) {
+        if (*p == '\r' || *p == '\n') { *p = '\0'; break; }
+    }
+    if (n < 11 || strcmp(fields[0], "MSG") != 0) return false;
+
+    memset(msg, 0, sizeof(*msg));
+    msg->transmission_type = atoi(fields[1]);
+    if (!icao_from_hex(fields[4], &msg->icao)) return false;
+    snprintf(msg->hex, sizeof(msg->hex), "%s", fields[4]);
+    for (char* h = msg->hex; *h; h++) {
+        if (*h >= 'A' && *h <= 'F') *h = (char)(*h - 'A' + 'a'); // Match aircraft.json's lower-case hex
+    }
+
+    #define FIELD(i) ((i) < n && fields[i][0] != '\0' ? fields[i] : NULL)
+    const char* f;
+    if ((f = FIELD(10))) {
+        snprintf(msg->callsign, sizeof(msg->callsign), "%s", f);
+        size_t len = strlen(msg->callsign);
+        while (len > 0 && msg->callsign[len - 1] == ' ') msg->callsign[--len] = '\0';
+        msg->has_callsign = len > 0;
+    }
+    if ((f = FIELD(11))) { msg->altitude_ft = atoi(f); msg->has_altitude = true; }
+    if ((f = FIELD(12))) { msg->ground_speed_kts = atof(f); msg->has_speed = true; }
+    if ((f = FIELD(13))) { msg->track_deg = atof(f); msg->has_track = true; }
+    if (FIELD(14) && FIELD(15)) {
+        msg->lat = atof(fields[14]);
+        msg->lon = atof(fields[15]);
+        msg->has_position = true;
+    }
+    if ((f = FIELD(16))) { msg->vert_rate_fpm = atoi(f); msg->has_vert_rate = true; }
+    if ((f = FIELD(17))) { snprintf(msg->squawk, sizeof(msg->squawk), "%s", f); msg->has_squawk = true; }
+    #undef FIELD
+    return true;
+}
+
+
+// --- Table maintenance ---
+
+static void rescan_closest(struct SbsState* st) {
+    struct TrackedAircraft* best = table_closest(&g_observer);
+    st->have_closest = best != NULL;
+    st->closest_icao = best ? best->icao : 0;
+    st->dirty = true;
+}
+
+/**
+ * @brief Applies one message to the table and keeps the closest-aircraft choice current.
+ */
+static void apply_message(struct SbsState* st, const struct SbsMessage* msg, double now) {
+    struct TrackedAircraft* t = table_upsert(msg->icao, now);
+    if (!t) return; // Table full
+    struct Aircraft* ac = &t->ac;
+
+    snprintf(ac->hex, sizeof(ac->hex), "%s", msg->hex);
+    if (msg->has_callsign) snprintf(ac->flight, sizeof(ac->flight), "%s", msg->callsign);
+    if (msg->has_squawk) snprintf(ac->squawk, sizeof(ac->squawk), "%s", msg->squawk);
+    if (msg->has_altitude) ac->altitude_ft = msg->altitude_ft;
+    if (msg->has_speed) ac->ground_speed_kts = msg->ground_speed_kts;
+    if (msg->has_track) ac->track_deg = msg->track_deg;
+    if (msg->has_vert_rate) ac->vert_rate_fpm = msg->vert_rate_fpm;
+
+    bool is_closest = st->have_closest && st->closest_icao == t->icao;
+    if (!msg->has_position) {
+        if (is_closest) st->dirty = true;
+        return;
+    }
+
+    double previous_km = ac->distance_km;
+    table_set_position(t, msg->lat, msg->lon);
+    ac->distance_km = observer_distance_km(&g_observer, ac->lat, ac->lon);
+    ac->bearing_deg = observer_bearing(&g_observer, ac->lat, ac->lon);
+    t->last_position = now;
+    ac->position_time = now;
+    table_push_trail(t, msg->lat, msg->lon, now);
+
+    if (is_closest) {
+        // Moving away may hand "closest" to another aircraft; moving closer cannot.
+        if (ac->distance_km > previous_km) rescan_closest(st);
+        else st->dirty = true;
+    } else {
+        struct TrackedAircraft* current = st->have_closest ? table_find(st->closest_icao) : NULL;
+        if (!current || ac->distance_km < current->ac.distance_km) {
+            st->have_closest = true;
+            st->closest_icao = t->icao;
+            st->dirty = true;
+        }
+    }
+}
+
+/**
+ * @brief Publishes the closest aircraft if it changed, rate-limited except for alert-radius entries.
+ */
+static void maybe_publish(struct SbsState* st, struct Snapshot* snap, SnapshotSink publish, double now) {
+    if (!st->dirty) return;
+    struct TrackedAircraft* t = st->have_closest ? table_find(st->closest_icao) : NULL;
+    bool inside = t && t->ac.distance_km < PROXIMITY_ALERT_KM;
+    bool urgent = inside && !st->published_inside;
+    if (!urgent && now - st->last_publish < SBS_PUBLISH_INTERVAL_S) return;
+
+    memset(&snap->dump1090_stats, 0, sizeof(snap->dump1090_stats));
+    memset(&snap->scan_stats, 0, sizeof(snap->scan_stats));
+    memset(&snap->api_stats, 0, sizeof(snap->api_stats));
+    snap->enrich_source = ENRICH_SOURCE_NONE;
+    scan_begin_cycle();
+    if (t) {
+        if (st->have_lookup && strcmp(st->lookup.hex, t->ac.hex) == 0) {
+            snap->enrich_source = st->lookup.ok ? ENRICH_SOURCE_API : ENRICH_SOURCE_NONE;
+            snap->api_stats = st->lookup.stats;
+        } else if (!t->enriched && now >= t->enrich_retry_at) {
+            double started = latency_start();
+            enum EnrichSource source = enrich_aircraft(&t->ac, &snap->api_stats);
+            latency_end(LAT_ENRICH, started);
+            snap->enrich_source = source;
+            // A lookup in flight or held back by the breaker is asked again once it settles
+            t->enriched = source == ENRICH_SOURCE_DATABASE || source == ENRICH_SOURCE_CACHE;
+            if (source == ENRICH_SOURCE_NONE || source == ENRICH_SOURCE_BACKOFF) t->enrich_retry_at = now + SBS_ENRICH_RETRY_S;
+        }
+        st->have_lookup = false;
+        snap->closest = t->ac;
+        snap->plane_found = true;
+    } else {
+        aircraft_reset(&snap->closest, "No aircraft in range");
+        snap->plane_found = false;
+    }
+    select_traffic(snap, &g_observer);
+    select_sites(snap);
+    select_predicted(snap, &g_observer, now);
+    scope_update(&g_observer);
+    publish(snap);
+    st->published_inside = inside;
+    st->last_publish = now;
+    st->dirty = false;
+}
+
+
+/**
+ * @brief Collects a finished API lookup without waiting and applies it to its table entry.
+ */
+static void collect_lookup(struct SbsState* st, double now) {
+    struct EnrichResult result;
+    uint32_t icao;
+    if (!enrich_poll(0, &result) || !icao_from_hex(result.hex, &icao)) return;
+    struct TrackedAircraft* t = table_find(icao);
+    if (!t) return;
+    if (result.ok) {
+        aircraft_apply_enrichment(&t->ac, &result.info);
+        t->enriched = true;
+    } else {
+        t->enrich_retry_at = now + SBS_ENRICH_RETRY_S;
+    }
+    if (st->have_closest && st->closest_icao == icao) {
+        st->lookup = result;
+        st->have_lookup = true;
+        st->dirty = true;
+    }
+}
+
+
+// --- Connection handling ---
+
+static bool wait_or_stop(double seconds, const atomic_bool* stop) {
+    double until = monotonic_seconds() + seconds;
+    while (!atomic_load(stop) && monotonic_seconds() < until) poll(NULL, 0, SBS_POLL_MS);
+    return !atomic_load(stop);
+}
+
+/**
+ * @brief Opens a non-blocking TCP connection, giving up after SBS_CONNECT_TIMEOUT_S or on stop.
+ * @return The socket, or -1.
+ */
+static int sbs_connect(const char* host, int port, const atomic_bool* stop) {
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* res = NULL;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai && fd < 0 && !atomic_load(stop); ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS) {
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        double deadline = monotonic_seconds() + SBS_CONNECT_TIMEOUT_S;
+        int ready = 0;
+        while (!atomic_load(stop) && monotonic_seconds() < deadline && (ready = poll(&pfd, 1, SBS_POLL_MS)) == 0) {}
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (ready <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+/**
+ * @brief Runs the streaming ingest loop until `stop` is set, reconnecting with backoff.
+ */
+void sbs_ingest_run(const char* host, int port, struct Snapshot* snap, const atomic_bool* stop, SnapshotSink publish) {
+    static char buf[SBS_READ_BUFFER];
+    struct SbsState st = { 0 };
+    int backoff_s = 1;
+    rescan_closest(&st); // The table may have been warm-started
+
+    while (!atomic_load(stop)) {
+        int fd = sbs_connect(host, port, stop);
+        if (fd < 0) {
+            if (!atomic_load(stop)) fprintf(stderr, "WARNING: SBS connect to %s:%d failed, retrying in %d s\n", host, port, backoff_s);
+            if (!wait_or_stop(backoff_s, stop)) break;
+            backoff_s = backoff_s * 2 > SBS_RECONNECT_MAX_S ? SBS_RECONNECT_MAX_S : backoff_s * 2;
+            continue;
+        }
+        printf("INFO: Streaming SBS from %s:%d\n", host, port);
+        backoff_s = 1;
+        size_t used = 0;
+
+        while (!atomic_load(stop)) {
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            int ready = poll(&pfd, 1, SBS_POLL_MS);
+            double now = monotonic_seconds();
+
+            if (ready > 0) {
+                ssize_t got = recv(fd, buf + used, sizeof(buf) - 1 - used, 0);
+                if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+                    fprintf(stderr, "WARNING: SBS stream from %s:%d closed\n", host, port);
+                    break;
+                }
+                if (got > 0) used += (size_t)got;
+
+                // Decode every complete line; keep a trailing partial line for the next read
+                char* start = buf;
+                char* nl;
+                buf[used] = '\0';
+                while ((nl = memchr(start, '\n', used - (size_t)(start - buf))) != NULL) {
+                    *nl = '\0';
+                    struct SbsMessage msg;
+                    if (sbs_parse_line(start, &msg)) apply_message(&st, &msg, now);
+                    start = nl + 1;
+                }
+                used -= (size_t)(start - buf);
+                memmove(buf, start, used);
+                if (used == sizeof(buf) - 1) used = 0; // Line longer than the buffer: discard
+            }
+
+            if (now - st.last_evict >= 1.0) {
+                if (table_evict_stale(now, g_track_timeout_s) > 0) rescan_closest(&st);
+                st.last_evict = now;
+            }
+            collect_lookup(&st, now);
+            maybe_publish(&st, snap, publish, now);
+        }
+        close(fd);
+    }
+}
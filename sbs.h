@@ -0,0 +1,29 @@
+/**
+ * @file sbs.h
+ * @brief Streaming ingest of dump1090's BaseStation (SBS-1) output on port 30003.
+ */
+
+#ifndef SBS_H
+#define SBS_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+struct SbsMessage {
+    uint32_t icao;
+    char hex[10];
+    int transmission_type; // MSG,1..8
+    bool has_callsign, has_altitude, has_speed, has_track, has_position, has_vert_rate, has_squawk;
+    char callsign[24];
+    char squawk[6];
+    int altitude_ft, vert_rate_fpm;
+    double ground_speed_kts, track_deg, lat, lon;
+};
+
+bool sbs_parse_line(char* line, struct SbsMessage* msg);
+void sbs_ingest_run(const char* host, int port, struct Snapshot* snap, const atomic_bool* stop, SnapshotSink publish);
+
+#endif // SBS_H
@@ -0,0 +1,365 @@
+/**
+ * @file scan.c
+ * @brief Scan, then materialize: selection works on the indexed table, full records are built for winners.
+ *
+ * Stage 1 (scan) folds each receiver's parsed aircraft.json into the aircraft
+ * table incrementally, keeping the freshest position when receivers overlap: an entry whose message count has not moved is skipped outright,
+ * and distance, bearing and the grid cell are only re-derived for entries with a
+ * new position. Stage 2 (select) is any table query: table_nearest() for the closest
+ * aircraft or the traffic panel, table_within() for the alert radius,
+ * table_in_polygon() for the approach zone, and the same queries again from
+ * every configured site, and a closest-point-of-approach pass over every moving
+ * aircraft for the predictive alert. Stage 3 (materialize) computes the
+ * bearing and builds the published records only for the entries selected.
+ * The SBS stream feeds the same table, so stages 2 and 3 are shared.
+ *
+ * scan_init() sizes everything from the table capacity, once. Parse output and
+ * query scratch come from a bump arena that scan_begin_cycle() rewinds, so a
+ * cycle allocates nothing and the pipeline's footprint is known at startup.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "latency.h"
+#include "pool.h"
+#include "scan.h"
+
+#define NON_ICAO_FLAG (1u << 24) // dump1090's "~" addresses, kept apart from real ICAO ones
+
+// Per-cycle scratch, rewound by scan_begin_cycle()
+static struct Arena g_scratch;
+static struct ParsedAircraft* g_parsed; // Flat parse output for aircraft.json, taken on the first document
+static size_t g_parsed_capacity;
+
+// Moving aircraft for the CPA kernel; the table entries behind its slots are cycle scratch
+static struct MotionBatch g_motion;
+
+/**
+ * @brief Sizes the table, the parse buffer and the CPA batch for `capacity` aircraft, and clears the table.
+ * A document may list up to twice that, since dump1090 keeps listing aircraft long after they go quiet.
+ */
+bool scan_init(size_t capacity) {
+    if (g_motion.capacity == capacity && table_capacity() == capacity) {
+        table_clear();
+        scan_begin_cycle();
+        return true;
+    }
+    arena_free(&g_scratch);
+    motion_batch_free(&g_motion);
+    g_parsed_capacity = capacity * 2 > MAX_PARSED_AIRCRAFT ? MAX_PARSED_AIRCRAFT : capacity * 2;
+    size_t scratch = g_parsed_capacity * sizeof(struct ParsedAircraft) + capacity * sizeof(struct TrackedAircraft*) +
+                     2 * POOL_ALIGN;
+    if (!table_init(capacity) || !motion_batch_init(&g_motion, capacity) || !arena_init(&g_scratch, scratch)) {
+        fprintf(stderr, "ERROR: Cannot allocate room for %zu aircraft\n", capacity);
+        return false;
+    }
+    scan_begin_cycle();
+    printf("INFO: Tracking up to %zu aircraft in %zu KiB\n", capacity, scan_footprint() / 1024);
+    return true;
+}
+
+/**
+ * @brief Bytes preallocated for the table, the CPA batch and the cycle scratch.
+ */
+size_t scan_footprint() {
+    return table_footprint() + g_scratch.capacity +
+           g_motion.capacity * (6 * sizeof(double) + sizeof(uint32_t));
+}
+
+/**
+ * @brief Largest cycle scratch used so far, in bytes.
+ */
+size_t scan_scratch_high_water() {
+    return g_scratch.high_water;
+}
+
+/**
+ * @brief Starts a refresh: releases the previous cycle's parse output and query scratch.
+ */
+void scan_begin_cycle() {
+    arena_reset(&g_scratch);
+    g_parsed = NULL;
+}
+
+static bool table_key(const char* hex, uint32_t* key) {
+    if (hex[0] == '~') {
+        if (!icao_from_hex(hex + 1, key)) return false;
+        *key |= NON_ICAO_FLAG;
+        return true;
+    }
+    return icao_from_hex(hex, key);
+}
+
+/**
+ * @brief Copies the non-position fields of `p` into `ac`.
+ */
+static void apply_fields(const struct ParsedAircraft* p, struct Aircraft* ac) {
+    // Same sizes on both sides, so plain copies keep the terminators
+    memcpy(ac->hex, p->hex, sizeof(ac->hex));
+    if (p->present & PA_FLIGHT) memcpy(ac->flight, p->flight, sizeof(ac->flight));
+    else snprintf(ac->flight, sizeof(ac->flight), "N/A");
+    if (p->present & PA_SQUAWK) memcpy(ac->squawk, p->squawk, sizeof(ac->squawk));
+    else snprintf(ac->squawk, sizeof(ac->squawk), "N/A");
+    ac->altitude_ft = p->altitude_ft;
+    ac->ground_speed_kts = p->ground_speed_kts;
+    ac->track_deg = p->track_deg;
+    ac->vert_rate_fpm = p->vert_rate_fpm;
+}
+
+/**
+ * @brief Stage 1: folds one receiver's parsed aircraft into the table, keeping the freshest data per aircraft.
+ * Call once per receiver, then scan_evict() once per cycle.
+ * @param fetched_at monotonic_seconds() when the document was received; message and fix times are this minus seen/seen_pos.
+ * @param source Index of the receiver, so its message counts are only compared with its own.
+ * @param stats Accumulates how many entries were re-derived and skipped.
+ */
+void scan_apply_parsed(const struct ParsedAircraft* parsed, size_t count, double fetched_at, uint8_t source,
+                       struct ScanStats* stats) {
+    stats->listed += count;
+    for (size_t i = 0; i < count; i++) {
+        const struct ParsedAircraft* p = &parsed[i];
+        uint32_t key;
+        if (!(p->present & PA_HEX) || !table_key(p->hex, &key)) continue;
+
+        double seen = (p->present & PA_SEEN) ? p->seen_s : 0.0;
+        double heard = fetched_at - seen;
+        if (seen > g_track_timeout_s) { // dump1090 keeps listing aircraft for minutes after they go quiet
+            stats->skipped++;
+            continue;
+        }
+        struct TrackedAircraft* t = table_find(key);
+        bool known = t != NULL;
+        double previous_heard = known ? t->last_seen : 0.0;
+        if (!known && !(t = table_upsert(key, heard))) { // Table full; aircraft already tracked still update
+            stats->skipped++;
+            continue;
+        }
+        struct Aircraft* ac = &t->ac;
+
+        // Nothing new has been heard by this receiver since the last cycle
+        if (known && t->source == source && (p->present & PA_MESSAGES) && p->messages == t->messages) {
+            stats->skipped++;
+            continue;
+        }
+        // Another receiver may have heard the aircraft more recently; its fields win
+        if (!known || heard >= previous_heard) {
+            t->last_seen = heard;
+            t->messages = p->messages;
+            t->source = source;
+            apply_fields(p, ac);
+        }
+
+        if ((p->present & (PA_LAT | PA_LON)) != (PA_LAT | PA_LON)) {
+            if (t->pos_source == source) table_clear_position(t); // This receiver's fix went stale
+            stats->skipped++;
+            continue;
+        }
+        double fix_time = fetched_at - ((p->present & PA_SEEN_POS) ? p->seen_pos_s : 0.0);
+        if (t->has_position && ((p->lat == ac->lat && p->lon == ac->lon) || fix_time <= t->last_position)) {
+            stats->skipped++; // Same fix as last cycle, or older than another receiver's
+            continue;
+        }
+        table_set_position(t, p->lat, p->lon);
+        ac->distance_km = observer_distance_km(&g_observer, ac->lat, ac->lon);
+        ac->bearing_deg = observer_bearing(&g_observer, ac->lat, ac->lon);
+        ac->position_time = fix_time;
+        t->last_position = fix_time;
+        t->pos_source = source;
+        table_push_trail(t, p->lat, p->lon, fix_time);
+        stats->updated++;
+    }
+}
+
+/**
+ * @brief Folds an older document into a table that already has live data, for documents applied newest first.
+ * Aircraft already tracked only gain trail points older than their trail; their fields and position are
+ * left alone. Aircraft not yet tracked are added as scan_apply_parsed() would.
+ */
+void scan_backfill_parsed(const struct ParsedAircraft* parsed, size_t count, double fetched_at, uint8_t source,
+                          struct ScanStats* stats) {
+    for (size_t i = 0; i < count; i++) {
+        const struct ParsedAircraft* p = &parsed[i];
+        uint32_t key;
+        if (!(p->present & PA_HEX) || !table_key(p->hex, &key)) continue;
+        struct TrackedAircraft* t = table_find(key);
+        if (!t) {
+            scan_apply_parsed(p, 1, fetched_at, source, stats);
+            continue;
+        }
+        stats->listed++;
+        double fix_time = fetched_at - ((p->present & PA_SEEN_POS) ? p->seen_pos_s : 0.0);
+        if ((p->present & (PA_LAT | PA_LON)) != (PA_LAT | PA_LON) || !t->has_position || fix_time >= t->last_position) {
+            stats->skipped++;
+            continue;
+        }
+        table_prepend_trail(t, p->lat, p->lon, fix_time);
+        stats->updated++;
+    }
+}
+
+/**
+ * @brief Ends a cycle: drops aircraft not heard by any receiver for g_track_timeout_s.
+ */
+void scan_evict(double now, struct ScanStats* stats) {
+    stats->evicted = table_evict_stale(now, g_track_timeout_s);
+}
+
+/**
+ * @brief Stage 1 for one receiver's raw aircraft.json: extract, then fold into the table.
+ * @param parsed If not NULL, receives the extracted aircraft, valid until the next call.
+ * @return The number of aircraft listed, or -1 if the document could not be parsed.
+ */
+long scan_ingest_document(const char* json, size_t len, double fetched_at, uint8_t source, struct ScanStats* stats,
+                          const struct ParsedAircraft** parsed) {
+    // One buffer per cycle, reused for each receiver's document
+    if (!g_parsed && !(g_parsed = arena_alloc(&g_scratch, g_parsed_capacity * sizeof(*g_parsed)))) return -1;
+    double t = latency_start();
+    long count = aircraft_json_extract(json, len, g_parsed, g_parsed_capacity, NULL);
+    latency_end(LAT_PARSE, t);
+    if (count >= 0) {
+        t = latency_start();
+        scan_apply_parsed(g_parsed, (size_t)count, fetched_at, source, stats);
+        latency_end(LAT_SCAN, t);
+    }
+    if (parsed) *parsed = g_parsed;
+    return count;
+}
+
+/**
+ * @brief Stages 2 and 3 for the closest aircraft: one nearest query, then the record for the winner only.
+ * @return Whether an aircraft was found; otherwise `snap->closest` holds the "no aircraft" placeholder.
+ */
+bool scan_select_closest(struct Snapshot* snap, const struct Observer* obs) {
+    struct TableHit hit;
+    snap->plane_found = table_nearest(obs, 1, &hit) == 1;
+    if (snap->plane_found) materialize_hit(&hit, obs, &snap->closest);
+    else aircraft_reset(&snap->closest, "No aircraft in range");
+    return snap->plane_found;
+}
+
+/**
+ * @brief Stage 3: builds the published record for a selected table entry.
+ */
+void materialize_hit(const struct TableHit* hit, const struct Observer* obs, struct Aircraft* out) {
+    *out = hit->t->ac;
+    out->distance_km = hit->distance_km;
+    out->bearing_deg = observer_bearing(obs, out->lat, out->lon);
+}
+
+/**
+ * @brief Fills the traffic panel and the alert-radius and approach-zone counts of `snap`.
+ */
+void select_traffic(struct Snapshot* snap, const struct Observer* obs) {
+    struct TableHit hits[SNAPSHOT_TRAFFIC_MAX];
+    size_t n = table_nearest(obs, SNAPSHOT_TRAFFIC_MAX, hits);
+    for (size_t i = 0; i < n; i++) {
+        const struct Aircraft* ac = &hits[i].t->ac;
+        struct TrafficEntry* e = &snap->traffic[i];
+        bool has_flight = ac->flight[0] && ac->flight[0] != ' ' && strcmp(ac->flight, "N/A") != 0;
+        snprintf(e->label, sizeof(e->label), "%s", has_flight ? ac->flight : ac->hex);
+        e->distance_km = hits[i].distance_km;
+        e->altitude_ft = ac->altitude_ft;
+        materialize_hit(&hits[i], obs, &snap->contenders[i]);
+    }
+    snap->traffic_count = (int)n;
+    snap->contender_count = (int)n; // select_predicted() adds its aircraft
+    snap->in_radius_count = (int)table_within(obs, PROXIMITY_ALERT_KM, NULL, 0);
+    snap->in_zone_count = g_zone_points >= 3 ? (int)table_in_polygon(obs, g_zone, g_zone_points, NULL, 0) : -1;
+}
+
+/**
+ * @brief Fills the closest aircraft and alert state of every configured site.
+ * Each site is one grid-ring nearest query plus a radius count, so the cost
+ * grows with the sites and the traffic around them, not with the table size.
+ */
+void select_sites(struct Snapshot* snap) {
+    snap->sites_alerting = 0;
+    for (size_t i = 0; i < g_site_count; i++) {
+        const struct Site* site = &g_sites[i];
+        struct SiteStatus* st = &snap->sites[i];
+        struct TableHit hit;
+        memset(st, 0, sizeof(*st));
+        st->found = table_nearest(&site->obs, 1, &hit) == 1;
+        if (st->found) {
+            const struct Aircraft* ac = &hit.t->ac;
+            memcpy(st->hex, ac->hex, sizeof(st->hex));
+            memcpy(st->flight, ac->flight, sizeof(st->flight));
+            st->distance_km = hit.distance_km;
+            st->bearing_deg = observer_bearing(&site->obs, ac->lat, ac->lon);
+            st->altitude_ft = ac->altitude_ft;
+            st->alert = hit.distance_km < site->alert_km;
+            if (st->alert) st->in_radius_count = (int)table_within(&site->obs, site->alert_km, NULL, 0);
+        }
+        snap->sites_alerting += st->alert;
+    }
+    snap->site_count = (int)g_site_count;
+}
+
+/**
+ * @brief Predicts which aircraft outside the alert radius will enter it within g_predict_horizon_s.
+ * Every positioned aircraft with a ground speed goes through one batch CPA pass, assuming a
+ * constant track and speed from its last fix; only those whose closest approach is inside
+ * the radius are looked at further. An aircraft whose vertical rate would take it to the
+ * ground before it arrives is left out. Fills `snap->predicted`, soonest first, and adds the
+ * listed aircraft to the contenders after select_traffic()'s.
+ * @param now monotonic_seconds() the predictions are relative to.
+ */
+void select_predicted(struct Snapshot* snap, const struct Observer* obs, double now) {
+    snap->predicted_count = 0;
+    if (g_predict_horizon_s <= 0) return;
+    const struct Aircraft* listed[SNAPSHOT_PREDICTED_MAX]; // Parallel to snap->predicted
+    struct TrackedAircraft** entries = arena_alloc(&g_scratch, g_motion.capacity * sizeof(*entries));
+    if (!entries) return;
+
+    motion_batch_clear(&g_motion);
+    size_t cursor = 0;
+    struct TrackedAircraft* t;
+    while (table_next(&cursor, &t)) {
+        const struct Aircraft* ac = &t->ac;
+        if (!t->has_position || ac->ground_speed_kts <= 0.0 || ac->distance_km < PROXIMITY_ALERT_KM) continue;
+        entries[g_motion.count] = t;
+        motion_batch_add(&g_motion, ac->lat, ac->lon, ac->ground_speed_kts, ac->track_deg, (uint32_t)g_motion.count);
+    }
+    batch_cpa(obs, &g_motion);
+
+    double radius_sq = PROXIMITY_ALERT_KM * PROXIMITY_ALERT_KM;
+    for (size_t i = 0; i < g_motion.count; i++) {
+        if (g_motion.cpa_km_sq[i] >= radius_sq) continue;
+        const struct Aircraft* ac = &entries[g_motion.ref[i]]->ac;
+        // The track crosses the circle half a chord before the closest approach
+        double speed_kms = sqrt(g_motion.east_kms[i] * g_motion.east_kms[i] + g_motion.north_kms[i] * g_motion.north_kms[i]);
+        double from_fix = g_motion.t_cpa_s[i] - sqrt(radius_sq - g_motion.cpa_km_sq[i]) / speed_kms;
+        double t_enter = from_fix - (ac->position_time > 0.0 ? now - ac->position_time : 0.0);
+        if (t_enter <= 0.0 || t_enter > g_predict_horizon_s) continue;
+        int altitude_ft = ac->altitude_ft + (int)(ac->vert_rate_fpm * from_fix / 60.0);
+        if (ac->altitude_ft > 0 && altitude_ft <= 0) continue; // Lands first
+
+        // Insert by time; only the soonest SNAPSHOT_PREDICTED_MAX are kept
+        int n = snap->predicted_count < SNAPSHOT_PREDICTED_MAX ? snap->predicted_count : SNAPSHOT_PREDICTED_MAX;
+        int at = n;
+        while (at > 0 && snap->predicted[at - 1].t_enter_s > t_enter) at--;
+        snap->predicted_count++;
+        if (at >= SNAPSHOT_PREDICTED_MAX) continue;
+        if (n == SNAPSHOT_PREDICTED_MAX) n--;
+        memmove(&snap->predicted[at + 1], &snap->predicted[at], (size_t)(n - at) * sizeof(snap->predicted[0]));
+        memmove(&listed[at + 1], &listed[at], (size_t)(n - at) * sizeof(listed[0]));
+        listed[at] = ac;
+        struct PredictedEntry* e = &snap->predicted[at];
+        bool has_flight = ac->flight[0] && ac->flight[0] != ' ' && strcmp(ac->flight, "N/A") != 0;
+        snprintf(e->label, sizeof(e->label), "%s", has_flight ? ac->flight : ac->hex);
+        memcpy(e->hex, ac->hex, sizeof(e->hex));
+        e->t_enter_s = t_enter;
+        e->cpa_km = sqrt(g_motion.cpa_km_sq[i]);
+        e->altitude_ft = altitude_ft;
+    }
+
+    int n = snap->predicted_count < SNAPSHOT_PREDICTED_MAX ? snap->predicted_count : SNAPSHOT_PREDICTED_MAX;
+    for (int i = 0; i < n; i++) {
+        bool known = false;
+        for (int j = 0; j < snap->contender_count && !known; j++) known = strcmp(snap->contenders[j].hex, listed[i]->hex) == 0;
+        if (!known) snap->contenders[snap->contender_count++] = *listed[i];
+    }
+}
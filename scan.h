@@ -0,0 +1,36 @@
+/**
+ * @file scan.h
+ * @brief The scan -> select -> materialize pipeline from parsed aircraft to snapshot records.
+ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+#include "aircraft.h"
+#include "aircraft_json.h"
+#include "aircraft_table.h"
+#include "geo_batch.h"
+#include "snapshot.h"
+
+#define MAX_PARSED_AIRCRAFT 4096 // Largest aircraft.json extracted per receiver, whatever the table capacity
+
+bool scan_init(size_t capacity);
+size_t scan_footprint();
+size_t scan_scratch_high_water();
+void scan_begin_cycle();
+void scan_apply_parsed(const struct ParsedAircraft* parsed, size_t count, double fetched_at, uint8_t source,
+                       struct ScanStats* stats);
+void scan_backfill_parsed(const struct ParsedAircraft* parsed, size_t count, double fetched_at, uint8_t source,
+                          struct ScanStats* stats);
+void scan_evict(double now, struct ScanStats* stats);
+long scan_ingest_document(const char* json, size_t len, double fetched_at, uint8_t source, struct ScanStats* stats,
+                          const struct ParsedAircraft** parsed);
+bool scan_select_closest(struct Snapshot* snap, const struct Observer* obs);
+void materialize_hit(const struct TableHit* hit, const struct Observer* obs, struct Aircraft* out);
+void select_traffic(struct Snapshot* snap, const struct Observer* obs);
+void select_sites(struct Snapshot* snap);
+void select_predicted(struct Snapshot* snap, const struct Observer* obs, double now);
+
+#endif // SCAN_H
@@ -0,0 +1,114 @@
+/**
+ * @file scope.c
+ * @brief Builds the radar frame from the aircraft table and publishes it with a single-writer seqlock.
+ *
+ * As in snapshot.c, the counter is odd while a write is in progress and readers
+ * retry if it changed while they copied. Only the targets in use are copied on
+ * either side, so a quiet sky costs a few hundred bytes rather than the whole frame.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "scope.h"
+
+static atomic_bool g_scope_on = false;
+static _Atomic uint32_t g_scope_seq = 0;
+static struct ScopeFrame g_scope_data;
+static struct ScopeFrame g_scope_build; // Worker-side, filled before it is copied under the seqlock
+
+static size_t frame_bytes(int count) {
+    return offsetof(struct ScopeFrame, targets) + (size_t)count * sizeof(struct ScopeTarget);
+}
+
+/**
+ * @brief Starts or stops scope_update() building frames. Any thread.
+ */
+void scope_enable(bool on) {
+    atomic_store_explicit(&g_scope_on, on, memory_order_relaxed);
+}
+
+static void fill_target(struct ScopeTarget* st, const struct TrackedAircraft* t, const struct Observer* obs) {
+    const struct Aircraft* ac = &t->ac;
+    double east, north;
+    memset(st, 0, sizeof(*st)); // Also the bytes past the label and trail, so readers can compare targets whole
+    st->icao = t->icao;
+    observer_project(obs, ac->lat, ac->lon, &east, &north);
+    st->east_km = (float)east;
+    st->north_km = (float)north;
+    double speed_kms = ac->ground_speed_kts * (1.852 / 3600.0);
+    double track_rad = ac->track_deg * (M_PI / 180.0);
+    st->east_kms = (float)(speed_kms * sin(track_rad));
+    st->north_kms = (float)(speed_kms * cos(track_rad));
+    st->position_time = ac->position_time > 0.0 ? ac->position_time : t->last_position;
+    st->altitude_ft = ac->altitude_ft;
+
+    bool has_flight = ac->flight[0] && ac->flight[0] != ' ' && strcmp(ac->flight, "N/A") != 0;
+    const char* label = has_flight ? ac->flight : ac->hex; // Callsigns are at most 8 characters
+    size_t n = strnlen(label, sizeof(st->label) - 1);
+    while (n > 0 && label[n - 1] == ' ') n--;
+    memcpy(st->label, label, n); // Terminated by the memset above
+
+    struct TrailPoint trail[TRAIL_POINTS];
+    st->trail_len = (uint8_t)table_trail(t, trail);
+    for (int i = 0; i < st->trail_len; i++) {
+        observer_project(obs, trail[i].lat, trail[i].lon, &east, &north);
+        st->trail_east[i] = (float)east;
+        st->trail_north[i] = (float)north;
+    }
+}
+
+/**
+ * @brief Publishes every positioned aircraft in the table, if the radar view has asked for them.
+ * Must only be called from the fetch worker, after the table is up to date for the cycle.
+ */
+void scope_update(const struct Observer* obs) {
+    if (!atomic_load_explicit(&g_scope_on, memory_order_relaxed)) return;
+    struct ScopeFrame* f = &g_scope_build;
+    f->count = 0;
+    f->dropped = 0;
+    size_t cursor = 0;
+    struct TrackedAircraft* t;
+    while (table_next(&cursor, &t)) {
+        if (!t->has_position) continue;
+        if (f->count == SCOPE_MAX_TARGETS) {
+            f->dropped++;
+            continue;
+        }
+        fill_target(&f->targets[f->count++], t, obs);
+    }
+
+    uint32_t seq = atomic_load_explicit(&g_scope_seq, memory_order_relaxed);
+    atomic_store_explicit(&g_scope_seq, seq + 1, memory_order_relaxed); // odd: write in progress
+    atomic_thread_fence(memory_order_release);
+    memcpy(&g_scope_data, f, frame_bytes(f->count));
+    atomic_store_explicit(&g_scope_seq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief Copies the latest frame into `out`; only out->count targets are written.
+ * @return The sequence number of the copied frame (0 if nothing has been published yet).
+ */
+uint32_t scope_read(struct ScopeFrame* out) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&g_scope_seq, memory_order_acquire);
+        if (before & 1) continue; // writer is mid-copy
+        memcpy(out, &g_scope_data, frame_bytes(0));
+        if (out->count < 0 || out->count > SCOPE_MAX_TARGETS) out->count = 0; // Torn; the retry below catches it
+        memcpy(out->targets, g_scope_data.targets, (size_t)out->count * sizeof(out->targets[0]));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&g_scope_seq, memory_order_relaxed);
+        if (before == after) break;
+    } while (1);
+    return before / 2;
+}
+
+/**
+ * @brief Returns the current sequence number without copying, so callers can cheaply poll for changes.
+ */
+uint32_t scope_sequence(void) {
+    return atomic_load_explicit(&g_scope_seq, memory_order_acquire) / 2;
+}
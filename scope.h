@@ -0,0 +1,44 @@
+/**
+ * @file scope.h
+ * @brief Every tracked aircraft with its velocity and trail, handed from the fetch worker to the radar view.
+ *
+ * Published beside the snapshot through its own seqlock, since it is two orders
+ * of magnitude larger. The worker only builds it while a reader has asked for it
+ * with scope_enable(), so the text panel and the headless daemon pay nothing.
+ */
+
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aircraft_table.h"
+#include "geo_batch.h"
+
+#define SCOPE_MAX_TARGETS 2048 // Aircraft past this are left off the scope
+
+// One aircraft, in kilometres from the observer (see observer_project())
+struct ScopeTarget {
+    uint32_t icao;
+    float east_km, north_km;       // At the last fix
+    float east_kms, north_kms;     // Ground velocity
+    double position_time;          // monotonic_seconds() of the last fix; a new value means it moved
+    int altitude_ft;
+    char label[10];                // Callsign without padding, or the hex address
+    uint8_t trail_len;
+    float trail_east[TRAIL_POINTS], trail_north[TRAIL_POINTS]; // Earlier fixes, oldest first
+};
+
+struct ScopeFrame {
+    int count;
+    int dropped; // Positioned aircraft past SCOPE_MAX_TARGETS
+    struct ScopeTarget targets[SCOPE_MAX_TARGETS];
+};
+
+void scope_enable(bool on);
+void scope_update(const struct Observer* obs);
+uint32_t scope_read(struct ScopeFrame* out);
+uint32_t scope_sequence(void);
+
+#endif // SCOPE_H
@@ -0,0 +1,66 @@
+/**
+ * @file snapshot.c
+ * @brief Single-writer seqlock holding the most recently published snapshot.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+static _Atomic uint32_t g_snapshot_seq = 0;
+static struct Snapshot g_snapshot_data;
+
+/**
+ * @brief Publishes a new snapshot. Must only be called from the fetch worker.
+ */
+void snapshot_publish(const struct Snapshot* snap) {
+    uint32_t seq = atomic_load_explicit(&g_snapshot_seq, memory_order_relaxed);
+    atomic_store_explicit(&g_snapshot_seq, seq + 1, memory_order_relaxed); // odd: write in progress
+    atomic_thread_fence(memory_order_release);
+    memcpy(&g_snapshot_data, snap, sizeof(g_snapshot_data));
+    atomic_store_explicit(&g_snapshot_seq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief Copies the latest snapshot into `out`.
+ * @return The sequence number of the copied snapshot (0 if nothing has been published yet).
+ */
+uint32_t snapshot_read(struct Snapshot* out) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&g_snapshot_seq, memory_order_acquire);
+        if (before & 1) continue; // writer is mid-copy
+        memcpy(out, &g_snapshot_data, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&g_snapshot_seq, memory_order_relaxed);
+        if (before == after) break;
+    } while (1);
+    return before / 2;
+}
+
+/**
+ * @brief Returns the current sequence number without copying, so callers can cheaply poll for changes.
+ */
+uint32_t snapshot_sequence(void) {
+    return atomic_load_explicit(&g_snapshot_seq, memory_order_acquire) / 2;
+}
+
+/**
+ * @brief Dead-reckons the closest aircraft and every contender to `now` and writes whichever is then nearest.
+ * The worker only re-selects the closest each refresh, but another aircraft can close inside its distance
+ * in between. The closest keeps its looked-up details while it still wins.
+ */
+void snapshot_project_closest(const struct Snapshot* snap, double now, const struct Observer* obs,
+                              struct Aircraft* out) {
+    *out = snap->closest;
+    if (!snap->plane_found) return;
+    aircraft_extrapolate(out, now, obs);
+    for (int i = 0; i < snap->contender_count; i++) {
+        const struct Aircraft* c = &snap->contenders[i];
+        if (strcmp(c->hex, snap->closest.hex) == 0) continue;
+        struct Aircraft projected = *c;
+        aircraft_extrapolate(&projected, now, obs);
+        if (projected.distance_km < out->distance_km) *out = projected;
+    }
+}
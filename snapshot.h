@@ -0,0 +1,92 @@
+/**
+ * @file snapshot.h
+ * @brief Lock-free hand-off of the latest closest-aircraft result to the render loop.
+ *
+ * The fetch worker is the only writer; any number of threads may read. Writes
+ * are guarded by a sequence counter (seqlock): the counter is odd while a write
+ * is in progress, and a reader retries if it changed while copying. Neither side
+ * ever blocks on the other, so the display never waits on network I/O.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aircraft.h"
+#include "config.h"
+#include "enrich.h"
+#include "http.h"
+
+#define SNAPSHOT_TRAFFIC_MAX 5 // Rows in the traffic panel
+#define SNAPSHOT_PREDICTED_MAX 5 // Predicted breaches kept, soonest first
+#define SNAPSHOT_CONTENDERS_MAX (SNAPSHOT_TRAFFIC_MAX + SNAPSHOT_PREDICTED_MAX)
+
+// One row of the nearest-traffic panel
+struct TrafficEntry {
+    char label[24]; // Callsign, or the hex address when there is none
+    double distance_km;
+    int altitude_ft;
+};
+
+// An aircraft outside the alert radius that is predicted to enter it within the horizon
+struct PredictedEntry {
+    char label[24]; // Callsign, or the hex address when there is none
+    char hex[10];
+    double t_enter_s; // Seconds from the snapshot until it crosses into the radius
+    double cpa_km;    // Distance from the observer at the closest approach
+    int altitude_ft;  // Extrapolated with the vertical rate to the crossing
+};
+
+// Closest aircraft and alert state for one configured site
+struct SiteStatus {
+    char hex[10], flight[24];
+    double distance_km, bearing_deg;
+    int altitude_ft;
+    int in_radius_count; // Aircraft inside the site's alert_km; only counted while `alert`
+    bool found, alert;
+};
+
+// What one aircraft.json cycle did to the aircraft table
+struct ScanStats {
+    size_t listed;  // Entries in the documents of all receivers
+    size_t updated; // New position: grid cell, distance and bearing re-derived
+    size_t skipped; // No new position since the last cycle, or too stale to track
+    size_t evicted; // Dropped after g_track_timeout_s without a message
+};
+
+struct Snapshot {
+    struct Aircraft closest;
+    bool plane_found;
+    struct TrafficEntry traffic[SNAPSHOT_TRAFFIC_MAX]; // Nearest first; traffic[0] is `closest`
+    int traffic_count;
+    int in_radius_count; // Aircraft inside PROXIMITY_ALERT_KM
+    int in_zone_count;   // Aircraft inside the approach zone, -1 if none is configured
+    struct PredictedEntry predicted[SNAPSHOT_PREDICTED_MAX];
+    int predicted_count; // Aircraft predicted to enter PROXIMITY_ALERT_KM; only the first few are listed
+    // The traffic and listed predicted aircraft as full records, so the display can dead-reckon each
+    // and re-pick the closest between refreshes (see snapshot_project_closest())
+    struct Aircraft contenders[SNAPSHOT_CONTENDERS_MAX];
+    int contender_count;
+    struct SiteStatus sites[MAX_SITES]; // Parallel to g_sites; only the first site_count are valid
+    int site_count;
+    int sites_alerting;
+    struct TransferStats dump1090_stats; // Timings of the slowest receiver in the cycle that produced this snapshot
+    int sources_ok, sources_total;       // Receivers that answered this cycle, and how many are configured
+    struct ScanStats scan_stats;         // Zeroed in SBS mode
+    struct TransferStats api_stats;      // Zeroed when no API lookup ran
+    enum EnrichSource enrich_source;
+    double next_refresh_s;               // Poll interval the worker chose after this cycle; 0 outside polling mode
+};
+
+// Where a producer (polling, SBS stream, fan-out subscriber) hands each finished snapshot
+typedef void (*SnapshotSink)(const struct Snapshot* snap);
+
+void snapshot_publish(const struct Snapshot* snap);
+uint32_t snapshot_read(struct Snapshot* out);
+uint32_t snapshot_sequence(void);
+void snapshot_project_closest(const struct Snapshot* snap, double now, const struct Observer* obs,
+                              struct Aircraft* out);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,196 @@
+/**
+ * @file text.c
+ * @brief Glyph atlas text renderer.
+ *
+ * Rasterizing each line with TTF_RenderText_Blended and uploading it as a new
+ * texture every frame was the dominant CPU cost on the Raspberry Pi displays,
+ * even though the text only changes every few seconds. Instead, printable ASCII
+ * is rasterized once into a single atlas texture. Drawing text only appends
+ * coloured quads to a vertex buffer, and text_flush() submits everything queued
+ * in one SDL_RenderGeometry call.
+ *
+ * The build rasterizes the same atlas into font_atlas.h (tools/mkatlas.c), so
+ * normally startup only uploads it and never opens the font. text_init() is the
+ * fallback for a font size the build did not rasterize.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "text.h"
+#include "font_atlas.h"
+
+#define BATCH_MAX_GLYPHS 2048
+
+struct Glyph {
+    SDL_Rect src;  // Location in the atlas
+    int advance;
+};
+
+static SDL_Renderer* g_text_renderer = NULL;
+static SDL_Texture* g_atlas = NULL;
+static int g_atlas_w = 0, g_atlas_h = 0;
+static struct Glyph g_glyphs[ATLAS_GLYPHS];
+
+static SDL_Vertex g_vertices[BATCH_MAX_GLYPHS * 4];
+static int g_indices[BATCH_MAX_GLYPHS * 6];
+static int g_batch_glyphs = 0;
+
+/**
+ * @brief Common tail of both initializers, once g_atlas holds the texture (or NULL on failure).
+ */
+static bool finish_init(SDL_Renderer* renderer) {
+    if (!g_atlas) {
+        SDL_Log("Glyph atlas unavailable: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(g_atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(g_atlas, SDL_ScaleModeLinear); // For text_layout() below 1:1; identical at 1:1
+    for (int g = 0; g < BATCH_MAX_GLYPHS; g++) {
+        int v = g * 4, *idx = &g_indices[g * 6];
+        idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v + 2; idx[4] = v + 1; idx[5] = v + 3;
+    }
+    g_text_renderer = renderer;
+    return true;
+}
+
+/**
+ * @brief Uploads the atlas rasterized at build time.
+ * @return false if it was built for another point size or the texture could not be created; use text_init() then.
+ */
+bool text_init_prebuilt(SDL_Renderer* renderer, int pt_size) {
+    if (pt_size != FONT_ATLAS_PT) return false;
+    Uint32* pixels = malloc(sizeof(Uint32) * FONT_ATLAS_W * FONT_ATLAS_H);
+    if (!pixels) return false;
+    SDL_PixelFormat* format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA32);
+    if (format) {
+        for (int i = 0; i < FONT_ATLAS_W * FONT_ATLAS_H; i++)
+            pixels[i] = SDL_MapRGBA(format, 255, 255, 255, font_atlas_alpha[i]);
+        SDL_FreeFormat(format);
+        g_atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, FONT_ATLAS_W, FONT_ATLAS_H);
+        if (g_atlas && SDL_UpdateTexture(g_atlas, NULL, pixels, FONT_ATLAS_W * (int)sizeof(Uint32)) != 0) {
+            SDL_DestroyTexture(g_atlas);
+            g_atlas = NULL;
+        }
+    }
+    free(pixels);
+    if (!g_atlas) return false;
+
+    g_atlas_w = FONT_ATLAS_W;
+    g_atlas_h = FONT_ATLAS_H;
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+        const short* gl = font_atlas_glyphs[i];
+        g_glyphs[i].src = (SDL_Rect){ gl[0], gl[1], gl[2], gl[3] };
+        g_glyphs[i].advance = gl[4];
+    }
+    return finish_init(renderer);
+}
+
+/**
+ * @brief Rasterizes printable ASCII from `font` into one atlas texture.
+ * @return false if the atlas could not be built (callers may fall back to per-line rendering).
+ */
+bool text_init(SDL_Renderer* renderer, TTF_Font* font) {
+    SDL_Surface* glyph_surfaces[ATLAS_GLYPHS] = { 0 };
+    SDL_Color white = {255, 255, 255, 255};
+    int cell_w = 1, cell_h = 1;
+
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+        Uint16 ch = (Uint16)(ATLAS_FIRST_CHAR + i);
+        int advance = 0;
+        if (TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance) != 0) advance = 0;
+        g_glyphs[i].advance = advance;
+        if (ch == ' ') continue; // Nothing to draw, only advance
+        glyph_surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        if (glyph_surfaces[i]) {
+            if (glyph_surfaces[i]->w > cell_w) cell_w = glyph_surfaces[i]->w;
+            if (glyph_surfaces[i]->h > cell_h) cell_h = glyph_surfaces[i]->h;
+        }
+    }
+
+    int rows = (ATLAS_GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    g_atlas_w = ATLAS_COLUMNS * cell_w;
+    g_atlas_h = rows * cell_h;
+
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, g_atlas_w, g_atlas_h, 32, SDL_PIXELFORMAT_RGBA32);
+    bool ok = atlas != NULL;
+    if (ok) SDL_FillRect(atlas, NULL, 0);
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+        SDL_Surface* s = glyph_surfaces[i];
+        SDL_Rect dst = { (i % ATLAS_COLUMNS) * cell_w, (i / ATLAS_COLUMNS) * cell_h, s ? s->w : 0, s ? s->h : 0 };
+        g_glyphs[i].src = dst;
+        if (s && ok) {
+            SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE); // Copy alpha as-is
+            SDL_BlitSurface(s, NULL, atlas, &dst);
+        }
+        if (s) SDL_FreeSurface(s);
+    }
+
+    if (ok) g_atlas = SDL_CreateTextureFromSurface(renderer, atlas);
+    if (atlas) SDL_FreeSurface(atlas);
+    return finish_init(renderer);
+}
+
+void text_shutdown() {
+    if (g_atlas) {
+        SDL_DestroyTexture(g_atlas);
+        g_atlas = NULL;
+    }
+    g_text_renderer = NULL;
+    g_batch_glyphs = 0;
+}
+
+/**
+ * @brief Submits all queued glyphs. Call before SDL_RenderPresent (or before drawing anything that must go on top).
+ */
+void text_flush() {
+    if (g_batch_glyphs == 0 || !g_text_renderer) return;
+    SDL_RenderGeometry(g_text_renderer, g_atlas, g_vertices, g_batch_glyphs * 4, g_indices, g_batch_glyphs * 6);
+    g_batch_glyphs = 0;
+}
+
+/**
+ * @brief Writes the quads for `text` with its top-left corner at (x, y), glyphs scaled by `scale`.
+ * For callers that keep their own vertex buffer and draw it with text_atlas().
+ * @return Glyphs written, at most `max_glyphs`; four vertices each, in text_draw()'s index pattern.
+ */
+int text_layout(const char* text, float x, float y, float scale, SDL_Color color, SDL_Vertex* out, int max_glyphs) {
+    if (!g_atlas || !text) return 0;
+    int n = 0;
+    float pen = x;
+    for (const unsigned char* p = (const unsigned char*)text; *p && n < max_glyphs; p++) {
+        unsigned ch = *p;
+        if (ch < ATLAS_FIRST_CHAR || ch > ATLAS_LAST_CHAR) ch = '?';
+        const struct Glyph* gl = &g_glyphs[ch - ATLAS_FIRST_CHAR];
+        if (gl->src.w > 0) {
+            SDL_Vertex* v = &out[n++ * 4];
+            float x0 = pen, y0 = y, x1 = pen + gl->src.w * scale, y1 = y + gl->src.h * scale;
+            float u0 = (float)gl->src.x / g_atlas_w, v0 = (float)gl->src.y / g_atlas_h;
+            float u1 = (float)(gl->src.x + gl->src.w) / g_atlas_w, v1 = (float)(gl->src.y + gl->src.h) / g_atlas_h;
+            v[0] = (SDL_Vertex){ { x0, y0 }, color, { u0, v0 } };
+            v[1] = (SDL_Vertex){ { x1, y0 }, color, { u1, v0 } };
+            v[2] = (SDL_Vertex){ { x0, y1 }, color, { u0, v1 } };
+            v[3] = (SDL_Vertex){ { x1, y1 }, color, { u1, v1 } };
+        }
+        pen += gl->advance * scale;
+    }
+    return n;
+}
+
+/**
+ * @brief The atlas texture, or NULL when text_init() has not succeeded.
+ */
+SDL_Texture* text_atlas() {
+    return g_atlas;
+}
+
+/**
+ * @brief Queues a line of text with its top-left corner at (x, y).
+ */
+void text_draw(const char* text, int x, int y, SDL_Color color) {
+    if (!g_atlas || !text) return;
+    if (g_batch_glyphs + (int)strlen(text) > BATCH_MAX_GLYPHS) text_flush();
+    g_batch_glyphs += text_layout(text, (float)x, (float)y, 1.0f, color, &g_vertices[g_batch_glyphs * 4],
+                                  BATCH_MAX_GLYPHS - g_batch_glyphs);
+}
@@ -0,0 +1,27 @@
+/**
+ * @file text.h
+ * @brief Batched text rendering from a glyph atlas built once at startup.
+ */
+
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Atlas layout, shared with tools/mkatlas.c
+#define ATLAS_FIRST_CHAR 32
+#define ATLAS_LAST_CHAR 126
+#define ATLAS_GLYPHS (ATLAS_LAST_CHAR - ATLAS_FIRST_CHAR + 1)
+#define ATLAS_COLUMNS 16
+
+bool text_init_prebuilt(SDL_Renderer* renderer, int pt_size);
+bool text_init(SDL_Renderer* renderer, TTF_Font* font);
+void text_shutdown();
+void text_draw(const char* text, int x, int y, SDL_Color color);
+int text_layout(const char* text, float x, float y, float scale, SDL_Color color, SDL_Vertex* out, int max_glyphs);
+SDL_Texture* text_atlas();
+void text_flush();
+
+#endif // TEXT_H
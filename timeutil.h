@@ -0,0 +1,20 @@
+/**
+ * @file timeutil.h
+ * @brief Monotonic clock helper shared by the worker and the display.
+ */
+
+#ifndef TIMEUTIL_H
+#define TIMEUTIL_H
+
+#include <time.h>
+
+/**
+ * @brief Seconds on the monotonic clock; only differences are meaningful.
+ */
+static inline double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+#endif // TIMEUTIL_H
@@ -0,0 +1,178 @@
+/**
+ * @file mkacdb.c
+ * @brief Build-time converter from a public aircraft CSV dump to the offline database format.
+ *
+ * Accepted inputs:
+ * - tar1090-db `aircraft.csv` (semicolon-separated, no header):
+ *   icao;registration;type;flags;description;year;owner/operator
+ * - OpenSky `aircraftDatabase.csv` (comma-separated, quoted, with a header row
+ *   naming `icao24`, `registration`, `typecode` and `operator`/`owner`).
+ *
+ * Usage: mkacdb <input.csv|-> <output.db>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acdb.h"
+
+#define MAX_LINE 4096
+#define MAX_FIELDS 32
+
+struct ColumnMap {
+    int icao, registration, type, operator, owner;
+};
+
+/**
+ * @brief Splits one CSV line in place. Handles double-quoted fields with "" escapes.
+ */
+static int split_fields(char* line, char delim, char** fields, int max_fields) {
+    int n = 0;
+    char* p = line;
+    while (n < max_fields) {
+        char* out = p;
+        fields[n++] = out;
+        if (*p == '"') {
+            p++;
+            while (*p) {
+                if (*p == '"' && p[1] == '"') { *out++ = '"'; p += 2; }
+                else if (*p == '"') { p++; break; }
+                else *out++ = *p++;
+            }
+            while (*p && *p != delim) p++;
+        } else {
+            while (*p && *p != delim && *p != '\n' && *p != '\r') *out++ = *p++;
+        }
+        bool more = (*p == delim);
+        *out = '\0';
+        if (!more) break;
+        p++;
+    }
+    return n;
+}
+
+static bool parse_icao(const char* s, uint32_t* icao) {
+    char* end;
+    unsigned long v = strtoul(s, &end, 16);
+    if (end == s || *end != '\0' || v > 0xFFFFFF) return false;
+    *icao = (uint32_t)v;
+    return true;
+}
+
+static void store(char* dst, size_t size, const char* src) {
+    while (*src == ' ') src++;
+    strncpy(dst, src, size); // NUL-padded; may fill the field completely
+}
+
+static const char* field(char** fields, int n, int index) {
+    return (index >= 0 && index < n) ? fields[index] : "";
+}
+
+// A record with its position in the input, so duplicates resolve the same way on every run
+struct Row {
+    struct AcdbRecord record;
+    size_t order;
+};
+
+static int compare_icao(const void* a, const void* b) {
+    const struct Row *ra = a, *rb = b;
+    if (ra->record.icao != rb->record.icao) return (ra->record.icao > rb->record.icao) - (ra->record.icao < rb->record.icao);
+    return (ra->order > rb->order) - (ra->order < rb->order);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.csv|-> <output.db>\n", argv[0]);
+        return 1;
+    }
+    FILE* in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    char line[MAX_LINE];
+    char* fields[MAX_FIELDS];
+    struct ColumnMap cols = { .icao = 0, .registration = 1, .type = 2, .operator = 6, .owner = -1 };
+    char delim = ';';
+    bool first = true;
+
+    size_t count = 0, capacity = 1 << 16;
+    struct Row* records = malloc(capacity * sizeof(*records));
+    if (!records) return 1;
+
+    while (fgets(line, sizeof(line), in)) {
+        if (first) {
+            first = false;
+            delim = (strchr(line, ';') || !strchr(line, ',')) ? ';' : ',';
+            if (strstr(line, "icao24")) {
+                // OpenSky-style header row: map columns by name
+                cols = (struct ColumnMap){ -1, -1, -1, -1, -1 };
+                int n = split_fields(line, delim, fields, MAX_FIELDS);
+                for (int i = 0; i < n; i++) {
+                    if (strcmp(fields[i], "icao24") == 0) cols.icao = i;
+                    else if (strcmp(fields[i], "registration") == 0) cols.registration = i;
+                    else if (strcmp(fields[i], "typecode") == 0) cols.type = i;
+                    else if (strcmp(fields[i], "operator") == 0) cols.operator = i;
+                    else if (strcmp(fields[i], "owner") == 0) cols.owner = i;
+                }
+                if (cols.icao < 0) {
+                    fprintf(stderr, "ERROR: header has no icao24 column\n");
+                    return 1;
+                }
+                continue;
+            }
+        }
+
+        int n = split_fields(line, delim, fields, MAX_FIELDS);
+        uint32_t icao;
+        if (!parse_icao(field(fields, n, cols.icao), &icao)) continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            struct Row* grown = realloc(records, capacity * sizeof(*records));
+            if (!grown) {
+                fprintf(stderr, "ERROR: out of memory\n");
+                return 1;
+            }
+            records = grown;
+        }
+        records[count].order = count;
+        struct AcdbRecord* r = &records[count++].record;
+        memset(r, 0, sizeof(*r));
+        r->icao = icao;
+        store(r->registration, sizeof(r->registration), field(fields, n, cols.registration));
+        store(r->aircraft_type, sizeof(r->aircraft_type), field(fields, n, cols.type));
+        const char* op = field(fields, n, cols.operator);
+        if (!op[0]) op = field(fields, n, cols.owner);
+        store(r->operator, sizeof(r->operator), op);
+    }
+    if (in != stdin) fclose(in);
+
+    qsort(records, count, sizeof(*records), compare_icao);
+    // Drop duplicate addresses, keeping the row that came last in the input
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (unique > 0 && records[unique - 1].record.icao == records[i].record.icao) records[unique - 1] = records[i];
+        else records[unique++] = records[i];
+    }
+
+    FILE* out = fopen(argv[2], "wb");
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+    struct AcdbHeader header = { .version = ACDB_VERSION, .count = (uint32_t)unique, .record_size = sizeof(struct AcdbRecord) };
+    memcpy(header.magic, ACDB_MAGIC, 4);
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (size_t i = 0; ok && i < unique; i++) ok = fwrite(&records[i].record, sizeof(records[i].record), 1, out) == 1;
+    if (fclose(out) != 0 || !ok) {
+        fprintf(stderr, "ERROR: failed to write %s\n", argv[2]);
+        remove(argv[2]);
+        return 1;
+    }
+    printf("Wrote %zu aircraft to %s\n", unique, argv[2]);
+    free(records);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file mkatlas.c
+ * @brief Build-time rasterizer for the glyph atlas, so startup does not need FreeType.
+ *
+ * Renders printable ASCII from the TTF at one point size, in exactly the layout
+ * text_init() builds at runtime, and writes it as a C header: the glyph rects
+ * and advances, and one coverage byte per atlas pixel. text_init_prebuilt()
+ * turns that into the atlas texture without opening the font.
+ *
+ * Usage: mkatlas <font.ttf> <point size> > font_atlas.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "text.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3 || atoi(argv[2]) <= 0) {
+        fprintf(stderr, "usage: %s <font.ttf> <point size>\n", argv[0]);
+        return 2;
+    }
+    int pt_size = atoi(argv[2]);
+    if (TTF_Init() != 0) {
+        fprintf(stderr, "TTF_Init failed: %s\n", TTF_GetError());
+        return 1;
+    }
+    TTF_Font* font = TTF_OpenFont(argv[1], pt_size);
+    if (!font) {
+        fprintf(stderr, "%s: %s\n", argv[1], TTF_GetError());
+        return 1;
+    }
+
+    SDL_Surface* glyph_surfaces[ATLAS_GLYPHS] = { 0 };
+    int advances[ATLAS_GLYPHS] = { 0 };
+    SDL_Color white = {255, 255, 255, 255};
+    int cell_w = 1, cell_h = 1;
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+        Uint16 ch = (Uint16)(ATLAS_FIRST_CHAR + i);
+        if (TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advances[i]) != 0) advances[i] = 0;
+        if (ch == ' ') continue;
+        glyph_surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        if (!glyph_surfaces[i]) continue;
+        // Converted so coverage can be read straight from the pixels
+        SDL_Surface* argb = SDL_ConvertSurfaceFormat(glyph_surfaces[i], SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(glyph_surfaces[i]);
+        glyph_surfaces[i] = argb;
+        if (argb && argb->w > cell_w) cell_w = argb->w;
+        if (argb && argb->h > cell_h) cell_h = argb->h;
+    }
+
+    int rows = (ATLAS_GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    int atlas_w = ATLAS_COLUMNS * cell_w, atlas_h = rows * cell_h;
+    unsigned char* alpha = calloc((size_t)atlas_w * atlas_h, 1);
+    if (!alpha) return 1;
+
+    printf("// Generated by tools/mkatlas from %s at %d pt; do not edit.\n", argv[1], pt_size);
+    printf("#define FONT_ATLAS_PT %d\n#define FONT_ATLAS_W %d\n#define FONT_ATLAS_H %d\n\n", pt_size, atlas_w, atlas_h);
+    printf("// x, y, w, h, advance from ATLAS_FIRST_CHAR on\n");
+    printf("static const short font_atlas_glyphs[ATLAS_GLYPHS][5] = {\n");
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+        SDL_Surface* s = glyph_surfaces[i];
+        int x = (i % ATLAS_COLUMNS) * cell_w, y = (i / ATLAS_COLUMNS) * cell_h;
+        int w = s ? s->w : 0, h = s ? s->h : 0;
+        printf("    { %d, %d, %d, %d, %d },\n", x, y, w, h, advances[i]);
+        if (!s) continue;
+        SDL_LockSurface(s);
+        for (int row = 0; row < h; row++) {
+            const Uint32* px = (const Uint32*)((const Uint8*)s->pixels + row * s->pitch);
+            for (int col = 0; col < w; col++) alpha[(size_t)(y + row) * atlas_w + x + col] = (unsigned char)(px[col] >> 24);
+        }
+        SDL_UnlockSurface(s);
+        SDL_FreeSurface(s);
+    }
+    printf("};\n\n// Coverage per atlas pixel, row-major\n");
+    printf("static const unsigned char font_atlas_alpha[FONT_ATLAS_W * FONT_ATLAS_H] = {");
+    for (size_t i = 0; i < (size_t)atlas_w * atlas_h; i++) printf("%s%u,", i % 24 ? " " : "\n    ", alpha[i]);
+    printf("\n};\n");
+
+    free(alpha);
+    TTF_CloseFont(font);
+    TTF_Quit();
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file mktone.c
+ * @brief Build-time generator for the alert tone, so startup does not synthesize it sample by sample.
+ *
+ * Writes a sine beep as a mono 16-bit 44.1 kHz WAV file embedded in a C header
+ * (`alert_tone_wav` and `alert_tone_wav_len`, as xxd -i would name them), ready
+ * for Mix_LoadWAV_RW(), which converts it to whatever format the device opened.
+ *
+ * Usage: mktone <frequency Hz> <duration ms> > alert_tone.h
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLE_RATE 44100
+#define VOLUME 4000.0
+
+static unsigned char g_wav[44 + 2 * SAMPLE_RATE * 10];
+static size_t g_len = 0;
+
+static void put_le(uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) g_wav[g_len++] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_tag(const char* tag) {
+    for (int i = 0; i < 4; i++) g_wav[g_len++] = (unsigned char)tag[i];
+}
+
+int main(int argc, char** argv) {
+    int freq = argc == 3 ? atoi(argv[1]) : 0, duration_ms = argc == 3 ? atoi(argv[2]) : 0;
+    if (freq <= 0 || duration_ms <= 0 || duration_ms > 10000) {
+        fprintf(stderr, "usage: %s <frequency Hz> <duration ms (up to 10000)>\n", argv[0]);
+        return 2;
+    }
+    uint32_t samples = (uint32_t)((long)duration_ms * SAMPLE_RATE / 1000);
+    uint32_t data_bytes = samples * 2;
+
+    put_tag("RIFF"); put_le(36 + data_bytes, 4); put_tag("WAVE");
+    put_tag("fmt "); put_le(16, 4); put_le(1, 2); put_le(1, 2); // PCM, mono
+    put_le(SAMPLE_RATE, 4); put_le(SAMPLE_RATE * 2, 4); put_le(2, 2); put_le(16, 2);
+    put_tag("data"); put_le(data_bytes, 4);
+    for (uint32_t i = 0; i < samples; i++) {
+        int16_t s = (int16_t)(VOLUME * sin(2.0 * M_PI * freq * i / SAMPLE_RATE));
+        put_le((uint16_t)s, 2);
+    }
+
+    printf("// Generated by tools/mktone: %d Hz for %d ms; do not edit.\n", freq, duration_ms);
+    printf("static const unsigned char alert_tone_wav[] = {");
+    for (size_t i = 0; i < g_len; i++) printf("%s0x%02x,", i % 16 ? " " : "\n    ", g_wav[i]);
+    printf("\n};\nstatic const unsigned int alert_tone_wav_len = %zu;\n", g_len);
+    return 0;
+}
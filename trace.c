@@ -0,0 +1,206 @@
+/**
+ * @file trace.c
+ * @brief Per-thread ring buffers of trace events, drained to Chrome Trace Event JSON by a flusher thread.
+ *
+ * A thread claims a ring the first time it records (or names itself with
+ * trace_thread_name()). Each ring has a single producer, its thread, and a single
+ * consumer, the flusher, so pushing is a slot write and a release store with no
+ * lock. The flusher wakes every TRACE_FLUSH_MS, formats whatever is queued and
+ * writes it to the file, keeping formatting and disk I/O off the traced threads.
+ *
+ * Spans on one thread that nest are written as complete ("X") events. Transfers
+ * overlap on the worker thread, so they are nestable async ("b"/"e") events
+ * keyed by an id instead, with their curl phases nested inside.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+struct TraceEvent {
+    const char* name;
+    const char* cat;
+    const char* arg_name; // NULL: no args
+    double start_s, dur_s;
+    long long arg;
+    uint32_t id;          // 0: complete event on this thread; otherwise an async span
+};
+
+struct TraceRing {
+    struct TraceEvent events[TRACE_RING_EVENTS];
+    _Atomic uint32_t head; // Next slot the owning thread writes
+    _Atomic uint32_t tail; // Next slot the flusher reads
+    _Atomic(const char*) name;
+    atomic_bool active;
+    _Atomic unsigned long dropped;
+};
+
+atomic_bool g_trace_on = false;
+
+static struct TraceRing g_rings[TRACE_MAX_THREADS];
+static pthread_mutex_t g_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_ring_count = 0;
+static _Thread_local struct TraceRing* t_ring = NULL;
+static _Thread_local bool t_no_ring = false; // Every ring was taken; this thread records nothing
+
+static FILE* g_trace_file = NULL;
+static double g_trace_epoch = 0.0;
+static bool g_first_event = true;
+static pthread_t g_flush_thread;
+static atomic_bool g_flush_stop = false;
+
+
+static struct TraceRing* claim_ring(const char* name) {
+    if (t_ring || t_no_ring) return t_ring;
+    pthread_mutex_lock(&g_ring_lock);
+    if (g_ring_count < TRACE_MAX_THREADS) {
+        t_ring = &g_rings[g_ring_count++];
+        atomic_store(&t_ring->name, name);
+        atomic_store_explicit(&t_ring->active, true, memory_order_release);
+    } else {
+        t_no_ring = true;
+    }
+    pthread_mutex_unlock(&g_ring_lock);
+    return t_ring;
+}
+
+/**
+ * @brief Names the calling thread's track in the trace; call once at thread start. `name` must outlive the trace.
+ */
+void trace_thread_name(const char* name) {
+    if (!atomic_load_explicit(&g_trace_on, memory_order_relaxed)) return;
+    if (t_ring) atomic_store(&t_ring->name, name);
+    else claim_ring(name);
+}
+
+static void push(const struct TraceEvent* ev) {
+    if (!atomic_load_explicit(&g_trace_on, memory_order_relaxed)) return;
+    struct TraceRing* ring = claim_ring("thread");
+    if (!ring) return;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= TRACE_RING_EVENTS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    ring->events[head & (TRACE_RING_EVENTS - 1)] = *ev;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief A span on the calling thread; spans recorded on one thread must nest.
+ */
+void trace_span(const char* name, const char* cat, double start_s, double dur_s) {
+    struct TraceEvent ev = { name, cat, NULL, start_s, dur_s, 0, 0 };
+    push(&ev);
+}
+
+/**
+ * @brief A span that may overlap others on the same thread; spans sharing `id` (non-zero) nest in one track.
+ */
+void trace_async(const char* name, const char* cat, uint32_t id, double start_s, double dur_s, const char* arg_name,
+                 long long arg) {
+    struct TraceEvent ev = { name, cat, arg_name, start_s, dur_s, arg, id ? id : 1 };
+    push(&ev);
+}
+
+
+// --- Flusher ---
+
+static void write_separator(void) {
+    fputs(g_first_event ? "\n" : ",\n", g_trace_file);
+    g_first_event = false;
+}
+
+static void write_event(const struct TraceEvent* ev, int tid, int pid) {
+    double ts = (ev->start_s - g_trace_epoch) * 1e6;
+    char args[96] = "";
+    if (ev->arg_name) snprintf(args, sizeof(args), ",\"args\":{\"%s\":%lld}", ev->arg_name, ev->arg);
+    write_separator();
+    if (ev->id == 0) {
+        fprintf(g_trace_file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d%s}",
+                ev->name, ev->cat, ts, ev->dur_s * 1e6, pid, tid, args);
+        return;
+    }
+    fprintf(g_trace_file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"b\",\"id\":\"0x%x\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d%s},\n"
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"e\",\"id\":\"0x%x\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+            ev->name, ev->cat, ev->id, ts, pid, tid, args, ev->name, ev->cat, ev->id, ts + ev->dur_s * 1e6, pid, tid);
+}
+
+static void drain_rings(void) {
+    int pid = (int)getpid();
+    for (int r = 0; r < TRACE_MAX_THREADS; r++) {
+        struct TraceRing* ring = &g_rings[r];
+        if (!atomic_load_explicit(&ring->active, memory_order_acquire)) continue;
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        for (; tail != head; tail++) write_event(&ring->events[tail & (TRACE_RING_EVENTS - 1)], r + 1, pid);
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    fflush(g_trace_file);
+}
+
+static void* flush_thread_main(void* arg) {
+    (void)arg;
+    struct timespec interval = { 0, TRACE_FLUSH_MS * 1000000L };
+    while (!atomic_load(&g_flush_stop)) {
+        nanosleep(&interval, NULL);
+        drain_rings();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts tracing to `path`, replacing any file there.
+ */
+bool trace_open(const char* path) {
+    if (g_trace_file) return true;
+    g_trace_file = fopen(path, "w");
+    if (!g_trace_file) {
+        perror(path);
+        return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", g_trace_file);
+    g_first_event = true;
+    g_trace_epoch = monotonic_seconds();
+    atomic_store(&g_flush_stop, false);
+    if (pthread_create(&g_flush_thread, NULL, flush_thread_main, NULL) != 0) {
+        fclose(g_trace_file);
+        g_trace_file = NULL;
+        return false;
+    }
+    atomic_store(&g_trace_on, true);
+    printf("INFO: Tracing to %s\n", path);
+    return true;
+}
+
+/**
+ * @brief Stops tracing, writes what is still queued plus the thread names, and closes the file.
+ * Call once the traced threads have stopped recording.
+ */
+void trace_close() {
+    if (!g_trace_file) return;
+    atomic_store(&g_trace_on, false);
+    atomic_store(&g_flush_stop, true);
+    pthread_join(g_flush_thread, NULL);
+    drain_rings();
+
+    int pid = (int)getpid();
+    unsigned long dropped = 0;
+    for (int r = 0; r < TRACE_MAX_THREADS; r++) {
+        struct TraceRing* ring = &g_rings[r];
+        if (!atomic_load(&ring->active)) continue;
+        write_separator();
+        fprintf(g_trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", pid,
+                r + 1, atomic_load(&ring->name));
+        dropped += atomic_load(&ring->dropped);
+    }
+    fputs("\n]}\n", g_trace_file);
+    fclose(g_trace_file);
+    g_trace_file = NULL;
+    if (dropped > 0) printf("WARNING: %lu trace events dropped; the flusher fell behind\n", dropped);
+}
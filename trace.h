@@ -0,0 +1,46 @@
+/**
+ * @file trace.h
+ * @brief Opt-in Chrome Trace Event (JSON) export of fetch cycles, transfers and frames.
+ *
+ * Each thread appends to its own ring buffer; a background thread drains the
+ * rings to the file, so recording is a clock read and a few stores. The output
+ * opens in chrome://tracing and https://ui.perfetto.dev.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "timeutil.h"
+
+#define TRACE_MAX_THREADS 8
+#define TRACE_RING_EVENTS 4096 // Per thread, power of two; events past a full ring are dropped and counted
+#define TRACE_FLUSH_MS 100
+
+extern atomic_bool g_trace_on;
+
+bool trace_open(const char* path);
+void trace_close();
+void trace_thread_name(const char* name);
+void trace_span(const char* name, const char* cat, double start_s, double dur_s);
+void trace_async(const char* name, const char* cat, uint32_t id, double start_s, double dur_s, const char* arg_name,
+                 long long arg);
+
+/**
+ * @brief Start time for trace_end(), or 0 when tracing is off (no clock read).
+ */
+static inline double trace_begin(void) {
+    return atomic_load_explicit(&g_trace_on, memory_order_relaxed) ? monotonic_seconds() : 0.0;
+}
+
+/**
+ * @brief Records a span from `start` to now on the calling thread. `name` and `cat` must be string literals.
+ */
+static inline void trace_end(const char* name, const char* cat, double start) {
+    if (start > 0.0) trace_span(name, cat, start, monotonic_seconds() - start);
+}
+
+#endif // TRACE_H
@@ -0,0 +1,379 @@
+/**
+ * @file warmstart.c
+ * @brief Restores the aircraft table from the state saved at shutdown, or rebuilds it from dump1090's history.
+ *
+ * The state file is read first: it needs no network, so the first snapshot is
+ * published before any transfer has started. Every aircraft keeps its fields,
+ * trail and registration details, and its ages are advanced by the time the
+ * app was down, so dead reckoning carries on from the fixes and anything older
+ * than track_timeout is not restored.
+ *
+ * Without a usable state file, the history is only read once the first live
+ * aircraft.json has been published, one round trip per refresh cycle so that
+ * neither the polls nor the registration lookups wait for all of it. Each
+ * receiver's receiver.json says how many history_N.json files dump1090 keeps.
+ * They are fetched WARMSTART_PARALLEL at a time and, once the last is in, the
+ * ones recent enough to matter are applied newest first: aircraft the live data
+ * already has only gain older trail points, and the rest are added.
+ *
+ * On-disk format (native endianness, written via a temporary file and rename):
+ *   "CPWS" u32 version i64 saved_at (Unix seconds) u32 count, then per aircraft:
+ *   u32 icao, u8 flags (1: position, 2: enriched), f64 seen_age_s, f64 position_age_s,
+ *   f64 lat, lon, ground_speed_kts, track_deg, i32 altitude_ft, vert_rate_fpm,
+ *   six length-prefixed strings (u8 length + bytes): flight, hex, squawk,
+ *   registration, type, operator, and u8 trail length followed by that many
+ *   f32 lat, f32 lon, f64 age_s, oldest first. Ages are seconds before saved_at.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cjson/cJSON.h>
+
+#include "config.h"
+#include "http.h"
+#include "scan.h"
+#include "timeutil.h"
+#include "warmstart.h"
+
+#define STATE_FILE_MAGIC "CPWS"
+#define STATE_FILE_VERSION 1u
+#define STATE_POSITION 1u
+#define STATE_ENRICHED 2u
+#define STATE_SOURCE 0xff // Matches no receiver, so the first live document updates every entry
+#define HISTORY_MAX_FILES 256 // Per receiver; dump1090-fa keeps 120 by default
+#define HISTORY_MAX_DOCS 64    // Recent enough to apply, over all receivers
+
+#define WRITE(f, v) (fwrite(&(v), sizeof(v), 1, (f)) == 1)
+#define READ(f, v) (fread(&(v), sizeof(v), 1, (f)) == 1)
+
+// One history_N.json recent enough to apply
+struct HistoryDoc {
+    double now; // The document's own Unix timestamp
+    uint8_t source;
+    struct ParsedAircraft* parsed;
+    size_t count;
+};
+
+static int64_t unix_seconds(void) {
+    return (int64_t)time(NULL);
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool write_string(FILE* f, const char* s) {
+    size_t len = strlen(s);
+    uint8_t n = (uint8_t)(len > 255 ? 255 : len);
+    return fwrite(&n, 1, 1, f) == 1 && fwrite(s, 1, n, f) == n;
+}
+
+static bool read_string(FILE* f, char* dst, size_t dst_size) {
+    uint8_t n;
+    char tmp[256];
+    if (fread(&n, 1, 1, f) != 1 || fread(tmp, 1, n, f) != n) return false;
+    size_t keep = n < dst_size - 1 ? n : dst_size - 1;
+    memcpy(dst, tmp, keep);
+    dst[keep] = '\0';
+    return true;
+}
+
+
+// --- State file ---
+
+static bool write_aircraft(FILE* f, const struct TrackedAircraft* t, double now) {
+    const struct Aircraft* ac = &t->ac;
+    uint8_t flags = (t->has_position ? STATE_POSITION : 0) | (t->enriched ? STATE_ENRICHED : 0);
+    double seen_age = now - t->last_seen, position_age = now - t->last_position;
+    bool ok = WRITE(f, t->icao) && WRITE(f, flags) && WRITE(f, seen_age) && WRITE(f, position_age) &&
+              WRITE(f, ac->lat) && WRITE(f, ac->lon) && WRITE(f, ac->ground_speed_kts) && WRITE(f, ac->track_deg) &&
+              WRITE(f, ac->altitude_ft) && WRITE(f, ac->vert_rate_fpm) &&
+              write_string(f, ac->flight) && write_string(f, ac->hex) && write_string(f, ac->squawk) &&
+              write_string(f, ac->registration) && write_string(f, ac->aircraft_type) && write_string(f, ac->operator);
+
+    struct TrailPoint trail[TRAIL_POINTS];
+    uint8_t n = (uint8_t)table_trail(t, trail);
+    ok = ok && WRITE(f, n);
+    for (uint8_t i = 0; ok && i < n; i++) {
+        double age = now - trail[i].time;
+        ok = WRITE(f, trail[i].lat) && WRITE(f, trail[i].lon) && WRITE(f, age);
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes every tracked aircraft to `path` (via a temporary file and rename).
+ */
+bool warmstart_save_state(const char* path) {
+    double now = monotonic_seconds();
+    int64_t saved_at = unix_seconds();
+    uint32_t n = (uint32_t)table_count(), version = STATE_FILE_VERSION;
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "WARNING: Could not write state %s\n", tmp_path);
+        return false;
+    }
+    bool ok = fwrite(STATE_FILE_MAGIC, 1, 4, f) == 4 && WRITE(f, version) && WRITE(f, saved_at) && WRITE(f, n);
+    size_t cursor = 0;
+    struct TrackedAircraft* t;
+    while (ok && table_next(&cursor, &t)) ok = write_aircraft(f, t, now);
+    if (fclose(f) != 0) ok = false;
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "WARNING: Failed to save state to %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one aircraft and, if it was heard within track_timeout, adds it to the table.
+ * @param down_s Seconds between the save and now, added to every age.
+ * @return false on a short or corrupt record.
+ */
+static bool read_aircraft(FILE* f, double now, double down_s, bool* table_full) {
+    uint32_t icao;
+    uint8_t flags, trail_len;
+    double seen_age, position_age;
+    struct Aircraft ac;
+    memset(&ac, 0, sizeof(ac));
+    bool ok = READ(f, icao) && READ(f, flags) && READ(f, seen_age) && READ(f, position_age) &&
+              READ(f, ac.lat) && READ(f, ac.lon) && READ(f, ac.ground_speed_kts) && READ(f, ac.track_deg) &&
+              READ(f, ac.altitude_ft) && READ(f, ac.vert_rate_fpm) &&
+              read_string(f, ac.flight, sizeof(ac.flight)) && read_string(f, ac.hex, sizeof(ac.hex)) &&
+              read_string(f, ac.squawk, sizeof(ac.squawk)) &&
+              read_string(f, ac.registration, sizeof(ac.registration)) &&
+              read_string(f, ac.aircraft_type, sizeof(ac.aircraft_type)) &&
+              read_string(f, ac.operator, sizeof(ac.operator)) && READ(f, trail_len) && trail_len <= TRAIL_POINTS;
+    struct TrailPoint trail[TRAIL_POINTS];
+    for (uint8_t i = 0; ok && i < trail_len; i++) {
+        double age;
+        ok = READ(f, trail[i].lat) && READ(f, trail[i].lon) && READ(f, age);
+        trail[i].time = now - down_s - age;
+    }
+    if (!ok) return false;
+
+    double heard = now - down_s - seen_age;
+    if (*table_full || now - heard > g_track_timeout_s) return true;
+    struct TrackedAircraft* t = table_upsert(icao, heard);
+    if (!t) {
+        *table_full = true;
+        return true;
+    }
+    double lat = ac.lat, lon = ac.lon;
+    t->ac = ac;
+    t->enriched = (flags & STATE_ENRICHED) != 0;
+    t->source = t->pos_source = STATE_SOURCE;
+    for (uint8_t i = 0; i < trail_len; i++) table_push_trail(t, trail[i].lat, trail[i].lon, trail[i].time);
+    if (flags & STATE_POSITION) {
+        table_set_position(t, lat, lon);
+        t->ac.distance_km = observer_distance_km(&g_observer, lat, lon);
+        t->ac.bearing_deg = observer_bearing(&g_observer, lat, lon);
+        t->ac.position_time = t->last_position = now - down_s - position_age;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds the aircraft saved in `path` to the table. A missing or stale file is not an error; a corrupt one is discarded.
+ * @return The number of aircraft restored.
+ */
+size_t warmstart_load_state(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    char magic[4];
+    uint32_t version = 0, n = 0;
+    int64_t saved_at = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, STATE_FILE_MAGIC, 4) == 0 && READ(f, version) &&
+              version == STATE_FILE_VERSION && READ(f, saved_at) && READ(f, n);
+    double down_s = (double)(unix_seconds() - saved_at);
+    if (ok && (down_s < 0.0 || down_s > g_track_timeout_s)) { // Nothing in it would survive
+        fclose(f);
+        return 0;
+    }
+
+    double now = monotonic_seconds();
+    bool table_full = false;
+    for (uint32_t k = 0; ok && k < n; k++) ok = read_aircraft(f, now, down_s, &table_full);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "WARNING: Ignoring corrupt state %s\n", path);
+        table_clear();
+        return 0;
+    }
+    if (table_count() > 0) printf("INFO: Restored %zu aircraft from %s (saved %.0f s ago)\n", table_count(), path, down_s);
+    return table_count();
+}
+
+
+// --- dump1090 history ---
+
+static int compare_doc_time(const void* a, const void* b) {
+    double x = ((const struct HistoryDoc*)a)->now, y = ((const struct HistoryDoc*)b)->now;
+    return (x < y) - (x > y); // Newest first
+}
+
+/**
+ * @brief Copies `url` up to and including its last '/', if it names an aircraft.json.
+ */
+static bool data_dir(const char* url, char* out, size_t len) {
+    const char* slash = strrchr(url, '/');
+    if (!slash || strcmp(slash + 1, "aircraft.json") != 0 || (size_t)(slash - url + 1) >= len) return false;
+    memcpy(out, url, (size_t)(slash - url + 1));
+    out[slash - url + 1] = '\0';
+    return true;
+}
+
+/**
+ * @brief The `history` count from a receiver.json body, or 0.
+ */
+static int history_count(const struct HttpEndpoint* ep) {
+    if (!ep->last.ok || ep->body.size == 0) return 0;
+    cJSON* root = cJSON_Parse(ep->body.memory);
+    const cJSON* history = cJSON_GetObjectItemCaseSensitive(root, "history");
+    int count = cJSON_IsNumber(history) ? history->valueint : 0;
+    cJSON_Delete(root);
+    return count > 0 ? count : 0;
+}
+
+// Backfill state, kept across warmstart_backfill_step() calls on the fetch worker
+static struct HttpEndpoint g_hist_endpoints[WARMSTART_PARALLEL];
+static struct HttpEndpoint* g_hist_eps[WARMSTART_PARALLEL];
+static char g_hist_urls[WARMSTART_PARALLEL][320];
+static const char* g_hist_url_ptrs[WARMSTART_PARALLEL];
+static size_t g_hist_open = 0; // Endpoints initialized
+static bool g_hist_started = false;
+static char g_hist_dirs[MAX_SOURCES][256];
+static struct { uint8_t source; uint16_t file; } g_hist_jobs[MAX_SOURCES * HISTORY_MAX_FILES];
+static size_t g_hist_job_count = 0, g_hist_next_job = 0;
+static struct HistoryDoc g_hist_docs[HISTORY_MAX_DOCS]; // Recent enough to apply, in fetch order
+static size_t g_hist_doc_count = 0;
+static struct ParsedAircraft* g_hist_parsed = NULL;    // Parse buffer, copied into g_hist_docs
+
+/**
+ * @brief Opens the transfers and asks every receiver at once for its receiver.json.
+ * @return false if there is no history to fetch.
+ */
+static bool history_begin() {
+    for (; g_hist_open < WARMSTART_PARALLEL; g_hist_open++) {
+        if (!http_endpoint_init(&g_hist_endpoints[g_hist_open], "history", SOURCE_TIMEOUT_SECONDS)) break;
+        g_hist_eps[g_hist_open] = &g_hist_endpoints[g_hist_open];
+        g_hist_url_ptrs[g_hist_open] = g_hist_urls[g_hist_open];
+    }
+    g_hist_parsed = malloc(MAX_PARSED_AIRCRAFT * sizeof(*g_hist_parsed));
+    if (g_hist_open == 0 || !g_hist_parsed) return false;
+
+    size_t asked = 0;
+    uint8_t asked_source[MAX_SOURCES];
+    for (size_t s = 0; s < g_source_count && asked < g_hist_open; s++) {
+        if (!data_dir(g_sources[s], g_hist_dirs[s], sizeof(g_hist_dirs[s]))) continue;
+        snprintf(g_hist_urls[asked], sizeof(g_hist_urls[asked]), "%sreceiver.json", g_hist_dirs[s]);
+        asked_source[asked++] = (uint8_t)s;
+    }
+    http_get_all(g_hist_eps, g_hist_url_ptrs, asked);
+    for (size_t i = 0; i < asked; i++) {
+        int count = history_count(g_hist_eps[i]);
+        for (int file = 0; file < count && file < HISTORY_MAX_FILES; file++) {
+            g_hist_jobs[g_hist_job_count].source = asked_source[i];
+            g_hist_jobs[g_hist_job_count++].file = (uint16_t)file;
+        }
+    }
+    return g_hist_job_count > 0;
+}
+
+/**
+ * @brief Fetches the next WARMSTART_PARALLEL history files and keeps those recent enough to survive
+ * eviction or to be part of a trail.
+ */
+static void history_fetch_batch() {
+    double keep_s = g_track_timeout_s > TRAIL_POINTS * TRAIL_INTERVAL_S ? g_track_timeout_s : TRAIL_POINTS * TRAIL_INTERVAL_S;
+    size_t batch = 0;
+    uint8_t batch_source[WARMSTART_PARALLEL];
+    for (; batch < g_hist_open && g_hist_next_job < g_hist_job_count; batch++, g_hist_next_job++) {
+        snprintf(g_hist_urls[batch], sizeof(g_hist_urls[batch]), "%shistory_%u.json",
+                 g_hist_dirs[g_hist_jobs[g_hist_next_job].source], g_hist_jobs[g_hist_next_job].file);
+        batch_source[batch] = g_hist_jobs[g_hist_next_job].source;
+    }
+    http_get_all(g_hist_eps, g_hist_url_ptrs, batch);
+    double wall_now = wall_seconds();
+    for (size_t i = 0; i < batch; i++) {
+        const struct HttpEndpoint* ep = g_hist_eps[i];
+        double doc_now = 0.0;
+        if (!ep->last.ok || ep->body.size == 0) continue;
+        long count = aircraft_json_extract(ep->body.memory, ep->body.size, g_hist_parsed, MAX_PARSED_AIRCRAFT, &doc_now);
+        double age = wall_now - doc_now;
+        if (count <= 0 || doc_now <= 0.0 || age > keep_s || g_hist_doc_count == HISTORY_MAX_DOCS) continue;
+        struct HistoryDoc* d = &g_hist_docs[g_hist_doc_count];
+        if (!(d->parsed = malloc((size_t)count * sizeof(*g_hist_parsed)))) continue;
+        memcpy(d->parsed, g_hist_parsed, (size_t)count * sizeof(*g_hist_parsed));
+        d->count = (size_t)count;
+        d->now = doc_now;
+        d->source = batch_source[i];
+        g_hist_doc_count++;
+    }
+}
+
+/**
+ * @brief Closes the transfers and, if `apply`, backfills the table from the kept documents, newest first.
+ */
+static void history_finish(bool apply) {
+    for (size_t i = 0; i < g_hist_open; i++) http_endpoint_cleanup(&g_hist_endpoints[i]);
+    g_hist_open = 0;
+    free(g_hist_parsed);
+    g_hist_parsed = NULL;
+    g_hist_job_count = g_hist_next_job = 0;
+
+    if (apply) qsort(g_hist_docs, g_hist_doc_count, sizeof(g_hist_docs[0]), compare_doc_time);
+    double now = monotonic_seconds(), wall_now = wall_seconds();
+    struct ScanStats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (size_t i = 0; i < g_hist_doc_count; i++) {
+        double age = wall_now - g_hist_docs[i].now;
+        if (apply) {
+            scan_backfill_parsed(g_hist_docs[i].parsed, g_hist_docs[i].count, now - (age > 0.0 ? age : 0.0),
+                                 g_hist_docs[i].source, &stats);
+        }
+        free(g_hist_docs[i].parsed);
+    }
+    if (apply) scan_evict(now, &stats);
+    if (apply && g_hist_doc_count > 0) {
+        printf("INFO: Backfilled %zu aircraft from %zu history files\n", table_count(), g_hist_doc_count);
+    }
+    g_hist_doc_count = 0;
+}
+
+/**
+ * @brief Does one round trip of the history backfill: every receiver's receiver.json on the first call,
+ * then WARMSTART_PARALLEL history_N.json files per call. The table is backfilled, newest first, once
+ * the last batch is in. History is looked for next to each configured aircraft.json URL.
+ * Call once per live cycle, after the first one has been published.
+ * @return true while there is more to fetch.
+ */
+bool warmstart_backfill_step() {
+    if (!g_hist_started) {
+        g_hist_started = true;
+        if (history_begin()) return true;
+        history_finish(false);
+        return false;
+    }
+    if (g_hist_open == 0) return false;
+    history_fetch_batch();
+    if (g_hist_next_job < g_hist_job_count) return true;
+    history_finish(true);
+    return false;
+}
+
+/**
+ * @brief Abandons a backfill still in progress (at shutdown), releasing its transfers and documents.
+ */
+void warmstart_backfill_cancel() {
+    history_finish(false);
+}
@@ -0,0 +1,21 @@
+/**
+ * @file warmstart.h
+ * @brief Fills the aircraft table at startup, so the first frame already has aircraft to show.
+ *
+ * Runs on the fetch worker: the state file before its first cycle, the history a batch per cycle after it.
+ */
+
+#ifndef WARMSTART_H
+#define WARMSTART_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define WARMSTART_PARALLEL 16 // history_N.json transfers in flight at once
+
+bool warmstart_save_state(const char* path);
+size_t warmstart_load_state(const char* path);
+bool warmstart_backfill_step();
+void warmstart_backfill_cancel();
+
+#endif // WARMSTART_H